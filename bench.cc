@@ -0,0 +1,1502 @@
+#include "result.h"
+#include "result_any_error.h"
+#include "result_cache.h"
+#include "result_context.h"
+#include "result_coroutine.h"
+#include "result_future.h"
+#include "result_io.h"
+#include "result_one_of.h"
+#include "result_parallel.h"
+#include "result_vector.h"
+#include "result_views.h"
+#include "result_wire.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <optional>
+#include <variant>
+#endif
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+#if defined(__cpp_lib_expected)
+#include <expected>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define RESULT_CODE_BENCH_MMAP 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE
+#endif
+
+// Counts heap allocations of the whole binary, operator new of libstdc++ ends up here as well
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define RESULT_CODE_BENCH_COUNT_MALLOC 1
+extern "C" void* __libc_malloc(size_t size);
+
+static std::atomic<size_t> malloc_count{0};
+
+extern "C" void* malloc(size_t size)
+{
+    malloc_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+#endif
+
+namespace
+{
+enum class StageError { Negative, TooBig, Zero, Empty };
+
+using Number = Result::Expected<int, StageError>;
+using Text = Result::Expected<std::string, StageError>;
+
+// Inputs with roughly one failing value out of eight, so both branches are taken
+std::vector<int> make_inputs(size_t count)
+{
+    std::vector<int> inputs(count);
+    for (size_t idx = 0; idx < count; ++idx)
+        inputs[idx] = static_cast<int>(idx * 7919U % 1000U) - 125;
+    return inputs;
+}
+
+Number check_positive(int val)
+{
+    if (val < 0)
+        return Result::Error(StageError::Negative);
+    return Result::Ok(val);
+}
+
+Number halve(int val) { return Result::Ok(val / 2); }
+
+Number check_range(int val)
+{
+    if (val > 400)
+        return Result::Error(StageError::TooBig);
+    return Result::Ok(val);
+}
+
+Number add_offset(int val) { return Result::Ok(val + 3); }
+
+Number check_nonzero(int val)
+{
+    if (val == 0)
+        return Result::Error(StageError::Zero);
+    return Result::Ok(val);
+}
+
+Number manual_chain(int val)
+{
+    auto first = check_positive(val);
+    if (!first)
+        return Result::Error(first.error());
+    auto second = halve(first.value());
+    if (!second)
+        return Result::Error(second.error());
+    auto third = check_range(second.value());
+    if (!third)
+        return Result::Error(third.error());
+    auto fourth = add_offset(third.value());
+    if (!fourth)
+        return Result::Error(fourth.error());
+    return check_nonzero(fourth.value());
+}
+
+Number combinator_chain(int val)
+{
+    return check_positive(val)
+        .and_then(halve)
+        .and_then(check_range)
+        .and_then(add_offset)
+        .and_then(check_nonzero);
+}
+
+Text to_text(int val)
+{
+    if (val < 0)
+        return Result::Error(StageError::Negative);
+    return Result::Ok(std::string(48, static_cast<char>('a' + val % 26)));
+}
+
+Text check_not_empty(std::string&& text)
+{
+    if (text.empty())
+        return Result::Error(StageError::Empty);
+    return Result::Ok(std::move(text));
+}
+
+Text append_suffix(std::string&& text)
+{
+    text += "-suffix";
+    return Result::Ok(std::move(text));
+}
+
+Text uppercase_first(std::string&& text)
+{
+    text[0] = static_cast<char>(text[0] - 'a' + 'A');
+    return Result::Ok(std::move(text));
+}
+
+Text check_length(std::string&& text)
+{
+    if (text.size() > 100)
+        return Result::Error(StageError::TooBig);
+    return Result::Ok(std::move(text));
+}
+
+Text manual_text_chain(int val)
+{
+    auto first = to_text(val);
+    if (!first)
+        return Result::Error(first.error());
+    auto second = check_not_empty(first.move_ok());
+    if (!second)
+        return Result::Error(second.error());
+    auto third = append_suffix(second.move_ok());
+    if (!third)
+        return Result::Error(third.error());
+    auto fourth = uppercase_first(third.move_ok());
+    if (!fourth)
+        return Result::Error(fourth.error());
+    return check_length(fourth.move_ok());
+}
+
+Text combinator_text_chain(int val)
+{
+    return to_text(val)
+        .and_then(check_not_empty)
+        .and_then(append_suffix)
+        .and_then(uppercase_first)
+        .and_then(check_length);
+}
+
+template <Number (*Chain)(int)>
+void BM_NumberChain(benchmark::State& state)
+{
+    const auto inputs = make_inputs(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        for (int val : inputs) {
+            // Keep every call opaque, otherwise the loop gets vectorized and measures something else
+            benchmark::DoNotOptimize(val);
+            auto res = Chain(val);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <Text (*Chain)(int)>
+void BM_TextChain(benchmark::State& state)
+{
+    const auto inputs = make_inputs(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        for (int val : inputs) {
+            benchmark::DoNotOptimize(val);
+            auto res = Chain(val);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+struct Row {
+    uint32_t id;
+    float score;
+};
+
+using RowResult = Result::Expected<Row, StageError>;
+
+// Bulk ingest batch with one failed row out of 1024
+template <typename Container>
+Container make_rows(size_t count)
+{
+    Container rows;
+    rows.reserve(count);
+    for (size_t idx = 0; idx < count; ++idx) {
+        if (idx % 1024 == 1000)
+            rows.push_back(Result::Error(StageError::Zero));
+        else
+            rows.push_back(Result::Ok(Row{static_cast<uint32_t>(idx), static_cast<float>(idx % 100)}));
+    }
+    return rows;
+}
+
+void BM_ScanExpectedVector(benchmark::State& state)
+{
+    const auto rows = make_rows<std::vector<RowResult>>(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        float sum = 0;
+        size_t failed = 0;
+        for (const auto& row : rows) {
+            if (const Row* ok = row.value_ptr())
+                sum += ok->score;
+            else
+                ++failed;
+        }
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(failed);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ScanResultVector(benchmark::State& state)
+{
+    const auto rows = make_rows<Result::ResultVector<Row, StageError>>(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        float sum = 0;
+        for (const auto& row : rows.values())
+            sum += row.score;
+        size_t failed = rows.count_error();
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(failed);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ErrorIndicesExpectedVector(benchmark::State& state)
+{
+    const auto rows = make_rows<std::vector<RowResult>>(static_cast<size_t>(state.range(0)));
+    std::vector<size_t> failed;
+    for (auto _ : state) {
+        failed.clear();
+        for (size_t idx = 0; idx < rows.size(); ++idx) {
+            if (!rows[idx])
+                failed.push_back(idx);
+        }
+        benchmark::DoNotOptimize(failed.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ErrorIndicesResultVector(benchmark::State& state)
+{
+    const auto rows = make_rows<Result::ResultVector<Row, StageError>>(static_cast<size_t>(state.range(0)));
+    std::vector<size_t> failed;
+    for (auto _ : state) {
+        failed.clear();
+        for (size_t idx : rows.error_indices())
+            failed.push_back(idx);
+        benchmark::DoNotOptimize(failed.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_FirstErrorExpectedVector(benchmark::State& state)
+{
+    const auto rows = make_rows<std::vector<RowResult>>(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto it = std::find_if(rows.begin(), rows.end(), [](const RowResult& row) { return !row; });
+        benchmark::DoNotOptimize(it);
+    }
+}
+
+void BM_FirstErrorResultVector(benchmark::State& state)
+{
+    const auto rows = make_rows<Result::ResultVector<Row, StageError>>(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        size_t idx = rows.first_error();
+        benchmark::DoNotOptimize(idx);
+    }
+}
+
+// Validation heavy enough that threads pay off, fails only for negative input
+Number validate_record(int val)
+{
+    unsigned hash = static_cast<unsigned>(val);
+    for (int round = 0; round < 64; ++round)
+        hash = hash * 2654435761U + 0x9E3779B9U;
+    if (val < 0)
+        return Result::Error(StageError::Negative);
+    return Result::Ok(static_cast<int>(hash >> 1));
+}
+
+void BM_ParallelTryTransform(benchmark::State& state)
+{
+    std::vector<int> inputs(1 << 20);
+    for (size_t idx = 0; idx < inputs.size(); ++idx)
+        inputs[idx] = static_cast<int>(idx);
+    // Second argument places one failure in the middle, so cancellation is measured too
+    if (state.range(1) != 0)
+        inputs[inputs.size() / 2] = -1;
+    std::vector<int> outputs(inputs.size());
+    const auto threads = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        auto res = Result::par_try_transform(inputs.begin(), inputs.end(), outputs.begin(), validate_record, threads);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(inputs.size()));
+}
+
+void ThreadCounts(benchmark::internal::Benchmark* bench)
+{
+    const int cores = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U));
+    for (int failing = 0; failing < 2; ++failing) {
+        for (int threads = 1; threads <= cores; threads *= 2)
+            bench->Args({threads, failing});
+        if ((cores & (cores - 1)) != 0)
+            bench->Args({cores, failing});
+    }
+}
+
+// Failure path comparison: leaf constructs payload or fails, middle layer propagates, top checks and consumes.
+// Leaf and middle are never inlined, like calls across translation units.
+struct Blob {
+    unsigned char bytes[256];
+};
+
+template <typename P>
+P make_payload(int seed);
+
+template <>
+int make_payload<int>(int seed)
+{
+    return seed;
+}
+
+template <>
+std::string make_payload<std::string>(int seed)
+{
+    return std::string(40, static_cast<char>('a' + seed % 26));
+}
+
+template <>
+Blob make_payload<Blob>(int seed)
+{
+    Blob blob;
+    std::memset(blob.bytes, seed & 0xFF, sizeof(blob.bytes));
+    return blob;
+}
+
+size_t weight(int val) { return static_cast<size_t>(val); }
+size_t weight(const std::string& val) { return val.size(); }
+size_t weight(const Blob& val) { return val.bytes[255]; }
+
+// Failure flags for a rate in percent, shuffled with fixed seed so the branch is not trivially predicted
+std::vector<char> make_failures(int64_t rate)
+{
+    std::vector<char> flags(1000);
+    for (size_t idx = 0; idx < flags.size(); ++idx)
+        flags[idx] = static_cast<int64_t>(idx) < rate * 10 ? 1 : 0;
+    std::shuffle(flags.begin(), flags.end(), std::mt19937(42));
+    return flags;
+}
+
+enum class FailCode { Failed = 1 };
+
+template <typename P>
+BENCH_NOINLINE Result::Expected<P, FailCode> expected_leaf(bool fail, int seed)
+{
+    if (fail)
+        return Result::Error(FailCode::Failed);
+    return Result::Ok(make_payload<P>(seed));
+}
+
+template <typename P>
+BENCH_NOINLINE Result::Expected<P, FailCode> expected_mid(bool fail, int seed)
+{
+    auto res = expected_leaf<P>(fail, seed);
+    if (!res)
+        return Result::Error(res.error());
+    return res;
+}
+
+template <typename P>
+void BM_PropagateExpected(benchmark::State& state)
+{
+    const auto failures = make_failures(state.range(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx) {
+            auto res = expected_mid<P>(failures[idx] != 0, static_cast<int>(idx));
+            total += res ? weight(res.value()) : 1;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+
+template <typename P>
+BENCH_NOINLINE Result::Expected<P, FailCode> try_mid(bool fail, int seed)
+{
+    RESULT_TRY_ASSIGN(P res, expected_leaf<P>(fail, seed));
+    return Result::Ok(std::move(res));
+}
+
+template <typename P>
+void BM_PropagateTry(benchmark::State& state)
+{
+    const auto failures = make_failures(state.range(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx) {
+            auto res = try_mid<P>(failures[idx] != 0, static_cast<int>(idx));
+            total += res ? weight(res.value()) : 1;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+
+#if defined(RESULT_HAS_COROUTINES)
+// Middle layer as a coroutine, its frame comes from the thread local pool unless compiler elides it
+template <typename P>
+BENCH_NOINLINE Result::Expected<P, FailCode> coroutine_mid(bool fail, int seed)
+{
+    co_return Result::Ok(co_await expected_leaf<P>(fail, seed));
+}
+
+template <typename P>
+void BM_PropagateCoroutine(benchmark::State& state)
+{
+    const auto failures = make_failures(state.range(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx) {
+            auto res = coroutine_mid<P>(failures[idx] != 0, static_cast<int>(idx));
+            total += res ? weight(res.value()) : 1;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+
+struct HeapFrameAllocator : Result::FrameAllocator {
+    void* allocate(size_t size) override { return ::operator new(size); }
+    void deallocate(void* ptr, size_t size) noexcept override { ::operator delete(ptr, size); }
+};
+
+// Same with every frame taken from the global heap, shows what the pool saves
+template <typename P>
+void BM_PropagateCoroutineHeap(benchmark::State& state)
+{
+    HeapFrameAllocator heap;
+    Result::ScopedFrameAllocator scope(heap);
+    BM_PropagateCoroutine<P>(state);
+}
+#endif
+
+#if defined(__cpp_exceptions)
+struct LeafFailure {
+    FailCode code;
+};
+
+template <typename P>
+BENCH_NOINLINE P throwing_leaf(bool fail, int seed)
+{
+    if (fail)
+        throw LeafFailure{FailCode::Failed};
+    return make_payload<P>(seed);
+}
+
+template <typename P>
+BENCH_NOINLINE P throwing_mid(bool fail, int seed)
+{
+    return throwing_leaf<P>(fail, seed);
+}
+
+template <typename P>
+void BM_PropagateException(benchmark::State& state)
+{
+    const auto failures = make_failures(state.range(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx) {
+            try {
+                auto val = throwing_mid<P>(failures[idx] != 0, static_cast<int>(idx));
+                total += weight(val);
+            } catch (const LeafFailure&) {
+                total += 1;
+            }
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+#endif
+
+template <typename P>
+BENCH_NOINLINE int code_leaf(bool fail, int seed, P& out)
+{
+    if (fail)
+        return static_cast<int>(FailCode::Failed);
+    out = make_payload<P>(seed);
+    return 0;
+}
+
+template <typename P>
+BENCH_NOINLINE int code_mid(bool fail, int seed, P& out)
+{
+    if (int err = code_leaf<P>(fail, seed, out))
+        return err;
+    return 0;
+}
+
+template <typename P>
+void BM_PropagateErrorCode(benchmark::State& state)
+{
+    const auto failures = make_failures(state.range(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx) {
+            P val{};
+            total += code_mid<P>(failures[idx] != 0, static_cast<int>(idx), val) == 0 ? weight(val) : 1;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+
+#if __cplusplus >= 201703L
+template <typename P>
+BENCH_NOINLINE std::optional<P> optional_leaf(bool fail, int seed)
+{
+    if (fail)
+        return std::nullopt;
+    return make_payload<P>(seed);
+}
+
+template <typename P>
+BENCH_NOINLINE std::optional<P> optional_mid(bool fail, int seed)
+{
+    auto res = optional_leaf<P>(fail, seed);
+    if (!res)
+        return std::nullopt;
+    return res;
+}
+
+template <typename P>
+void BM_PropagateOptional(benchmark::State& state)
+{
+    const auto failures = make_failures(state.range(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx) {
+            auto res = optional_mid<P>(failures[idx] != 0, static_cast<int>(idx));
+            total += res ? weight(*res) : 1;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+#endif
+
+#if defined(__cpp_lib_expected)
+template <typename P>
+BENCH_NOINLINE std::expected<P, FailCode> std_expected_leaf(bool fail, int seed)
+{
+    if (fail)
+        return std::unexpected(FailCode::Failed);
+    return make_payload<P>(seed);
+}
+
+template <typename P>
+BENCH_NOINLINE std::expected<P, FailCode> std_expected_mid(bool fail, int seed)
+{
+    auto res = std_expected_leaf<P>(fail, seed);
+    if (!res)
+        return std::unexpected(res.error());
+    return res;
+}
+
+template <typename P>
+void BM_PropagateStdExpected(benchmark::State& state)
+{
+    const auto failures = make_failures(state.range(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx) {
+            auto res = std_expected_mid<P>(failures[idx] != 0, static_cast<int>(idx));
+            total += res ? weight(*res) : 1;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+#endif
+
+// Error context added by three layers, chain in thread arena against message strings built on the way up
+BENCH_NOINLINE Result::Expected<int, FailCode> context_leaf(bool fail, int seed)
+{
+    if (fail)
+        return Result::Error(FailCode::Failed);
+    return Result::Ok(seed);
+}
+
+BENCH_NOINLINE Result::Expected<int, Result::Contextual<FailCode>> context_mid(bool fail, int seed)
+{
+    return context_leaf(fail, seed).transform_error(RESULT_CONTEXT("reading row"));
+}
+
+BENCH_NOINLINE Result::Expected<int, Result::Contextual<FailCode>> context_top(bool fail, int seed)
+{
+    return context_mid(fail, seed)
+        .transform_error(RESULT_CONTEXT("loading user"))
+        .transform_error(RESULT_CONTEXT("handling request"));
+}
+
+BENCH_NOINLINE Result::Expected<int, std::string> message_leaf(bool fail, int seed)
+{
+    if (fail)
+        return Result::Error(std::string("row not found"));
+    return Result::Ok(seed);
+}
+
+BENCH_NOINLINE Result::Expected<int, std::string> message_mid(bool fail, int seed)
+{
+    return message_leaf(fail, seed).transform_error([](std::string&& err) { return "reading row: " + err; });
+}
+
+BENCH_NOINLINE Result::Expected<int, std::string> message_top(bool fail, int seed)
+{
+    return message_mid(fail, seed)
+        .transform_error([](std::string&& err) { return "loading user: " + err; })
+        .transform_error([](std::string&& err) { return "handling request: " + err; });
+}
+
+template <typename F>
+void run_context(benchmark::State& state, F&& call)
+{
+    const auto failures = make_failures(state.range(0));
+#if defined(RESULT_CODE_BENCH_COUNT_MALLOC)
+    const size_t mallocs = malloc_count.load();
+#endif
+    for (auto _ : state) {
+        // one request per batch, its frames are reclaimed at once
+        Result::ContextScope request;
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx)
+            total += call(failures[idx] != 0, static_cast<int>(idx));
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+#if defined(RESULT_CODE_BENCH_COUNT_MALLOC)
+    state.counters["mallocs_per_item"] = static_cast<double>(malloc_count.load() - mallocs) /
+                                         static_cast<double>(state.iterations()) / static_cast<double>(failures.size());
+#endif
+}
+
+void BM_ErrorContextArena(benchmark::State& state)
+{
+    run_context(state, [](bool fail, int seed) -> size_t {
+        auto res = context_top(fail, seed);
+        return res ? static_cast<size_t>(res.value()) : res.error().context.depth();
+    });
+}
+
+void BM_ErrorContextString(benchmark::State& state)
+{
+    run_context(state, [](bool fail, int seed) -> size_t {
+        auto res = message_top(fail, seed);
+        return res ? static_cast<size_t>(res.value()) : res.error().size();
+    });
+}
+
+// Module boundary: error of a lower layer is widened to the error type of module API and inspected by caller
+enum class DbErrc { Timeout = 1, Constraint };
+enum class NetErrc { Refused = 1, Reset };
+
+struct DbCategory : std::error_category {
+    const char* name() const noexcept override { return "db"; }
+    std::string message(int code) const override { return code == 1 ? "timeout" : "constraint"; }
+};
+
+std::error_code make_error_code(DbErrc err)
+{
+    static const DbCategory category;
+    return std::error_code(static_cast<int>(err), category);
+}
+
+BENCH_NOINLINE Result::Expected<int, DbErrc> db_layer(bool fail, int seed)
+{
+    if (fail)
+        return Result::Error((seed & 1) != 0 ? DbErrc::Timeout : DbErrc::Constraint);
+    return Result::Ok(seed);
+}
+
+BENCH_NOINLINE Result::Expected<int, Result::AnyError> any_error_boundary(bool fail, int seed)
+{
+    auto res = db_layer(fail, seed);
+    if (!res)
+        return Result::Error(res.error());
+    return Result::Ok(res.value());
+}
+
+BENCH_NOINLINE Result::Expected<int, std::error_code> error_code_boundary(bool fail, int seed)
+{
+    auto res = db_layer(fail, seed);
+    if (!res)
+        return Result::Error(make_error_code(res.error()));
+    return Result::Ok(res.value());
+}
+
+template <typename F>
+void run_boundary(benchmark::State& state, F&& call)
+{
+    const auto failures = make_failures(state.range(0));
+    for (auto _ : state) {
+        size_t total = 0;
+        for (size_t idx = 0; idx < failures.size(); ++idx)
+            total += call(failures[idx] != 0, static_cast<int>(idx));
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+
+void BM_BoundaryAnyError(benchmark::State& state)
+{
+    run_boundary(state, [](bool fail, int seed) -> size_t {
+        auto res = any_error_boundary(fail, seed);
+        if (res)
+            return static_cast<size_t>(res.value());
+        const DbErrc* err = res.error().get_if<DbErrc>();
+        return err != nullptr && *err == DbErrc::Timeout ? 2 : 1;
+    });
+}
+
+void BM_BoundaryErrorCode(benchmark::State& state)
+{
+    run_boundary(state, [](bool fail, int seed) -> size_t {
+        auto res = error_code_boundary(fail, seed);
+        if (res)
+            return static_cast<size_t>(res.value());
+        return res.error() == make_error_code(DbErrc::Timeout) ? 2 : 1;
+    });
+}
+
+#if __cplusplus >= 201703L
+using LayerVariant = std::variant<DbErrc, NetErrc>;
+
+BENCH_NOINLINE Result::Expected<int, LayerVariant> variant_boundary(bool fail, int seed)
+{
+    auto res = db_layer(fail, seed);
+    if (!res)
+        return Result::Error(LayerVariant(res.error()));
+    return Result::Ok(res.value());
+}
+
+void BM_BoundaryVariant(benchmark::State& state)
+{
+    run_boundary(state, [](bool fail, int seed) -> size_t {
+        auto res = variant_boundary(fail, seed);
+        if (res)
+            return static_cast<size_t>(res.value());
+        const DbErrc* err = std::get_if<DbErrc>(&res.error());
+        return err != nullptr && *err == DbErrc::Timeout ? 2 : 1;
+    });
+}
+#endif
+
+// Store error translated to API error on its way up: RESULT_MAP_ERRORS table against hand written switch
+enum class StoreErrc { Timeout, Constraint, Deadlock, Corrupt, Full, Locked, Missing, Denied };
+enum class ApiErrc { Unavailable, BadRequest, Conflict, Internal, NotFound, Forbidden };
+}  // namespace
+
+RESULT_MAP_ERRORS(StoreErrc, ApiErrc,
+                  {{StoreErrc::Timeout, ApiErrc::Unavailable},
+                   {StoreErrc::Constraint, ApiErrc::BadRequest},
+                   {StoreErrc::Deadlock, ApiErrc::Conflict},
+                   {StoreErrc::Corrupt, ApiErrc::Internal},
+                   {StoreErrc::Full, ApiErrc::Unavailable},
+                   {StoreErrc::Locked, ApiErrc::Conflict},
+                   {StoreErrc::Missing, ApiErrc::NotFound},
+                   {StoreErrc::Denied, ApiErrc::Forbidden}});
+
+namespace
+{
+ApiErrc to_api_error(StoreErrc err)
+{
+    switch (err) {
+    case StoreErrc::Timeout:
+        return ApiErrc::Unavailable;
+    case StoreErrc::Constraint:
+        return ApiErrc::BadRequest;
+    case StoreErrc::Deadlock:
+        return ApiErrc::Conflict;
+    case StoreErrc::Corrupt:
+        return ApiErrc::Internal;
+    case StoreErrc::Full:
+        return ApiErrc::Unavailable;
+    case StoreErrc::Locked:
+        return ApiErrc::Conflict;
+    case StoreErrc::Missing:
+        return ApiErrc::NotFound;
+    case StoreErrc::Denied:
+        return ApiErrc::Forbidden;
+    }
+    return ApiErrc::Internal;
+}
+
+BENCH_NOINLINE Result::Expected<int, StoreErrc> store_layer(bool fail, int seed)
+{
+    if (fail)
+        return Result::Error(static_cast<StoreErrc>(seed & 7));
+    return Result::Ok(seed);
+}
+
+BENCH_NOINLINE Result::Expected<int, ApiErrc> switch_api(bool fail, int seed)
+{
+    auto res = store_layer(fail, seed);
+    if (!res)
+        return Result::Error(to_api_error(res.error()));
+    return Result::Ok(res.value());
+}
+
+BENCH_NOINLINE Result::Expected<int, ApiErrc> table_api(bool fail, int seed)
+{
+    auto res = store_layer(fail, seed);
+    if (!res)
+        return Result::Error(res.error());
+    return Result::Ok(res.value());
+}
+
+template <Result::Expected<int, ApiErrc> (*Api)(bool, int)>
+void BM_MapError(benchmark::State& state)
+{
+    run_boundary(state, [](bool fail, int seed) -> size_t {
+        auto res = Api(fail, seed);
+        return res ? static_cast<size_t>(res.value()) : static_cast<size_t>(res.error());
+    });
+}
+
+// Results sent to a consumer thread through a ring of slots in a shared mapping: encoded and read in place with
+// ExpectedView against hand serialized state byte and payload copied back into Expected
+struct Quote {
+    uint64_t id;
+    double price;
+    uint32_t qty;
+};
+enum class FeedError : uint32_t { Stale = 1 };
+using QuoteResult = Result::Expected<Quote, FeedError>;
+
+struct SharedRing {
+    static constexpr size_t slots = 1024;
+    static constexpr size_t slot_size = 64;
+    static_assert(Result::wire_size<Quote, FeedError>() <= slot_size, "");
+
+    struct Control {
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+        alignas(64) std::atomic<bool> stop;
+    };
+
+    SharedRing()
+    {
+        const size_t bytes = sizeof(Control) + slots * slot_size;
+#if defined(RESULT_CODE_BENCH_MMAP)
+        void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        _mapping = mem == MAP_FAILED ? nullptr : static_cast<unsigned char*>(mem);
+#else
+        _mapping = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(64)));
+#endif
+        _control = new (_mapping) Control{{0}, {0}, {false}};
+    }
+
+    SharedRing(const SharedRing&) = delete;
+    SharedRing& operator=(const SharedRing&) = delete;
+
+    ~SharedRing()
+    {
+#if defined(RESULT_CODE_BENCH_MMAP)
+        munmap(_mapping, sizeof(Control) + slots * slot_size);
+#else
+        ::operator delete(_mapping, std::align_val_t(64));
+#endif
+    }
+
+    unsigned char* slot(size_t seq) noexcept { return _mapping + sizeof(Control) + seq % slots * slot_size; }
+    Control& control() noexcept { return *_control; }
+
+private:
+    unsigned char* _mapping;
+    Control* _control;
+};
+
+template <typename Write, typename Read>
+void run_ring(benchmark::State& state, Write&& write, Read&& read)
+{
+    const auto failures = make_failures(state.range(0));
+    SharedRing ring;
+    SharedRing::Control& ctl = ring.control();
+    std::atomic<size_t> total{0};
+    std::thread consumer([&] {
+        size_t seq = 0;
+        size_t sum = 0;
+        while (!ctl.stop.load(std::memory_order_acquire)) {
+            const size_t head = ctl.head.load(std::memory_order_acquire);
+            if (head == seq) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (; seq < head; ++seq)
+                sum += read(ring.slot(seq));
+            ctl.tail.store(seq, std::memory_order_release);
+        }
+        total.store(sum);
+    });
+    size_t seq = 0;
+    for (auto _ : state) {
+        for (size_t idx = 0; idx < failures.size(); ++idx, ++seq) {
+            while (seq - ctl.tail.load(std::memory_order_acquire) >= SharedRing::slots)
+                std::this_thread::yield();
+            const QuoteResult res = failures[idx] != 0 ? QuoteResult(Result::Error(FeedError::Stale))
+                                                       : QuoteResult(Result::Ok(Quote{idx, 1.5, 10}));
+            write(res, ring.slot(seq));
+            ctl.head.store(seq + 1, std::memory_order_release);
+        }
+        while (ctl.tail.load(std::memory_order_acquire) != seq)
+            std::this_thread::yield();
+    }
+    ctl.stop.store(true, std::memory_order_release);
+    consumer.join();
+    benchmark::DoNotOptimize(total.load());
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(failures.size()));
+}
+
+void BM_RingWireView(benchmark::State& state)
+{
+    run_ring(
+        state,
+        [](const QuoteResult& res, unsigned char* slot) {
+            Result::encode(res, slot, SharedRing::slot_size);
+        },
+        [](const unsigned char* slot) -> size_t {
+            const auto view = Result::ExpectedView<Quote, FeedError>::from(slot, SharedRing::slot_size);
+            if (!view)
+                return 0;
+            return view.value() ? static_cast<size_t>(view.value().value().id) : 1;
+        });
+}
+
+void BM_RingHandSerialized(benchmark::State& state)
+{
+    run_ring(
+        state,
+        [](const QuoteResult& res, unsigned char* slot) {
+            const Quote* quote = res.value_ptr();
+            slot[0] = quote != nullptr ? 1 : 0;
+            if (quote != nullptr)
+                std::memcpy(slot + 8, quote, sizeof(Quote));
+            else if (const FeedError* err = res.error_ptr())
+                std::memcpy(slot + 8, err, sizeof(FeedError));
+        },
+        [](const unsigned char* slot) -> size_t {
+            QuoteResult res = Result::Error(FeedError::Stale);
+            if (slot[0] != 0) {
+                Quote quote;
+                std::memcpy(&quote, slot + 8, sizeof(quote));
+                res = Result::Ok(quote);
+            }
+            return res ? static_cast<size_t>(res.value().id) : 1;
+        });
+}
+
+using PingResult = Result::Expected<size_t, FailCode>;
+
+struct ResultChannel {
+    using promise_t = Result::Promise<size_t, FailCode>;
+    using future_t = Result::Future<size_t, FailCode>;
+
+    static void send(promise_t& promise, PingResult res) { promise.set(std::move(res)); }
+    static PingResult receive(future_t& future) { return future.get(); }
+};
+
+struct StdChannel {
+    using promise_t = std::promise<PingResult>;
+    using future_t = std::future<PingResult>;
+
+    static void send(promise_t& promise, PingResult res) { promise.set_value(std::move(res)); }
+    static PingResult receive(future_t& future) { return future.get(); }
+};
+
+// Round trips between two threads, every message is a fresh promise and future pair (both allocate shared state).
+// Pairs of a batch are made before the echo thread starts, so it never waits for them.
+template <typename Channel>
+void BM_PingPong(benchmark::State& state)
+{
+    constexpr size_t rounds = 512;
+    size_t sum = 0;
+    for (auto _ : state) {
+        std::vector<typename Channel::promise_t> pings(rounds);
+        std::vector<typename Channel::promise_t> pongs(rounds);
+        std::vector<typename Channel::future_t> ping_futures;
+        std::vector<typename Channel::future_t> pong_futures;
+        ping_futures.reserve(rounds);
+        pong_futures.reserve(rounds);
+        for (size_t idx = 0; idx < rounds; ++idx) {
+            ping_futures.push_back(pings[idx].get_future());
+            pong_futures.push_back(pongs[idx].get_future());
+        }
+        std::thread echo([&] {
+            for (size_t idx = 0; idx < rounds; ++idx)
+                Channel::send(pongs[idx], Channel::receive(ping_futures[idx]));
+        });
+        for (size_t idx = 0; idx < rounds; ++idx) {
+            Channel::send(pings[idx], PingResult(Result::Ok(idx)));
+            sum += Channel::receive(pong_futures[idx]).value_or(0);
+        }
+        echo.join();
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(rounds));
+}
+
+enum class LookupErrc { Database, NoUser };
+using UserIdCache = Result::ExpectedCache<uint32_t, int, LookupErrc>;
+
+// Backend behind one connection, every second user does not exist
+BENCH_NOINLINE Result::Expected<int, LookupErrc> backend_user_id(uint32_t key)
+{
+    static std::mutex connection;
+    std::lock_guard<std::mutex> lock(connection);
+    uint32_t hash = key;
+    for (int round = 0; round < 256; ++round)
+        hash = hash * 2654435761U + 1;
+    benchmark::DoNotOptimize(hash);
+    if (key % 2 != 0)
+        return Result::Error(LookupErrc::NoUser);
+    return Result::Ok(static_cast<int>(key));
+}
+
+// Threads look up random keys out of 4096, warm cache answers hits and misses without the backend
+template <typename Lookup>
+void run_lookups(benchmark::State& state, Lookup&& lookup)
+{
+    std::mt19937 gen(static_cast<uint32_t>(state.thread_index()));
+    std::uniform_int_distribution<uint32_t> keys(0, 4095);
+    size_t found = 0;
+    for (auto _ : state) {
+        auto res = lookup(keys(gen));
+        if (res.is_ok())
+            ++found;
+    }
+    benchmark::DoNotOptimize(found);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LookupCached(benchmark::State& state)
+{
+    static UserIdCache cache(backend_user_id);
+    run_lookups(state, [](uint32_t key) { return cache.get(key); });
+}
+
+void BM_LookupCachedValuesOnly(benchmark::State& state)
+{
+    static UserIdCache cache(backend_user_id, [] {
+        UserIdCache::Options options;
+        options.cache_error = [](LookupErrc) { return false; };
+        return options;
+    }());
+    run_lookups(state, [](uint32_t key) { return cache.get(key); });
+}
+
+void BM_LookupUncached(benchmark::State& state) { run_lookups(state, backend_user_id); }
+
+#if __cplusplus >= 201703L
+// Operation failing with error of one of three layers: value and errors in one union with one index byte, against
+// std::variant of errors nested in Expected (second discriminant) and flat std::variant of value and errors
+using MultiOneOf = Result::Expected<uint32_t, Result::OneOf<DbErrc, NetErrc, StoreErrc>>;
+using MultiNested = Result::Expected<uint32_t, std::variant<DbErrc, NetErrc, StoreErrc>>;
+using MultiFlat = std::variant<uint32_t, DbErrc, NetErrc, StoreErrc>;
+
+template <typename... Fs>
+struct Overloaded : Fs... {
+    using Fs::operator()...;
+};
+template <typename... Fs>
+Overloaded(Fs...) -> Overloaded<Fs...>;
+
+template <typename Res, typename Err>
+Res multi_failure(Err err)
+{
+    if constexpr (std::is_same<Res, MultiFlat>::value)
+        return Res(err);
+    else if constexpr (std::is_same<Res, MultiNested>::value)
+        return Result::Error(typename Res::err_t(err));
+    else
+        return Result::Error(err);
+}
+
+template <typename Res>
+BENCH_NOINLINE Res multi_layer(bool fail, int seed)
+{
+    if (!fail)
+        return Res(static_cast<uint32_t>(seed));
+    switch (seed % 3) {
+    case 0:
+        return multi_failure<Res>(DbErrc::Timeout);
+    case 1:
+        return multi_failure<Res>(NetErrc::Reset);
+    default:
+        return multi_failure<Res>(StoreErrc::Deadlock);
+    }
+}
+
+const auto multi_handlers = Overloaded{[](uint32_t val) -> size_t { return val; },
+                                       [](DbErrc err) -> size_t { return static_cast<size_t>(err) + 1; },
+                                       [](NetErrc err) -> size_t { return static_cast<size_t>(err) + 2; },
+                                       [](StoreErrc err) -> size_t { return static_cast<size_t>(err) + 3; }};
+
+void BM_MultiErrorOneOf(benchmark::State& state)
+{
+    run_boundary(state, [](bool fail, int seed) -> size_t {
+        return multi_layer<MultiOneOf>(fail, seed).visit(multi_handlers, multi_handlers);
+    });
+    state.counters["bytes"] = sizeof(MultiOneOf);
+}
+
+void BM_MultiErrorNestedVariant(benchmark::State& state)
+{
+    run_boundary(state, [](bool fail, int seed) -> size_t {
+        auto res = multi_layer<MultiNested>(fail, seed);
+        if (res)
+            return res.value();
+        return std::visit(multi_handlers, res.error());
+    });
+    state.counters["bytes"] = sizeof(MultiNested);
+}
+
+void BM_MultiErrorFlatVariant(benchmark::State& state)
+{
+    run_boundary(state, [](bool fail, int seed) -> size_t {
+        return std::visit(multi_handlers, multi_layer<MultiFlat>(fail, seed));
+    });
+    state.counters["bytes"] = sizeof(MultiFlat);
+}
+#endif
+
+#if defined(RESULT_HAS_RANGES)
+enum class LineEnd { Eof };
+
+enum class ParseFail { NotNumber };
+
+// 1 GiB of numbered lines in memory, every 64th one is not a number
+const std::string& line_input()
+{
+    static const std::string text = [] {
+        const size_t size = size_t(1) << 30;
+        const size_t line_len = 21;
+        std::string out;
+        out.reserve(size);
+        char line[32];
+        for (unsigned long long i = 0; out.size() + line_len <= size; ++i) {
+            if (i % 64 == 63)
+                std::snprintf(line, sizeof(line), "%019llux\n", i);
+            else
+                std::snprintf(line, sizeof(line), "%020llu\n", i);
+            out.append(line, line_len);
+        }
+        return out;
+    }();
+    return text;
+}
+
+struct LineSource {
+    // Copied, like a line read from a file
+    Result::Expected<std::string, LineEnd> read_line()
+    {
+        if (_pos >= _text.size())
+            return Result::Error(LineEnd::Eof);
+        const size_t end = _text.find('\n', _pos);
+        std::string line = _text.substr(_pos, end - _pos);
+        _pos = end + 1;
+        return Result::Ok(std::move(line));
+    }
+
+    const std::string& _text;
+    size_t _pos;
+};
+
+Result::Expected<uint64_t, ParseFail> parse_number(const std::string& line)
+{
+    uint64_t val = 0;
+    for (char ch : line) {
+        if (ch < '0' || ch > '9')
+            return Result::Error(ParseFail::NotNumber);
+        val = val * 10 + static_cast<uint64_t>(ch - '0');
+    }
+    return Result::Ok(val);
+}
+
+void BM_LinesLoop(benchmark::State& state)
+{
+    const std::string& text = line_input();
+    for (auto _ : state) {
+        LineSource src{text, 0};
+        uint64_t sum = 0;
+        size_t bad = 0;
+        while (true) {
+            auto line = src.read_line();
+            if (!line)
+                break;
+            auto num = parse_number(line.value());
+            if (num)
+                sum += num.value();
+            else
+                ++bad;
+        }
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(bad);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+
+void BM_LinesViews(benchmark::State& state)
+{
+    const std::string& text = line_input();
+    for (auto _ : state) {
+        LineSource src{text, 0};
+        uint64_t sum = 0;
+        auto numbers = Result::views::generate_until_error([&src] { return src.read_line(); }) |
+                       std::views::transform(parse_number) | Result::views::filter_ok;
+        for (uint64_t num : numbers)
+            sum += num;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+
+// Stops at the first malformed line, so both versions read 63 lines
+void BM_LinesLoopUntilError(benchmark::State& state)
+{
+    const std::string& text = line_input();
+    for (auto _ : state) {
+        LineSource src{text, 0};
+        uint64_t sum = 0;
+        while (true) {
+            auto line = src.read_line();
+            if (!line)
+                break;
+            auto num = parse_number(line.value());
+            if (!num)
+                break;
+            sum += num.value();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+void BM_LinesViewsUntilError(benchmark::State& state)
+{
+    const std::string& text = line_input();
+    for (auto _ : state) {
+        LineSource src{text, 0};
+        uint64_t sum = 0;
+        auto numbers = Result::views::generate_until_error([&src] { return src.read_line(); }) |
+                       std::views::transform(parse_number) | Result::views::take_while_ok;
+        for (uint64_t num : numbers)
+            sum += num;
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(numbers.error_ptr());
+    }
+}
+#endif
+
+#if defined(RESULT_HAS_IO)
+// 256 MiB log like file with lines of 40 to 200 bytes, removed at exit
+struct LogFile {
+    LogFile()
+    {
+        char name[] = "/tmp/result_code_bench_XXXXXX";
+        const int fd = mkstemp(name);
+        path = name;
+        std::string text;
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<size_t> length(40, 200);
+        while (size < (size_t(256) << 20)) {
+            text.clear();
+            for (int i = 0; i < 1024; ++i) {
+                text.append(length(gen), static_cast<char>('a' + i % 26));
+                text.push_back('\n');
+            }
+            if (fd < 0 || write(fd, text.data(), text.size()) != static_cast<ssize_t>(text.size()))
+                break;
+            size += text.size();
+        }
+        if (fd >= 0)
+            close(fd);
+    }
+
+    ~LogFile() { std::remove(path.c_str()); }
+
+    std::string path;
+    size_t size = 0;
+};
+
+const LogFile& log_file()
+{
+    static const LogFile file;
+    return file;
+}
+
+void run_line_reader(benchmark::State& state, bool map_files)
+{
+    const LogFile& file = log_file();
+    Result::io::LineReader::Options opts;
+    opts.map_files = map_files;
+    for (auto _ : state) {
+        auto opened = Result::io::LineReader::open(file.path.c_str(), opts);
+        Result::io::LineReader* reader = opened.value_ptr();
+        if (reader == nullptr) {
+            state.SkipWithError("can not open file");
+            break;
+        }
+        size_t chars = 0;
+        for (auto line = reader->next(); line; line = reader->next())
+            chars += line.value().size();
+        benchmark::DoNotOptimize(chars);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(file.size));
+}
+
+void BM_LineReaderMapped(benchmark::State& state)
+{
+    run_line_reader(state, true);
+}
+
+void BM_LineReaderBuffered(benchmark::State& state)
+{
+    run_line_reader(state, false);
+}
+
+// README read_line, fresh string per line
+Result::Expected<std::string, Result::io::IoError> read_line(std::ifstream& in)
+{
+    std::string line;
+    if (!std::getline(in, line))
+        return Result::Error(in.eof() ? Result::io::IoError::Eof : Result::io::IoError::Failure);
+    return Result::Ok(std::move(line));
+}
+
+void BM_ReadLineString(benchmark::State& state)
+{
+    const LogFile& file = log_file();
+    for (auto _ : state) {
+        std::ifstream in(file.path);
+        size_t chars = 0;
+        for (auto line = read_line(in); line; line = read_line(in))
+            chars += line.value().size();
+        benchmark::DoNotOptimize(chars);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(file.size));
+}
+#endif
+
+void FailureRates(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgName("failure_pct");
+    for (int rate : {0, 1, 50, 100})
+        bench->Arg(rate);
+}
+}  // namespace
+
+// Five stage pipeline, hand written branches against and_then() combinators
+BENCHMARK_TEMPLATE(BM_NumberChain, manual_chain)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_NumberChain, combinator_chain)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TextChain, manual_text_chain)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TextChain, combinator_text_chain)->Arg(4096);
+
+// Batch of rows as std::vector<Expected> against structure of arrays ResultVector
+BENCHMARK(BM_ScanExpectedVector)->Arg(1000000)->Arg(100000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ScanResultVector)->Arg(1000000)->Arg(100000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ErrorIndicesExpectedVector)->Arg(1000000)->Arg(100000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ErrorIndicesResultVector)->Arg(1000000)->Arg(100000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FirstErrorExpectedVector)->Arg(1000000)->Arg(100000000);
+BENCHMARK(BM_FirstErrorResultVector)->Arg(1000000)->Arg(100000000);
+
+// Scaling of par_try_transform() over 1..N cores, without and with a failure in the middle of the batch
+BENCHMARK(BM_ParallelTryTransform)->Apply(ThreadCounts)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Construct, return, check and propagate through two calls: Expected against other error reporting styles
+#define RESULT_CODE_BENCH_PAYLOADS(bench)                          \
+    BENCHMARK_TEMPLATE(bench, int)->Apply(FailureRates);           \
+    BENCHMARK_TEMPLATE(bench, std::string)->Apply(FailureRates);   \
+    BENCHMARK_TEMPLATE(bench, Blob)->Apply(FailureRates)
+
+RESULT_CODE_BENCH_PAYLOADS(BM_PropagateExpected);
+RESULT_CODE_BENCH_PAYLOADS(BM_PropagateTry);
+#if defined(RESULT_HAS_COROUTINES)
+RESULT_CODE_BENCH_PAYLOADS(BM_PropagateCoroutine);
+RESULT_CODE_BENCH_PAYLOADS(BM_PropagateCoroutineHeap);
+#endif
+RESULT_CODE_BENCH_PAYLOADS(BM_PropagateErrorCode);
+#if defined(__cpp_exceptions)
+RESULT_CODE_BENCH_PAYLOADS(BM_PropagateException);
+#endif
+#if __cplusplus >= 201703L
+RESULT_CODE_BENCH_PAYLOADS(BM_PropagateOptional);
+#endif
+#if defined(__cpp_lib_expected)
+RESULT_CODE_BENCH_PAYLOADS(BM_PropagateStdExpected);
+#endif
+
+// Three layers adding context to an error: frames in the thread arena against message strings
+BENCHMARK(BM_ErrorContextArena)->Apply(FailureRates);
+BENCHMARK(BM_ErrorContextString)->Apply(FailureRates);
+
+// Layer error widened at module boundary: AnyError against std::error_code and std::variant of layer errors
+BENCHMARK(BM_BoundaryAnyError)->Apply(FailureRates);
+BENCHMARK(BM_BoundaryErrorCode)->Apply(FailureRates);
+#if __cplusplus >= 201703L
+BENCHMARK(BM_BoundaryVariant)->Apply(FailureRates);
+#endif
+
+// Error translation between layers, table declared with RESULT_MAP_ERRORS against switch statement
+BENCHMARK_TEMPLATE(BM_MapError, switch_api)->Apply(FailureRates);
+BENCHMARK_TEMPLATE(BM_MapError, table_api)->Apply(FailureRates);
+
+// Producer and consumer thread sharing a ring of encoded results
+BENCHMARK(BM_RingWireView)->Apply(FailureRates)->UseRealTime();
+BENCHMARK(BM_RingHandSerialized)->Apply(FailureRates)->UseRealTime();
+
+// Latency of a round trip between two threads, Result::Future against std::future carrying the same Expected
+BENCHMARK_TEMPLATE(BM_PingPong, ResultChannel)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PingPong, StdChannel)->UseRealTime();
+
+// Lookups from many threads: cache with negative entries, cache of values only and the backend itself
+BENCHMARK(BM_LookupCached)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_LookupCachedValuesOnly)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_LookupUncached)->ThreadRange(1, 8)->UseRealTime();
+
+#if __cplusplus >= 201703L
+// Three error types: OneOf against std::variant of errors inside Expected and flat std::variant, bytes counter is
+// size of the result
+BENCHMARK(BM_MultiErrorOneOf)->Apply(FailureRates);
+BENCHMARK(BM_MultiErrorNestedVariant)->Apply(FailureRates);
+BENCHMARK(BM_MultiErrorFlatVariant)->Apply(FailureRates);
+#endif
+
+#if defined(RESULT_HAS_RANGES)
+// 1 GiB of lines parsed to numbers, hand written loop against generate_until_error | transform | filter_ok views
+BENCHMARK(BM_LinesLoop)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinesViews)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinesLoopUntilError);
+BENCHMARK(BM_LinesViewsUntilError);
+#endif
+
+#if defined(RESULT_HAS_IO)
+// Lines of a 256 MiB file, LineReader over the mapping and over a buffer against std::getline into a string per line
+BENCHMARK(BM_LineReaderMapped)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LineReaderBuffered)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReadLineString)->Unit(benchmark::kMillisecond);
+#endif
@@ -0,0 +1,82 @@
+# Compiles SOURCE to x86-64 assembly and compares functions pairwise: instruction count of the first function of each
+# pair has to be within TOLERANCE percent (at least 8 instructions) of the second one in both directions, so the
+# baseline stays tight, and it can not store to memory more often than the baseline plus the same tolerance.
+# Hot and .cold parts of a function are summed.
+#   cmake -DCXX=<compiler> -DSOURCE=<file> -DINCLUDE=<dir> -DOUTPUT=<file.s> -DFLAGS=<a,b> -DPAIRS=<f:g,...>
+#         [-DTOLERANCE=<percent>] -P CheckCodegen.cmake
+string(REPLACE "," ";" FLAGS "${FLAGS}")
+if(NOT DEFINED TOLERANCE)
+    set(TOLERANCE 10)
+endif()
+string(REPLACE "," ";" PAIRS "${PAIRS}")
+
+execute_process(
+    COMMAND ${CXX} ${FLAGS} -I${INCLUDE} -S ${SOURCE} -o ${OUTPUT}
+    RESULT_VARIABLE compile_result
+    ERROR_VARIABLE compile_error)
+if(NOT compile_result EQUAL 0)
+    message(FATAL_ERROR "Compilation of ${SOURCE} failed:\n${compile_error}")
+endif()
+
+set(names "")
+foreach(pair IN LISTS PAIRS)
+    string(REPLACE ":" ";" pair "${pair}")
+    list(APPEND names ${pair})
+endforeach()
+foreach(name IN LISTS names)
+    set(instructions_${name} 0)
+    set(stores_${name} 0)
+    set(found_${name} FALSE)
+endforeach()
+
+file(STRINGS ${OUTPUT} lines)
+set(current "")
+foreach(line IN LISTS lines)
+    if(line MATCHES "^_Z[0-9]+([A-Za-z0-9_]+)(\\.cold)?:$")
+        set(current "")
+        set(label ${CMAKE_MATCH_1})
+        foreach(name IN LISTS names)
+            if(label MATCHES "^${name}(B[0-9]+[A-Za-z0-9]+)?[a-z]*$")
+                set(current ${name})
+                set(found_${name} TRUE)
+            endif()
+        endforeach()
+    elseif(line MATCHES "\\.cfi_endproc")
+        set(current "")
+    elseif(current AND line MATCHES "^\t[a-z]")
+        math(EXPR instructions_${current} "${instructions_${current}} + 1")
+        # AT&T syntax: destination is the last operand, memory operands end with ')'
+        if(line MATCHES ",[^,]*\\)$" OR line MATCHES "^\tpush")
+            math(EXPR stores_${current} "${stores_${current}} + 1")
+        endif()
+    endif()
+endforeach()
+
+set(failed FALSE)
+foreach(pair IN LISTS PAIRS)
+    string(REPLACE ":" ";" pair "${pair}")
+    list(GET pair 0 checked)
+    list(GET pair 1 baseline)
+    foreach(name ${checked} ${baseline})
+        if(NOT found_${name})
+            message(FATAL_ERROR "Function ${name} not found in ${OUTPUT}")
+        endif()
+    endforeach()
+    message(STATUS "${checked}: ${instructions_${checked}} instructions, ${stores_${checked}} stores; "
+                   "${baseline}: ${instructions_${baseline}} instructions, ${stores_${baseline}} stores")
+    math(EXPR slack "${instructions_${baseline}} * ${TOLERANCE} / 100")
+    if(slack LESS 8)
+        set(slack 8)
+    endif()
+    math(EXPR store_slack "${stores_${baseline}} * ${TOLERANCE} / 100")
+    math(EXPR most "${instructions_${baseline}} + ${slack}")
+    math(EXPR least "${instructions_${baseline}} - ${slack}")
+    math(EXPR most_stores "${stores_${baseline}} + ${store_slack}")
+    if(instructions_${checked} GREATER most OR instructions_${checked} LESS least
+       OR stores_${checked} GREATER most_stores)
+        set(failed TRUE)
+    endif()
+endforeach()
+if(failed)
+    message(FATAL_ERROR "Generated code differs from hand written one by more than ${TOLERANCE}%")
+endif()
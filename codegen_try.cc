@@ -0,0 +1,117 @@
+// Compiled to assembly by CODEGEN_TRY test, see cmake/CheckCodegen.cmake. Each try_* function has to be about as big
+// as its hand written manual_* counterpart (within the tolerance) and store to memory no more often.
+#include "result.h"
+
+#include <string>
+
+enum class StepError { Overflow, Invalid };
+
+using Step = Result::Expected<int, StepError>;
+using TextStep = Result::Expected<int, std::string>;
+
+// Defined elsewhere, so calls are not folded away
+Step step(int val);
+TextStep text_step(int val);
+
+// Payload access without state checks, like hand written code which already branched on is_ok()
+using Unchecked = Result::detail::TryAccess;
+
+Step try_chain(int val)
+{
+    RESULT_TRY_ASSIGN(int v0, step(val));
+    RESULT_TRY_ASSIGN(int v1, step(v0));
+    RESULT_TRY_ASSIGN(int v2, step(v1));
+    RESULT_TRY_ASSIGN(int v3, step(v2));
+    RESULT_TRY_ASSIGN(int v4, step(v3));
+    RESULT_TRY_ASSIGN(int v5, step(v4));
+    RESULT_TRY_ASSIGN(int v6, step(v5));
+    RESULT_TRY_ASSIGN(int v7, step(v6));
+    RESULT_TRY_ASSIGN(int v8, step(v7));
+    RESULT_TRY_ASSIGN(int v9, step(v8));
+    return Result::Ok(v9);
+}
+
+Step manual_chain(int val)
+{
+    Step r0 = step(val);
+    if (!r0.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r0)));
+    Step r1 = step(Unchecked::value(std::move(r0)));
+    if (!r1.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r1)));
+    Step r2 = step(Unchecked::value(std::move(r1)));
+    if (!r2.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r2)));
+    Step r3 = step(Unchecked::value(std::move(r2)));
+    if (!r3.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r3)));
+    Step r4 = step(Unchecked::value(std::move(r3)));
+    if (!r4.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r4)));
+    Step r5 = step(Unchecked::value(std::move(r4)));
+    if (!r5.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r5)));
+    Step r6 = step(Unchecked::value(std::move(r5)));
+    if (!r6.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r6)));
+    Step r7 = step(Unchecked::value(std::move(r6)));
+    if (!r7.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r7)));
+    Step r8 = step(Unchecked::value(std::move(r7)));
+    if (!r8.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r8)));
+    Step r9 = step(Unchecked::value(std::move(r8)));
+    if (!r9.is_ok())
+        return Step(Result::unexpect, Unchecked::error(std::move(r9)));
+    return Result::Ok(Unchecked::value(std::move(r9)));
+}
+
+TextStep try_text_chain(int val)
+{
+    RESULT_TRY_ASSIGN(int v0, text_step(val));
+    RESULT_TRY_ASSIGN(int v1, text_step(v0));
+    RESULT_TRY_ASSIGN(int v2, text_step(v1));
+    RESULT_TRY_ASSIGN(int v3, text_step(v2));
+    RESULT_TRY_ASSIGN(int v4, text_step(v3));
+    RESULT_TRY_ASSIGN(int v5, text_step(v4));
+    RESULT_TRY_ASSIGN(int v6, text_step(v5));
+    RESULT_TRY_ASSIGN(int v7, text_step(v6));
+    RESULT_TRY_ASSIGN(int v8, text_step(v7));
+    RESULT_TRY_ASSIGN(int v9, text_step(v8));
+    return Result::Ok(v9);
+}
+
+TextStep manual_text_chain(int val)
+{
+    TextStep r0 = text_step(val);
+    if (!r0.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r0)));
+    TextStep r1 = text_step(Unchecked::value(std::move(r0)));
+    if (!r1.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r1)));
+    TextStep r2 = text_step(Unchecked::value(std::move(r1)));
+    if (!r2.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r2)));
+    TextStep r3 = text_step(Unchecked::value(std::move(r2)));
+    if (!r3.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r3)));
+    TextStep r4 = text_step(Unchecked::value(std::move(r3)));
+    if (!r4.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r4)));
+    TextStep r5 = text_step(Unchecked::value(std::move(r4)));
+    if (!r5.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r5)));
+    TextStep r6 = text_step(Unchecked::value(std::move(r5)));
+    if (!r6.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r6)));
+    TextStep r7 = text_step(Unchecked::value(std::move(r6)));
+    if (!r7.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r7)));
+    TextStep r8 = text_step(Unchecked::value(std::move(r7)));
+    if (!r8.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r8)));
+    TextStep r9 = text_step(Unchecked::value(std::move(r8)));
+    if (!r9.is_ok())
+        return TextStep(Result::unexpect, Unchecked::error(std::move(r9)));
+    return Result::Ok(Unchecked::value(std::move(r9)));
+}
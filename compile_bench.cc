@@ -0,0 +1,145 @@
+// Driver of result_code_compile_bench target. Writes a translation unit instantiating count distinct Expected
+// specializations (constructors from Ok/Error, value, error and value_or under several bad access policies),
+// compiles it once per standard and reports wall time and peak memory of the compiler:
+//     compile_bench --cxx g++ --include <dir> --count 4000 --std c++17 --std c++20 [compiler flags...]
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Options {
+    std::string cxx = "c++";
+    std::string include = ".";
+    std::string output = "compile_bench_tu.cc";
+    unsigned count = 2000;
+    std::vector<std::string> standards;
+    std::vector<std::string> flags;
+};
+
+struct Measurement {
+    bool ok;
+    double seconds;
+    double max_rss_mb;
+};
+
+bool parse(int argc, char** argv, Options& opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--cxx" && has_value)
+            opts.cxx = argv[++i];
+        else if (arg == "--include" && has_value)
+            opts.include = argv[++i];
+        else if (arg == "--output" && has_value)
+            opts.output = argv[++i];
+        else if (arg == "--count" && has_value)
+            opts.count = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--std" && has_value)
+            opts.standards.push_back(argv[++i]);
+        else if (arg.compare(0, 2, "--") == 0)
+            return false;
+        else
+            opts.flags.push_back(arg);
+    }
+    if (opts.standards.empty())
+        opts.standards = {"c++17", "c++20"};
+    return opts.count > 0;
+}
+
+// Every function uses its own payload type, so each one instantiates a new Expected
+void generate(const Options& opts)
+{
+    static const char* const policies[] = {"Result::BadAccessNoThrow", "Result::BadAccessTerminate",
+                                           "Result::DefaultBadAccess"};
+    std::ofstream out(opts.output);
+    out << "#include \"result.h\"\n\n"
+           "template <unsigned N>\nstruct Payload {\n    unsigned value;\n};\n\n"
+           "template <unsigned N>\nstruct Fault {\n    int code;\n};\n\n"
+           "unsigned sink(unsigned val);\n\n";
+    for (unsigned i = 0; i < opts.count; ++i) {
+        const std::string type = "Result::Expected<Payload<" + std::to_string(i) + ">, Fault<" +
+                                 std::to_string(i % 16) + ">, " + policies[i % 3] + ">";
+        const std::string idx = std::to_string(i);
+        out << type << " make" << idx << "(bool fail)\n{\n"
+            << "    if (fail)\n        return Result::Error(Fault<" << i % 16 << ">{" << idx << "});\n"
+            << "    return Result::Ok(Payload<" << idx << ">{" << idx << "});\n}\n\n"
+            << "unsigned use" << idx << "(bool fail)\n{\n"
+            << "    const auto res = make" << idx << "(fail);\n"
+            << "    if (res)\n        return sink(res.value().value + make" << idx << "(!fail).value_or(Payload<" << idx
+            << ">{0}).value);\n"
+            << "    return sink(static_cast<unsigned>(res.error().code + make" << idx << "(fail).error().code));\n"
+            << "}\n\n";
+    }
+}
+
+Measurement compile(const Options& opts, const std::string& standard)
+{
+    std::vector<std::string> args = {opts.cxx, "-std=" + standard, "-I" + opts.include};
+    args.insert(args.end(), opts.flags.begin(), opts.flags.end());
+    args.insert(args.end(), {"-c", opts.output, "-o", opts.output + ".o"});
+    std::vector<char*> argv;
+    for (std::string& arg : args)
+        argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        // Diagnostics go to a log next to the source, so the table stays readable
+        const int log = open((opts.output + ".log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0) {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+        }
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    rusage usage{};
+    if (pid < 0 || wait4(pid, &status, 0, &usage) != pid)
+        return Measurement{false, 0.0, 0.0};
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+#if defined(__APPLE__)
+    const double rss_mb = static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);  // bytes
+#else
+    const double rss_mb = static_cast<double>(usage.ru_maxrss) / 1024.0;  // kilobytes
+#endif
+    return Measurement{WIFEXITED(status) && WEXITSTATUS(status) == 0, elapsed.count(), rss_mb};
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse(argc, argv, opts)) {
+        std::fprintf(stderr, "usage: %s [--cxx compiler] [--include dir] [--output file] [--count n] [--std c++NN]... "
+                             "[flags]...\n", argv[0]);
+        return 2;
+    }
+    generate(opts);
+    std::printf("%-8s %8s %10s %12s\n", "standard", "count", "seconds", "max_rss_mb");
+    int failed = 0;
+    for (const std::string& standard : opts.standards) {
+        const Measurement res = compile(opts, standard);
+        if (!res.ok) {
+            std::printf("%-8s %8u %10s %12s  see %s.log\n", standard.c_str(), opts.count, "failed", "-",
+                        opts.output.c_str());
+            ++failed;
+            continue;
+        }
+        std::printf("%-8s %8u %10.2f %12.1f\n", standard.c_str(), opts.count, res.seconds, res.max_rss_mb);
+    }
+    return failed == 0 ? 0 : 1;
+}
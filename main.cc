@@ -1,7 +1,57 @@
 #include "result.h"
+#include "result_algorithm.h"
+#include "result_any_error.h"
+#include "result_cache.h"
+#include "result_context.h"
+#include "result_coroutine.h"
+#include "result_future.h"
+#include "result_io.h"
+#include "result_one_of.h"
+#include "result_parallel.h"
+#include "result_report.h"
+#include "result_vector.h"
+#include "result_views.h"
+#include "result_wire.h"
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+// Count every global allocation, so tests can prove that no hidden copies of heap backed payloads are made
+static std::atomic<size_t> allocation_count{0};
+
+// GCC pairs inlined replacement operators with malloc/free and warns about mismatch, they are the same pair here
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(std::size_t size)
+{
+    ++allocation_count;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
 enum class ErrorCode { Any };
 
 enum class ResultCode { Any };
@@ -35,6 +85,28 @@ static_assert(!std::is_default_constructible<MoveOnly>::value);
 static_assert(!std::is_copy_constructible<MoveOnly>::value);
 static_assert(!std::is_copy_assignable<MoveOnly>::value);
 
+// Enum with a declared spare value, it can hold Expected state on its own
+enum class NicheCode : unsigned char { First, Second, Unused = 0xFF };
+
+namespace Result
+{
+template <>
+struct niche_traits<NicheCode> : enum_niche<NicheCode, NicheCode::Unused> {
+};
+}  // namespace Result
+
+// Pointer type opted in to the niche layout
+struct Node {
+    int val;
+};
+
+namespace Result
+{
+template <>
+struct niche_traits<Node*> : pointer_niche<Node> {
+};
+}  // namespace Result
+
 #if __cplusplus > 201402L
 #define CPP17
 #endif
@@ -230,7 +302,7 @@ TEST(Access, NoThrowErrorAccess)
 {
     Result::Expected<int, int, Result::BadAccessNoThrow> val = Result::Ok(1);
     EXPECT_EQ(val.value(), 1);
-    static_assert(std::is_same<decltype(val.value()), int>::value);
+    static_assert(std::is_same<decltype(val.value()), const int&>::value);
     EXPECT_EQ(val.error(), 0);  // default error is int{}
 }
 
@@ -552,6 +624,2262 @@ TEST(Setters, SetError)
     EXPECT_EQ(val.error(), Result::SimpleError{});
 }
 
+static const char* long_text = "long enough text to never fit into small string buffer";
+
+Result::Expected<std::string> make_long_string() { return Result::Ok(std::string(long_text)); }
+
+Result::Expected<Result::EmptyValue, std::string> make_long_error() { return Result::Error(std::string(long_text)); }
+
+TEST(Allocation, OkFromTemporaryStringIsMoved)
+{
+    const auto before = allocation_count.load();
+    auto val = Result::Ok(std::string(long_text));
+    EXPECT_EQ(allocation_count.load() - before, 1U);
+    EXPECT_EQ(val.value(), long_text);
+}
+
+TEST(Allocation, OkFromLvalueStringIsCopiedOnce)
+{
+    const std::string text(long_text);
+    const auto before = allocation_count.load();
+    auto val = Result::Ok(text);
+    static_assert(std::is_same<decltype(val), Result::Success<std::string>>::value);
+    EXPECT_EQ(allocation_count.load() - before, 1U);
+    EXPECT_EQ(val.value(), text);
+}
+
+TEST(Allocation, ReturnOkStringHasNoExtraCopies)
+{
+    const auto before = allocation_count.load();
+    auto val = make_long_string();
+    EXPECT_EQ(allocation_count.load() - before, 1U);
+    EXPECT_EQ(val.value(), long_text);
+}
+
+TEST(Allocation, ReturnErrorStringHasNoExtraCopies)
+{
+    const auto before = allocation_count.load();
+    auto val = make_long_error();
+    EXPECT_EQ(allocation_count.load() - before, 1U);
+    EXPECT_EQ(val.error(), long_text);
+}
+
+TEST(Allocation, CastTemporaryOkIsMoved)
+{
+    const auto before = allocation_count.load();
+    Result::Expected<std::string, int> val = Result::Ok(std::string(long_text));
+    EXPECT_EQ(allocation_count.load() - before, 1U);
+    EXPECT_EQ(val.value(), long_text);
+}
+
+TEST(Allocation, SetValueFromTemporaryIsMoved)
+{
+    Result::Expected<std::string, int> val = Result::Error(1);
+    const auto before = allocation_count.load();
+    val.set_value(std::string(long_text));
+    EXPECT_EQ(allocation_count.load() - before, 1U);
+    EXPECT_EQ(val.value(), long_text);
+}
+
+// Counts live instances to detect leaks and double destruction
+struct Tracked {
+    static int alive;
+    Tracked(int val) : _val(val) { ++alive; }
+    Tracked(const Tracked& other) : _val(other._val) { ++alive; }
+    Tracked(Tracked&& other) noexcept : _val(other._val) { ++alive; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { --alive; }
+    int get() const { return _val; }
+    int _val;
+};
+int Tracked::alive = 0;
+
+TEST(Lifecycle, TrivialTypesStayTrivial)
+{
+    using Trivial = Result::Expected<int, ErrorCode>;
+    static_assert(std::is_trivially_copyable<Trivial>::value);
+    static_assert(std::is_trivially_destructible<Trivial>::value);
+    static_assert(std::is_trivially_copy_constructible<Trivial>::value);
+    static_assert(std::is_trivially_move_constructible<Trivial>::value);
+    static_assert(std::is_trivially_copy_assignable<Trivial>::value);
+    static_assert(std::is_trivially_move_assignable<Trivial>::value);
+    static_assert(std::is_trivially_copyable<Result::Expected<Result::EmptyValue, Result::SimpleError>>::value);
+    static_assert(std::is_trivially_copyable<Result::Expected<double, int, Result::BadAccessNoThrow>>::value);
+}
+
+TEST(Lifecycle, NonTrivialTypesPropagate)
+{
+    using String = Result::Expected<std::string, ErrorCode>;
+    static_assert(!std::is_trivially_copyable<String>::value);
+    static_assert(!std::is_trivially_destructible<String>::value);
+    static_assert(std::is_copy_constructible<String>::value);
+    static_assert(std::is_nothrow_move_constructible<String>::value);
+    static_assert(std::is_copy_assignable<String>::value);
+    static_assert(std::is_move_assignable<String>::value);
+    using ErrorString = Result::Expected<int, std::string>;
+    static_assert(!std::is_trivially_copyable<ErrorString>::value);
+    static_assert(!std::is_trivially_destructible<ErrorString>::value);
+}
+
+TEST(Lifecycle, MoveOnlyTypesAreNotCopyable)
+{
+    using Movable = Result::Expected<MoveOnly, ErrorCode>;
+    static_assert(!std::is_copy_constructible<Movable>::value);
+    static_assert(!std::is_copy_assignable<Movable>::value);
+    static_assert(std::is_move_constructible<Movable>::value);
+    static_assert(std::is_move_assignable<Movable>::value);
+    using MovableError = Result::Expected<int, MoveOnly>;
+    static_assert(!std::is_copy_constructible<MovableError>::value);
+    static_assert(std::is_move_constructible<MovableError>::value);
+}
+
+TEST(Lifecycle, DestructorReleasesValue)
+{
+    {
+        Result::Expected<Tracked, Tracked> val = Result::Ok(Tracked(1));
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+    {
+        Result::Expected<Tracked, Tracked> val = Result::Error(Tracked(1));
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(Lifecycle, CopyAndMoveConstruct)
+{
+    {
+        Result::Expected<Tracked, int> val = Result::Ok(Tracked(1));
+        auto copy = val;
+        auto moved = std::move(val);
+        EXPECT_EQ(Tracked::alive, 3);
+        EXPECT_EQ(copy.value().get(), 1);
+        EXPECT_EQ(moved.value().get(), 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(Lifecycle, AssignBetweenStates)
+{
+    {
+        Result::Expected<Tracked, Tracked> ok = Result::Ok(Tracked(1));
+        Result::Expected<Tracked, Tracked> err = Result::Error(Tracked(2));
+        ok = err;
+        EXPECT_EQ(Tracked::alive, 2);
+        EXPECT_FALSE(ok);
+        EXPECT_EQ(ok.error().get(), 2);
+        err = Result::Ok(Tracked(3));
+        EXPECT_EQ(Tracked::alive, 2);
+        EXPECT_TRUE(err);
+        EXPECT_EQ(err.value().get(), 3);
+        ok = std::move(err);
+        EXPECT_EQ(Tracked::alive, 2);
+        EXPECT_EQ(ok.value().get(), 3);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(Lifecycle, SettersDestroyPreviousValue)
+{
+    {
+        Result::Expected<Tracked, Tracked> val = Result::Ok(Tracked(1));
+        val.set_error(Tracked(2));
+        EXPECT_EQ(Tracked::alive, 1);
+        val.set_value(Tracked(3));
+        EXPECT_EQ(Tracked::alive, 1);
+        EXPECT_EQ(val.value().get(), 3);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(Lifecycle, CopyOfStringOwnsItsBuffer)
+{
+    Result::Expected<std::string> val = Result::Ok(std::string("short"));
+    auto copy = val;
+    val.set_value(std::string(long_text));
+    EXPECT_EQ(copy.value(), "short");
+    EXPECT_EQ(val.value(), long_text);
+}
+
+TEST(Layout, StateIsPackedIntoSingleByte)
+{
+    static_assert(sizeof(Result::Expected<Result::EmptyValue, Result::SimpleError>) == 1);
+    static_assert(sizeof(Result::Expected<char, char>) == 2);
+    static_assert(sizeof(Result::Expected<int, ErrorCode>) == 8);
+    static_assert(sizeof(Result::Expected<short, unsigned char>) == 4);
+    static_assert(sizeof(Result::Expected<double, int>) == 16);
+    static_assert(sizeof(Result::Expected<std::string, ErrorCode>) == sizeof(std::string) + alignof(std::string));
+}
+
+TEST(Layout, NicheKeepsStateInPayload)
+{
+    static_assert(sizeof(Result::Expected<Node*, Result::SimpleError>) == sizeof(Node*));
+    static_assert(sizeof(Result::Expected<Result::EmptyValue, NicheCode>) == 1);
+    static_assert(sizeof(Result::Expected<NicheCode, Result::SimpleError>) == 1);
+    // Niche is used only when other side is empty, and only for pointers which opted in
+    static_assert(sizeof(Result::Expected<Node*, int>) == 2 * sizeof(Node*));
+    static_assert(sizeof(Result::Expected<int*, Result::SimpleError>) == 2 * sizeof(int*));
+    static_assert(std::is_trivially_copyable<Result::Expected<Node*, Result::SimpleError>>::value);
+}
+
+TEST(Layout, PointerNiche)
+{
+    Node node{7};
+    Result::Expected<Node*> val = Result::Ok(&node);
+    EXPECT_TRUE(val);
+    EXPECT_EQ(val.value()->val, 7);
+    val.set_failure();
+    EXPECT_FALSE(val);
+    EXPECT_EQ(val.error(), Result::SimpleError{});
+    val.set_value(nullptr);
+    EXPECT_TRUE(val);
+    EXPECT_EQ(val.value(), nullptr);
+    auto copy = val;
+    EXPECT_TRUE(copy);
+
+    // Pointers without the niche keep track of moved state
+    int number = 7;
+    Result::Expected<int*> plain = Result::Ok(&number);
+    EXPECT_EQ(plain.move_ok(), &number);
+    EXPECT_EQ(plain.value_ptr(), nullptr);
+}
+
+TEST(Layout, EnumNiche)
+{
+    Result::Expected<Result::EmptyValue, NicheCode> val = Result::Error(NicheCode::Second);
+    EXPECT_FALSE(val);
+    EXPECT_EQ(val.error(), NicheCode::Second);
+    val.set_success();
+    EXPECT_TRUE(val);
+    EXPECT_EQ(val.error_or(NicheCode::First), NicheCode::First);
+
+    Result::Expected<NicheCode> code = Result::Ok(NicheCode::First);
+    EXPECT_TRUE(code);
+    EXPECT_EQ(code.value(), NicheCode::First);
+    code = Result::Error();
+    EXPECT_FALSE(code);
+}
+
+TEST(Layout, EmptyTypesMoveTracking)
+{
+    SKIP_IF_NO_EXCEPTIONS;
+    Result::Expected<Result::EmptyValue, Result::SimpleError> val = Result::Ok();
+    EXPECT_EQ(val.move_ok(), Result::EmptyValue{});
+    EXPECT_TRUE(val);
+    EXPECT_THROW(val.value(), bad_access);
+    val.set_success();
+    EXPECT_EQ(val.value(), Result::EmptyValue{});
+}
+
+Result::Expected<int, ErrorCode> parse_digit(char ch)
+{
+    if (ch < '0' || ch > '9')
+        return Result::Error(ErrorCode::Any);
+    return Result::Ok(ch - '0');
+}
+
+Result::Expected<std::string, ErrorCode> digit_name(int digit)
+{
+    static const char* names[] = {"zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine"};
+    return Result::Ok(std::string(names[digit]));
+}
+
+TEST(Monadic, AndThenChainsSuccess)
+{
+    auto name = parse_digit('7').and_then(digit_name);
+    static_assert(std::is_same<decltype(name), Result::Expected<std::string, ErrorCode>>::value);
+    EXPECT_EQ(name.value(), "seven");
+}
+
+TEST(Monadic, AndThenPropagatesError)
+{
+    int calls = 0;
+    auto name = parse_digit('x').and_then([&calls](int digit) {
+        ++calls;
+        return digit_name(digit);
+    });
+    EXPECT_FALSE(name);
+    EXPECT_EQ(name.error(), ErrorCode::Any);
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(Monadic, TransformValue)
+{
+    const Result::Expected<int, ErrorCode> val = Result::Ok(2);
+    auto doubled = val.transform([](int v) { return v * 2.5; });
+    static_assert(std::is_same<decltype(doubled), Result::Expected<double, ErrorCode>>::value);
+    EXPECT_DOUBLE_EQ(doubled.value(), 5.0);
+}
+
+TEST(Monadic, TransformVoidResultsInEmptyValue)
+{
+    Result::Expected<int, ErrorCode> val = Result::Ok(2);
+    int seen = 0;
+    auto done = val.transform([&seen](int v) { seen = v; });
+    static_assert(std::is_same<decltype(done), Result::Expected<Result::EmptyValue, ErrorCode>>::value);
+    EXPECT_TRUE(done);
+    EXPECT_EQ(seen, 2);
+}
+
+TEST(Monadic, TransformKeepsError)
+{
+    Result::Expected<int, ErrorCode> val = Result::Error(ErrorCode::Any);
+    auto doubled = val.transform([](int v) { return v * 2; });
+    EXPECT_FALSE(doubled);
+    EXPECT_EQ(doubled.error(), ErrorCode::Any);
+}
+
+TEST(Monadic, OrElseRecovers)
+{
+    Result::Expected<int, ErrorCode> val = Result::Error(ErrorCode::Any);
+    auto recovered = val.or_else([](ErrorCode) -> Result::Expected<int, int> { return Result::Ok(42); });
+    EXPECT_EQ(recovered.value(), 42);
+    Result::Expected<int, ErrorCode> ok = Result::Ok(1);
+    auto kept = ok.or_else([](ErrorCode) -> Result::Expected<int, int> { return Result::Error(0); });
+    EXPECT_EQ(kept.value(), 1);
+}
+
+TEST(Monadic, TransformError)
+{
+    Result::Expected<int, ErrorCode> val = Result::Error(ErrorCode::Any);
+    auto text = val.transform_error([](ErrorCode) { return std::string("failed"); });
+    static_assert(std::is_same<decltype(text), Result::Expected<int, std::string>>::value);
+    EXPECT_EQ(text.error(), "failed");
+}
+
+TEST(Monadic, ValueOrElse)
+{
+    Result::Expected<int, int> val = Result::Error(3);
+    EXPECT_EQ(val.value_or_else([](int err) { return err * 10; }), 30);
+    val.set_value(1);
+    EXPECT_EQ(val.value_or_else([](int err) { return err * 10; }), 1);
+}
+
+TEST(Monadic, RvalueChainMovesMoveOnlyPayload)
+{
+    auto result = Result::Expected<MoveOnly, ErrorCode>(Result::Ok(MoveOnly(1)))
+                      .transform([](MoveOnly&& v) { return MoveOnly(v.get() + 1); })
+                      .and_then([](MoveOnly&& v) -> Result::Expected<MoveOnly, ErrorCode> {
+                          return Result::Ok(MoveOnly(v.get() * 10));
+                      });
+    EXPECT_EQ(result.value().get(), 20);
+}
+
+TEST(Monadic, RvalueChainDoesNotCopyStrings)
+{
+    Result::Expected<std::string, ErrorCode> val = Result::Ok(std::string(long_text));
+    const auto before = allocation_count.load();
+    auto size = std::move(val)
+                    .transform([](std::string&& text) { return std::move(text); })
+                    .and_then([](std::string&& text) -> Result::Expected<std::string, ErrorCode> {
+                        return Result::Ok(std::move(text));
+                    })
+                    .transform([](std::string&& text) { return text.size(); });
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+    EXPECT_EQ(size.value(), std::string(long_text).size());
+}
+
+TEST(ZeroCopy, AccessorsReturnReferences)
+{
+    Result::Expected<std::string, ErrorCode> val = Result::Ok(std::string(long_text));
+    static_assert(std::is_same<decltype(val.value()), const std::string&>::value);
+    static_assert(std::is_same<decltype(std::move(val).value()), std::string>::value);
+    const auto before = allocation_count.load();
+    const auto& first = val.value();
+    const auto& second = val.value();
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+    EXPECT_EQ(&first, &second);
+    EXPECT_EQ(first, long_text);
+}
+
+TEST(ZeroCopy, NoThrowBadAccessReturnsDefaultInstance)
+{
+    Result::Expected<std::string, int, Result::BadAccessNoThrow> val = Result::Error(1);
+    static_assert(std::is_same<decltype(val.value()), const std::string&>::value);
+    EXPECT_TRUE(val.value().empty());
+    EXPECT_EQ(&val.value(), &val.value());
+}
+
+TEST(ZeroCopy, ValueOrDoesNotCopyLvalues)
+{
+    const std::string fallback(long_text);
+    Result::Expected<std::string, ErrorCode> err = Result::Error(ErrorCode::Any);
+    Result::Expected<std::string, ErrorCode> ok = Result::Ok(std::string(long_text));
+    const auto before = allocation_count.load();
+    EXPECT_EQ(&err.value_or(fallback), &fallback);
+    EXPECT_EQ(&ok.value_or(fallback), &ok.value());
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+    static_assert(std::is_same<decltype(err.value_or(std::string())), std::string>::value);
+    EXPECT_EQ(err.value_or(std::string("tmp")), "tmp");
+}
+
+TEST(ZeroCopy, ValueOrOnTemporaryMovesPayload)
+{
+    Result::Expected<std::string, ErrorCode> val = Result::Ok(std::string(long_text));
+    const auto before = allocation_count.load();
+    auto text = std::move(val).value_or("other");
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+    EXPECT_EQ(text, long_text);
+}
+
+TEST(ZeroCopy, ValueAndErrorPointers)
+{
+    Result::Expected<int, ErrorCode> val = Result::Ok(5);
+    int* ptr = val.value_ptr();
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(*ptr, 5);
+    EXPECT_EQ(val.error_ptr(), nullptr);
+    *ptr = 6;
+    EXPECT_EQ(val.value(), 6);
+    const auto& cval = val;
+    static_assert(std::is_same<decltype(cval.value_ptr()), const int*>::value);
+    val.set_error(ErrorCode::Any);
+    EXPECT_EQ(cval.value_ptr(), nullptr);
+    ASSERT_NE(cval.error_ptr(), nullptr);
+    EXPECT_EQ(*cval.error_ptr(), ErrorCode::Any);
+}
+
+TEST(ZeroCopy, ReferencePayload)
+{
+    std::string first(long_text);
+    std::string second("second");
+    const auto before = allocation_count.load();
+    Result::Expected<std::string&, Result::SimpleError> val = Result::Ok(std::ref(first));
+    EXPECT_EQ(allocation_count.load() - before, 0U);
+    EXPECT_EQ(&val.value(), &first);
+    val.value() += "!";
+    EXPECT_EQ(first.back(), '!');
+    val.set_value(second);  // rebinds, first is untouched
+    EXPECT_EQ(&val.value(), &second);
+    EXPECT_EQ(first.back(), '!');
+    Result::Expected<std::string&, Result::SimpleError> copy = val;
+    EXPECT_EQ(&copy.value(), &second);
+    EXPECT_EQ(val.value_ptr(), &second);
+    static_assert(sizeof(Result::Expected<std::string&, Result::SimpleError>) == sizeof(void*));
+}
+
+TEST(ZeroCopy, ConstReferencePayload)
+{
+    const std::string text(long_text);
+    Result::Expected<const std::string&, ErrorCode> val = Result::Ok(std::cref(text));
+    EXPECT_EQ(&val.value(), &text);
+    auto length = val.transform([](const std::string& str) { return str.size(); });
+    EXPECT_EQ(length.value(), text.size());
+    Result::Expected<const std::string&, ErrorCode> err = Result::Error(ErrorCode::Any);
+    EXPECT_EQ(&err.value_or(text), &text);
+}
+
+// Record that must never be copied nor moved, so only in place construction can produce it
+struct Pinned {
+    Pinned(int first, std::string second) : _first(first), _second(std::move(second)) {}
+    Pinned(const Pinned&) = delete;
+    Pinned(Pinned&&) = delete;
+    Pinned& operator=(const Pinned&) = delete;
+    Pinned& operator=(Pinned&&) = delete;
+    int _first;
+    std::string _second;
+};
+
+TEST(InPlace, ConstructValueAndError)
+{
+    Result::Expected<Pinned, ErrorCode> val(Result::in_place, 4, "four");
+    ASSERT_TRUE(val);
+    EXPECT_EQ(val.value()._first, 4);
+    EXPECT_EQ(val.value()._second, "four");
+    Result::Expected<int, Pinned> err(Result::unexpect, 5, "five");
+    ASSERT_FALSE(err);
+    EXPECT_EQ(err.error()._second, "five");
+    static_assert(!std::is_convertible<Result::in_place_t, Result::Expected<int, ErrorCode>>::value);
+}
+
+TEST(InPlace, InitializerList)
+{
+    Result::Expected<std::vector<int>, ErrorCode> val(Result::in_place, {1, 2, 3});
+    EXPECT_EQ(val.value().size(), 3U);
+    Result::Expected<int, std::vector<int>> err(Result::unexpect, {1, 2});
+    EXPECT_EQ(err.error().size(), 2U);
+    val.emplace({4, 5, 6, 7});
+    EXPECT_EQ(val.value().back(), 7);
+}
+
+TEST(InPlace, EmplaceDestroysPreviousPayload)
+{
+    Tracked::alive = 0;
+    {
+        Result::Expected<Tracked, Tracked> val(Result::in_place, 1);
+        EXPECT_EQ(Tracked::alive, 1);
+        EXPECT_EQ(val.emplace(2).get(), 2);
+        EXPECT_EQ(Tracked::alive, 1);
+        EXPECT_EQ(val.emplace_error(3).get(), 3);
+        EXPECT_FALSE(val);
+        EXPECT_EQ(Tracked::alive, 1);
+        val.emplace(4);
+        EXPECT_TRUE(val);
+        EXPECT_EQ(val.value().get(), 4);
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(InPlace, EmplaceAfterMove)
+{
+    Result::Expected<std::string, ErrorCode> val(Result::in_place, size_t{3}, 'x');
+    auto taken = val.move_ok();
+    EXPECT_EQ(taken, "xxx");
+    val.emplace(size_t{2}, 'y');
+    EXPECT_EQ(val.value(), "yy");
+    EXPECT_NE(val.value_ptr(), nullptr);
+}
+
+TEST(InPlace, EmplaceDoesNotCopy)
+{
+    Result::Expected<std::string, ErrorCode> val = Result::Error(ErrorCode::Any);
+    const auto before = allocation_count.load();
+    val.emplace(long_text);
+    EXPECT_EQ(allocation_count.load() - before, 1U);  // the string buffer itself
+    EXPECT_EQ(val.value(), long_text);
+}
+
+// Constructor may throw, moves are counted
+struct Record {
+    static int moves;
+    explicit Record(int num) : val(num)
+    {
+#if defined(USE_EXCEPTIONS)
+        if (num < 0)
+            throw std::invalid_argument("negative");
+#endif
+    }
+    Record(Record&& other) noexcept : val(other.val) { ++moves; }
+    int val;
+};
+int Record::moves = 0;
+
+TEST(InPlace, EmplaceBuildsOnceInStorage)
+{
+    Result::Expected<Record, ErrorCode> val = Result::Error(ErrorCode::Any);
+    Record::moves = 0;
+    EXPECT_EQ(val.emplace(1).val, 1);
+    EXPECT_EQ(Record::moves, 0);
+#if defined(USE_EXCEPTIONS)
+    // old value is gone, default error is left in moved state
+    EXPECT_THROW(val.emplace(-1), std::invalid_argument);
+    EXPECT_FALSE(val.is_ok());
+    EXPECT_EQ(val.error_ptr(), nullptr);
+    EXPECT_EQ(val.emplace(2).val, 2);
+    EXPECT_EQ(Record::moves, 0);
+#endif
+}
+
+TEST(ResultVector, PushAndAccess)
+{
+    Result::ResultVector<std::string, ErrorCode> vec;
+    vec.push_back(Result::Ok(std::string("a")));
+    vec.push_back(Result::Error(ErrorCode::Any));
+    vec.emplace_ok(size_t{2}, 'b');
+    ASSERT_EQ(vec.size(), 3U);
+    EXPECT_TRUE(vec[0]);
+    EXPECT_FALSE(vec[1]);
+    EXPECT_EQ(vec[0].value(), "a");
+    EXPECT_EQ(vec[1].error(), ErrorCode::Any);
+    EXPECT_EQ(vec[2].value(), "bb");
+    EXPECT_EQ(vec[1].value_ptr(), nullptr);
+    EXPECT_EQ(vec[1].value_or("fallback"), "fallback");
+    auto* last = vec[2].value_ptr();
+    ASSERT_NE(last, nullptr);
+    *last += "c";
+    EXPECT_EQ(vec.values().back(), "bbc");
+}
+
+TEST(ResultVector, ProxyConvertsToExpected)
+{
+    Result::ResultVector<int, ErrorCode> vec;
+    vec.emplace_ok(20);
+    vec.emplace_error(ErrorCode::Any);
+    Result::Expected<int, ErrorCode> first = vec[0];
+    auto doubled = static_cast<Result::Expected<int, ErrorCode>>(vec[0]).transform([](int val) { return val * 2; });
+    EXPECT_EQ(first.value(), 20);
+    EXPECT_EQ(doubled.value(), 40);
+    Result::Expected<int, ErrorCode> second = vec[1];
+    EXPECT_EQ(second.error(), ErrorCode::Any);
+}
+
+TEST(ResultVector, QueriesAcrossManyWords)
+{
+    Result::ResultVector<int, int> vec;
+    EXPECT_TRUE(vec.all_ok());
+    EXPECT_EQ(vec.first_error(), 0U);
+    for (int idx = 0; idx < 1000; ++idx) {
+        if (idx % 97 == 13)
+            vec.emplace_error(idx);
+        else
+            vec.emplace_ok(idx);
+    }
+    EXPECT_EQ(vec.count_error(), 11U);
+    EXPECT_EQ(vec.count_ok(), 989U);
+    EXPECT_FALSE(vec.all_ok());
+    EXPECT_EQ(vec.first_error(), 13U);
+    for (size_t idx = 0; idx < vec.size(); ++idx) {
+        if (idx % 97 == 13)
+            EXPECT_EQ(static_cast<size_t>(vec[idx].error()), idx);
+        else
+            EXPECT_EQ(static_cast<size_t>(vec[idx].value()), idx);
+    }
+    std::vector<size_t> errors(vec.error_indices().begin(), vec.error_indices().end());
+    ASSERT_EQ(errors.size(), 11U);
+    for (size_t idx = 0; idx < errors.size(); ++idx)
+        EXPECT_EQ(errors[idx], idx * 97 + 13);
+    size_t ok_count = 0;
+    for (size_t idx : vec.ok_indices()) {
+        EXPECT_TRUE(vec.is_ok(idx));
+        ++ok_count;
+    }
+    EXPECT_EQ(ok_count, 989U);
+}
+
+TEST(ResultVector, ForEachVisitsInOrder)
+{
+    Result::ResultVector<int, ErrorCode> vec;
+    for (int idx = 0; idx < 130; ++idx) {
+        if (idx == 64 || idx == 129)
+            vec.emplace_error(ErrorCode::Any);
+        else
+            vec.emplace_ok(idx);
+    }
+    size_t visited = 0;
+    vec.for_each_ok([&](size_t idx, int& val) {
+        EXPECT_EQ(static_cast<size_t>(val), idx);
+        val = -val;
+        ++visited;
+    });
+    EXPECT_EQ(visited, 128U);
+    EXPECT_EQ(vec[63].value(), -63);
+    std::vector<size_t> failed;
+    vec.for_each_error([&](size_t idx, const ErrorCode&) { failed.push_back(idx); });
+    EXPECT_EQ(failed, (std::vector<size_t>{64, 129}));
+}
+
+TEST(ResultVector, BuildFromRangeMovesPayload)
+{
+    std::vector<Result::Expected<MoveOnly, ErrorCode>> source;
+    source.emplace_back(Result::in_place, 1);
+    source.emplace_back(Result::unexpect, ErrorCode::Any);
+    source.emplace_back(Result::in_place, 3);
+    Result::ResultVector<MoveOnly, ErrorCode> vec(std::make_move_iterator(source.begin()),
+                                                  std::make_move_iterator(source.end()));
+    ASSERT_EQ(vec.size(), 3U);
+    EXPECT_EQ(vec[2].value().get(), 3);
+    EXPECT_EQ(vec.first_error(), 1U);
+    vec.clear();
+    EXPECT_TRUE(vec.empty());
+    EXPECT_TRUE(vec.all_ok());
+}
+
+TEST(Algorithm, CollectValues)
+{
+    std::vector<Result::Expected<int, ErrorCode>> source{Result::Ok(1), Result::Ok(2), Result::Ok(3)};
+    const auto before = allocation_count.load();
+    auto all = Result::collect(source);
+    EXPECT_EQ(allocation_count.load() - before, 1U);  // output is reserved once
+    static_assert(std::is_same<decltype(all), Result::Expected<std::vector<int>, ErrorCode>>::value);
+    EXPECT_EQ(all.value(), (std::vector<int>{1, 2, 3}));
+}
+
+TEST(Algorithm, CollectStopsAtFirstError)
+{
+    std::vector<Result::Expected<std::string, int>> source;
+    source.emplace_back(Result::in_place, long_text);
+    source.emplace_back(Result::unexpect, 7);
+    source.emplace_back(Result::in_place, long_text);
+    auto all = Result::collect(std::move(source));
+    EXPECT_EQ(all.error(), 7);
+    EXPECT_TRUE(source[0].value().empty());    // moved into output
+    EXPECT_EQ(source[2].value(), long_text);  // never reached
+}
+
+TEST(Algorithm, CollectFromUnsizedRange)
+{
+    std::list<Result::Expected<int, ErrorCode>> source{Result::Ok(4), Result::Ok(5)};
+    EXPECT_EQ(Result::collect(source).value(), (std::vector<int>{4, 5}));
+    std::list<Result::Expected<int, ErrorCode>> empty;
+    EXPECT_TRUE(Result::collect(empty).value().empty());
+}
+
+TEST(Algorithm, CollectMovesFromRvalueRange)
+{
+    std::vector<Result::Expected<std::string, ErrorCode>> source;
+    source.emplace_back(Result::in_place, long_text);
+    source.emplace_back(Result::in_place, long_text);
+    const auto before = allocation_count.load();
+    auto all = Result::collect(std::move(source));
+    EXPECT_EQ(allocation_count.load() - before, 1U);  // vector buffer only, strings are moved
+    EXPECT_EQ(all.value().size(), 2U);
+}
+
+TEST(Algorithm, PartitionKeepsOrder)
+{
+    std::vector<Result::Expected<int, std::string>> source{Result::Ok(1), Result::Error(std::string("a")),
+                                                           Result::Ok(3), Result::Error(std::string("b"))};
+    auto parts = Result::partition(source);
+    EXPECT_EQ(parts.first, (std::vector<int>{1, 3}));
+    EXPECT_EQ(parts.second, (std::vector<std::string>{"a", "b"}));
+    auto moved = Result::partition(std::move(source));
+    EXPECT_EQ(moved.second.size(), 2U);
+    EXPECT_TRUE(source[1].error().empty());
+}
+
+TEST(Algorithm, TryTransformStopsAtFirstFailure)
+{
+    std::vector<char> digits{'1', '2', 'x', '4'};
+    int calls = 0;
+    auto parse = [&calls](char ch) -> Result::Expected<int, ErrorCode> {
+        ++calls;
+        if (ch < '0' || ch > '9')
+            return Result::Error(ErrorCode::Any);
+        return Result::Ok(ch - '0');
+    };
+    auto failed = Result::try_transform(digits, parse);
+    EXPECT_FALSE(failed);
+    EXPECT_EQ(calls, 3);
+    digits[2] = '3';
+    auto parsed = Result::try_transform(digits, parse);
+    EXPECT_EQ(parsed.value(), (std::vector<int>{1, 2, 3, 4}));
+}
+
+TEST(Algorithm, TryTransformMovesElements)
+{
+    std::vector<MoveOnly> source;
+    source.emplace_back(1);
+    source.emplace_back(2);
+    auto res = Result::try_transform(std::move(source), [](MoveOnly&& val) -> Result::Expected<MoveOnly, ErrorCode> {
+        return Result::Ok(MoveOnly(val.get() * 2));
+    });
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res.value()[1].get(), 4);
+}
+
+Result::Expected<int, int> checked_square(int val)
+{
+    if (val < 0)
+        return Result::Error(val);
+    return Result::Ok(val * val);
+}
+
+TEST(Parallel, TransformsEveryElement)
+{
+    Result::ThreadPool pool(3);
+    std::vector<int> input(10000);
+    for (size_t idx = 0; idx < input.size(); ++idx)
+        input[idx] = static_cast<int>(idx % 100);
+    std::vector<int> output(input.size());
+    auto res = Result::par_try_transform(input.begin(), input.end(), output.begin(), checked_square, 4, pool);
+    ASSERT_TRUE(res);
+    static_assert(std::is_same<decltype(res), Result::Expected<Result::EmptyValue, int>>::value);
+    for (size_t idx = 0; idx < input.size(); ++idx)
+        EXPECT_EQ(output[idx], input[idx] * input[idx]);
+}
+
+TEST(Parallel, ReportsLowestFailingIndex)
+{
+    Result::ThreadPool pool(3);
+    std::vector<int> input(5000, 1);
+    input[4000] = -4000;
+    input[1234] = -1234;
+    input[2500] = -2500;
+    std::vector<int> output(input.size());
+    for (int run = 0; run < 20; ++run) {
+        auto res = Result::par_try_transform(input.begin(), input.end(), output.begin(), checked_square, 4, pool);
+        ASSERT_FALSE(res);
+        EXPECT_EQ(res.error(), -1234);
+    }
+}
+
+TEST(Parallel, StopsAfterFailure)
+{
+    Result::ThreadPool pool(1);
+    std::vector<int> input(100000, 1);
+    input[0] = -1;
+    std::vector<int> output(input.size());
+    std::atomic<size_t> calls{0};
+    auto counted = [&calls](int val) {
+        ++calls;
+        return checked_square(val);
+    };
+    auto res = Result::par_try_transform(input.data(), input.data() + input.size(), output.data(), counted, 1, pool);
+    EXPECT_EQ(res.error(), -1);
+    EXPECT_EQ(calls.load(), 1U);
+    calls = 0;
+    res = Result::par_try_transform(input.data(), input.data() + input.size(), output.data(), counted, 2, pool);
+    EXPECT_EQ(res.error(), -1);
+    EXPECT_LT(calls.load(), input.size());
+}
+
+#if defined(USE_EXCEPTIONS)
+TEST(Parallel, ExceptionIsRethrownToCaller)
+{
+    Result::ThreadPool pool(3);
+    std::vector<int> input(5000, 1);
+    input[3000] = 0;
+    std::vector<int> output(input.size());
+    auto throwing = [](int val) -> Result::Expected<int, int> {
+        if (val == 0)
+            throw std::invalid_argument("zero");
+        return Result::Ok(val);
+    };
+    for (int run = 0; run < 20; ++run)
+        EXPECT_THROW(Result::par_try_transform(input.begin(), input.end(), output.begin(), throwing, 4, pool),
+                     std::invalid_argument);
+    // pool is still usable
+    EXPECT_TRUE(Result::par_try_transform(input.begin(), input.begin() + 3000, output.begin(), throwing, 4, pool));
+}
+#endif
+
+TEST(Parallel, EmptyRange)
+{
+    std::vector<int> input;
+    std::vector<int> output;
+    EXPECT_TRUE(Result::par_try_transform(input.begin(), input.end(), output.begin(), checked_square));
+}
+
+#if __cplusplus >= 201402L
+// Whole pipelines evaluated by the compiler, a failing step breaks the build
+namespace constexpr_test
+{
+enum class ProtoError { Unknown, Truncated };
+
+using Handler = int (*)(int);
+using Lookup = Result::Expected<Handler, ProtoError, Result::BadAccessTerminate>;
+using Parsed = Result::Expected<int, ProtoError, Result::BadAccessTerminate>;
+
+constexpr int handle_ping(int seq) { return seq + 1; }
+constexpr int handle_close(int) { return 0; }
+
+constexpr Lookup lookup(int opcode)
+{
+    return opcode == 1   ? Lookup(Result::Ok(&handle_ping))
+           : opcode == 8 ? Lookup(Result::Ok(&handle_close))
+                         : Lookup(Result::Error(ProtoError::Unknown));
+}
+
+// Dispatch table built at compile time
+constexpr Lookup table[] = {lookup(0), lookup(1), lookup(8)};
+
+constexpr Parsed parse_length(int raw)
+{
+    if (raw < 0)
+        return Result::Error(ProtoError::Truncated);
+    return Result::Ok(raw);
+}
+
+constexpr Parsed check_length(int len)
+{
+    if (len > 125)
+        return Result::Error(ProtoError::Unknown);
+    return Result::Ok(len);
+}
+
+constexpr int twice(int len) { return len * 2; }
+constexpr Parsed recover(ProtoError) { return Result::Ok(0); }
+constexpr ProtoError widen(ProtoError) { return ProtoError::Unknown; }
+
+static_assert(!table[0].is_ok(), "");
+static_assert(table[0].error() == ProtoError::Unknown, "");
+static_assert(table[1].value()(41) == 42, "");
+static_assert(table[2].value()(7) == 0, "");
+static_assert(std::is_trivially_copyable<Lookup>::value, "");
+
+static_assert(parse_length(10).and_then(check_length).transform(twice).value() == 20, "");
+static_assert(parse_length(200).and_then(check_length).error() == ProtoError::Unknown, "");
+static_assert(parse_length(-1).and_then(check_length).error() == ProtoError::Truncated, "");
+static_assert(parse_length(-1).or_else(recover).value() == 0, "");
+static_assert(parse_length(-1).transform_error(widen).error() == ProtoError::Unknown, "");
+static_assert(parse_length(-1).value_or(7) == 7, "");
+static_assert(*parse_length(3).value_ptr() == 3, "");
+static_assert(parse_length(3).error_ptr() == nullptr, "");
+static_assert(Parsed(Result::in_place, 5).value() == 5, "");
+static_assert(Parsed(Result::unexpect, ProtoError::Truncated).error() == ProtoError::Truncated, "");
+
+// Empty and niche layouts
+static_assert(Result::Expected<>(Result::Ok()).is_ok(), "");
+static_assert(!Result::Expected<>(Result::Error()).is_ok(), "");
+using Status = Result::Expected<Result::EmptyValue, NicheCode>;
+static_assert(sizeof(Status) == sizeof(NicheCode), "");
+static_assert(Status(Result::Ok()).is_ok(), "");
+static_assert(Status(Result::Error(NicheCode::Second)).error() == NicheCode::Second, "");
+
+#ifdef CPP17
+static_assert(parse_length(4).transform([](int len) { return len + 1; }).value_or_else([](ProtoError) { return 0; }) ==
+              5);
+#endif
+
+#if RESULT_HAS_CONSTEXPR20
+// Payload is replaced and destroyed during constant evaluation
+constexpr int replace_payload()
+{
+    Parsed res = Result::Error(ProtoError::Unknown);
+    res.set_value(3);
+    res.emplace(4);
+    Parsed copy = res;
+    copy.set_error(ProtoError::Truncated);
+    return res.value() + (copy.is_ok() ? 100 : 10);
+}
+static_assert(replace_payload() == 14);
+
+#if defined(__cpp_lib_constexpr_string)
+constexpr size_t string_payload()
+{
+    Result::Expected<std::string, ProtoError> res(Result::in_place, size_t{3}, 'x');
+    res.emplace_error(ProtoError::Unknown);
+    res.emplace("abcde");
+    return res.value().size();
+}
+static_assert(string_payload() == 5);
+#endif
+#endif
+}  // namespace constexpr_test
+
+TEST(Constexpr, SameResultsAtRunTime)
+{
+    int opcode = 1;
+    EXPECT_EQ(constexpr_test::lookup(opcode).value()(1), 2);
+    EXPECT_EQ(constexpr_test::parse_length(opcode).and_then(constexpr_test::check_length).value(), 1);
+    EXPECT_FALSE(constexpr_test::lookup(opcode + 1).is_ok());
+}
+#endif
+
+static Result::Expected<int, ErrorCode> try_digit(char ch)
+{
+    if (ch < '0' || ch > '9')
+        return Result::Error(ErrorCode::Any);
+    return Result::Ok(ch - '0');
+}
+
+static Result::Expected<int, ErrorCode> try_number(const char* text)
+{
+    RESULT_TRY_ASSIGN(int high, try_digit(text[0]));
+    RESULT_TRY_ASSIGN(const int low, try_digit(text[1]));
+    return Result::Ok(high * 10 + low);
+}
+
+TEST(Try, AssignReturnsValueOrError)
+{
+    EXPECT_EQ(try_number("42").value(), 42);
+    EXPECT_EQ(try_number("4x").error(), ErrorCode::Any);
+    EXPECT_EQ(try_number("x2").error(), ErrorCode::Any);
+}
+
+static Result::Expected<std::string, std::string> try_text(bool ok)
+{
+    if (!ok)
+        return Result::Error(std::string(64, 'e'));
+    return Result::Ok(std::string(64, 'v'));
+}
+
+static Result::Expected<size_t, std::string> try_length(bool ok, size_t* allocations)
+{
+    const auto before = allocation_count.load();
+    RESULT_TRY_ASSIGN(std::string text, try_text(ok));
+    *allocations = allocation_count.load() - before;
+    return Result::Ok(text.size());
+}
+
+TEST(Try, PayloadIsMovedNotCopied)
+{
+    size_t allocations = 0;
+    EXPECT_EQ(try_length(true, &allocations).value(), 64U);
+    EXPECT_EQ(allocations, 1U);
+    const auto before = allocation_count.load();
+    const auto res = try_length(false, &allocations);
+    EXPECT_EQ(allocation_count.load() - before, 1U);
+    EXPECT_EQ(res.error(), std::string(64, 'e'));
+}
+
+static Result::Expected<Result::EmptyValue, std::string> try_check(const Result::Expected<int, const char*>& res)
+{
+    RESULT_TRY(res);
+    return Result::Ok();
+}
+
+TEST(Try, LvalueIsCopiedAndConverted)
+{
+    const Result::Expected<int, const char*> failed = Result::Error("broken");
+    EXPECT_EQ(try_check(failed).error(), "broken");
+    EXPECT_STREQ(failed.error(), "broken");
+    EXPECT_TRUE(try_check(Result::Ok(1)).is_ok());
+}
+
+static Result::Expected<MoveOnly, ErrorCode> try_make(bool ok)
+{
+    if (!ok)
+        return Result::Error(ErrorCode::Any);
+    return Result::Ok(MoveOnly(5));
+}
+
+static Result::Expected<int, ErrorCode> try_unwrap(bool ok)
+{
+    RESULT_TRY_ASSIGN(MoveOnly val, try_make(ok));
+    return Result::Ok(val.get());
+}
+
+TEST(Try, MoveOnlyValue)
+{
+    EXPECT_EQ(try_unwrap(true).value(), 5);
+    EXPECT_FALSE(try_unwrap(false).is_ok());
+}
+
+#if RESULT_HAS_STATEMENT_EXPRESSIONS
+static Result::Expected<int, ErrorCode> try_sum(const char* text)
+{
+    return Result::Ok(RESULT_TRY(try_digit(text[0])) + RESULT_TRY(try_digit(text[1])));
+}
+
+TEST(Try, StatementExpression)
+{
+    EXPECT_EQ(try_sum("34").value(), 7);
+    EXPECT_FALSE(try_sum("3-").is_ok());
+}
+#endif
+
+#if defined(RESULT_HAS_COROUTINES)
+static Result::Expected<int, ErrorCode> coro_digit(char ch)
+{
+    if (ch < '0' || ch > '9')
+        co_return Result::Error(ErrorCode::Any);
+    co_return ch - '0';
+}
+
+static int coro_steps = 0;
+
+static Result::Expected<int, ErrorCode> coro_number(const char* text)
+{
+    const int high = co_await coro_digit(text[0]);
+    ++coro_steps;
+    const int low = co_await coro_digit(text[1]);
+    ++coro_steps;
+    co_return Result::Ok(high * 10 + low);
+}
+
+TEST(Coroutine, AwaitValueOrReturnError)
+{
+    coro_steps = 0;
+    EXPECT_EQ(coro_number("42").value(), 42);
+    EXPECT_EQ(coro_steps, 2);
+    coro_steps = 0;
+    EXPECT_EQ(coro_number("4x").error(), ErrorCode::Any);
+    EXPECT_EQ(coro_steps, 1);
+}
+
+static Result::Expected<size_t, std::string> coro_length(const Result::Expected<std::string, const char*>& text)
+{
+    Tracked local(1);
+    const std::string& value = co_await text;
+    co_return value.size() + static_cast<size_t>(local.get());
+}
+
+TEST(Coroutine, ErrorIsConvertedAndLocalsDestroyed)
+{
+    const Result::Expected<std::string, const char*> failed = Result::Error("broken");
+    EXPECT_EQ(coro_length(failed).error(), "broken");
+    EXPECT_EQ(Tracked::alive, 0);
+    EXPECT_EQ(coro_length(Result::Ok(std::string("abc"))).value(), 4U);
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+static Result::Expected<MoveOnly, ErrorCode> coro_make(bool ok)
+{
+    if (!ok)
+        return Result::Error(ErrorCode::Any);
+    return Result::Ok(MoveOnly(3));
+}
+
+static Result::Expected<MoveOnly, ErrorCode> coro_move_only(bool ok)
+{
+    MoveOnly val = co_await coro_make(ok);
+    co_return Result::Ok(std::move(val));
+}
+
+TEST(Coroutine, MoveOnlyValue)
+{
+    EXPECT_EQ(coro_move_only(true).value().get(), 3);
+    EXPECT_FALSE(coro_move_only(false).is_ok());
+}
+
+struct CountingFrameAllocator : Result::FrameAllocator {
+    void* allocate(size_t size) override
+    {
+        ++allocated;
+        return ::operator new(size);
+    }
+    void deallocate(void* ptr, size_t size) noexcept override
+    {
+        ++deallocated;
+        ::operator delete(ptr, size);
+    }
+    int allocated = 0;
+    int deallocated = 0;
+};
+
+TEST(Coroutine, FramesComeFromPluggableAllocator)
+{
+    CountingFrameAllocator counting;
+    {
+        Result::ScopedFrameAllocator scope(counting);
+        EXPECT_EQ(coro_number("12").value(), 12);
+        EXPECT_FALSE(coro_number("x2").is_ok());
+    }
+    // GCC never elides frames, other compilers might
+    EXPECT_EQ(counting.allocated, counting.deallocated);
+    EXPECT_LE(counting.allocated, 6);
+    EXPECT_EQ(Result::FrameAllocator::current(), &Result::FramePool::local());
+}
+
+TEST(Coroutine, PoolReusesFrames)
+{
+    EXPECT_EQ(coro_number("12").value(), 12);
+    const auto before = allocation_count.load();
+    for (int idx = 0; idx < 100; ++idx)
+        EXPECT_EQ(coro_number("34").value(), 34);
+    EXPECT_EQ(allocation_count.load(), before);
+}
+
+// Some compilers convert the return object right after get_return_object(), before the body runs
+TEST(Coroutine, EagerConversion)
+{
+    using Exp = Result::Expected<MoveOnly, ErrorCode>;
+    {
+        Result::detail::ExpectedPromise<Exp> promise;
+        Exp res = promise.get_return_object();
+        promise.return_value(Result::Ok(MoveOnly(7)));
+        EXPECT_EQ(res.value().get(), 7);
+    }
+    {
+        Result::detail::ExpectedPromise<Exp> promise;
+        Exp res = promise.get_return_object();
+        promise.fail(ErrorCode::Any);
+        EXPECT_EQ(res.error(), ErrorCode::Any);
+    }
+}
+
+#if defined(USE_EXCEPTIONS)
+static Result::Expected<int, ErrorCode> coro_throw()
+{
+    co_await coro_digit('1');
+    throw std::runtime_error("thrown");
+}
+
+TEST(Coroutine, ExceptionReachesCaller) { EXPECT_THROW(coro_throw(), std::runtime_error); }
+#endif
+#endif
+
+static Result::Expected<int, ErrorCode> ctx_open(bool ok)
+{
+    if (!ok)
+        return Result::Error(ErrorCode::Any);
+    return Result::Ok(3);
+}
+
+static Result::Expected<int, Result::Contextual<ErrorCode>> ctx_read(bool ok)
+{
+    return ctx_open(ok).transform_error(Result::with_context("opening file", "io.cc", 10));
+}
+
+static Result::Expected<int, Result::Contextual<ErrorCode>> ctx_load(bool ok)
+{
+    return ctx_read(ok).transform_error(Result::with_context("loading user", "user.cc", 20));
+}
+
+TEST(Context, ChainGrowsThroughLayers)
+{
+    Result::ContextScope scope;
+    EXPECT_EQ(ctx_load(true).value(), 3);
+    const auto res = ctx_load(false);
+    EXPECT_EQ(res.error().error, ErrorCode::Any);
+    EXPECT_EQ(res.error().context.depth(), 2U);
+    EXPECT_STREQ(res.error().context.begin()->what, "loading user");
+    EXPECT_EQ(res.error().context.to_string(), "loading user (user.cc:20) <- opening file (io.cc:10)");
+}
+
+TEST(Context, LvalueAndMacro)
+{
+    Result::ContextScope scope;
+    const Result::Expected<int, Result::Contextual<ErrorCode>> failed = ctx_read(false);
+    const auto outer = failed.transform_error(RESULT_CONTEXT("retrying"));
+    EXPECT_EQ(outer.error().context.depth(), 2U);
+    EXPECT_EQ(failed.error().context.depth(), 1U);
+    EXPECT_EQ(outer.error().context.begin()->line, __LINE__ - 3);
+}
+
+TEST(Context, ScopeReclaimsFramesWithoutHeap)
+{
+    auto& arena = Result::ContextArena::local();
+    {
+        Result::ContextScope warm_up;
+        for (int idx = 0; idx < 5000; ++idx)
+            ctx_load(false);
+    }
+    const auto capacity = arena.capacity();
+    const auto before = allocation_count.load();
+    const auto mark = arena.mark();
+    for (int round = 0; round < 3; ++round) {
+        Result::ContextScope scope;
+        for (int idx = 0; idx < 5000; ++idx)
+            EXPECT_EQ(ctx_load(false).error().context.depth(), 2U);
+    }
+    EXPECT_EQ(allocation_count.load(), before);
+    EXPECT_EQ(arena.capacity(), capacity);
+    EXPECT_EQ(arena.mark().block, mark.block);
+    EXPECT_EQ(arena.mark().offset, mark.offset);
+}
+
+TEST(Context, ArenaStopsGrowingAtMaxSize)
+{
+    // fresh thread, so its arena and blocks are gone afterwards
+    std::thread([] {
+        auto& arena = Result::ContextArena::local();
+        const size_t frames = Result::ContextArena::max_size / sizeof(Result::ContextFrame) + 1000;
+        Result::Context chain;
+        for (size_t idx = 0; idx < frames; ++idx)
+            chain = chain.push("nested", "ctx.cc", 1);
+        EXPECT_LE(arena.capacity(), Result::ContextArena::max_size);
+        EXPECT_LT(chain.depth(), frames);
+        EXPECT_EQ(chain.push("dropped", "ctx.cc", 2).begin()->what, chain.begin()->what);
+    }).join();
+}
+
+enum class LayerError : uint8_t { Timeout, Refused };
+enum class OtherLayerError : uint8_t { Lost };
+struct ErrnoError {
+    int code;
+    int line;
+};
+struct TaggedError {
+    int code;
+};
+
+template <>
+struct Result::error_domain_traits<ErrnoError> : Result::error_domain<ErrnoError> {
+};
+
+template <>
+struct Result::error_domain_traits<TaggedError> : Result::error_domain<TaggedError, 0x746167676564> {
+};
+
+static Result::Expected<int, LayerError> layer_call(int val)
+{
+    if (val < 0)
+        return Result::Error(LayerError::Refused);
+    return Result::Ok(val);
+}
+
+static Result::Expected<int, Result::AnyError> boundary_call(int val)
+{
+    if (val == 0)
+        return Result::Error(ErrnoError{2, 7});
+    RESULT_TRY_ASSIGN(int res, layer_call(val));
+    return Result::Ok(res);
+}
+
+TEST(AnyError, StoresErrorsOfAnyLayerInline)
+{
+    static_assert(sizeof(Result::AnyError) == 24, "");
+    static_assert(std::is_trivially_copyable<Result::Expected<int, Result::AnyError>>::value, "");
+    static_assert(!std::is_constructible<Result::AnyError, std::string>::value, "");
+    static_assert(!std::is_constructible<Result::BasicAnyError<4>, ErrnoError>::value, "");
+    // only enums and error types with error_domain_traits
+    static_assert(!std::is_constructible<Result::AnyError, double>::value, "");
+    static_assert(!std::is_constructible<Result::AnyError, int>::value, "");
+
+    const Result::AnyError err = LayerError::Timeout;
+    EXPECT_TRUE(err.is<LayerError>());
+    EXPECT_FALSE(err.is<ErrorCode>());
+    const LayerError* layer = err.get_if<LayerError>();
+    ASSERT_NE(layer, nullptr);
+    EXPECT_EQ(*layer, LayerError::Timeout);
+    EXPECT_EQ(err.get_if<ErrnoError>(), nullptr);
+    EXPECT_TRUE(Result::AnyError().empty());
+}
+
+TEST(AnyError, Equality)
+{
+    const Result::AnyError timeout = LayerError::Timeout;
+    EXPECT_EQ(timeout, Result::AnyError(LayerError::Timeout));
+    EXPECT_NE(timeout, Result::AnyError(LayerError::Refused));
+    // same bytes, different domain
+    EXPECT_NE(Result::AnyError(OtherLayerError::Lost), timeout);
+    EXPECT_TRUE(timeout == LayerError::Timeout);
+    EXPECT_TRUE(timeout != LayerError::Refused);
+    EXPECT_EQ(Result::AnyError(), Result::AnyError());
+}
+
+TEST(AnyError, DomainIdIsStable)
+{
+    // Same id in every library, it does not depend on an address
+    EXPECT_EQ(Result::AnyError(LayerError::Timeout).domain(), Result::error_domain_traits<LayerError>::id);
+    EXPECT_EQ(Result::AnyError(TaggedError{1}).domain(), 0x746167676564U);
+    EXPECT_NE(Result::error_domain_traits<LayerError>::id, Result::error_domain_traits<OtherLayerError>::id);
+    EXPECT_NE(Result::error_domain_traits<ErrnoError>::id, 0U);
+    EXPECT_EQ(Result::AnyError().domain(), 0U);
+}
+
+TEST(AnyError, ConvertedFromFailureOfAnyType)
+{
+    const Result::Expected<int, Result::AnyError> direct = Result::Error(ErrorCode::Any);
+    EXPECT_TRUE(direct.error() == ErrorCode::Any);
+    const Result::Failure<Result::AnyError> failure = Result::Error(LayerError::Refused);
+    EXPECT_TRUE(failure.error() == LayerError::Refused);
+    const Result::Expected<int, Result::AnyError> simple = Result::Error();
+    EXPECT_TRUE(simple.error().is<Result::SimpleError>());
+
+    EXPECT_EQ(boundary_call(3).value(), 3);
+    EXPECT_TRUE(boundary_call(-1).error() == LayerError::Refused);
+    const auto res = boundary_call(0);
+    ASSERT_TRUE(res.error().is<ErrnoError>());
+    EXPECT_EQ(res.error().get_if<ErrnoError>()->code, 2);
+    EXPECT_EQ(res.error().get_if<ErrnoError>()->line, 7);
+}
+
+#if __cplusplus >= 201402L
+enum class StoreError { Timeout, Constraint, Missing };
+enum class ApiError { Unavailable, BadRequest, NotFound };
+
+RESULT_MAP_ERRORS(StoreError, ApiError,
+                  {{StoreError::Timeout, ApiError::Unavailable},
+                   {StoreError::Missing, ApiError::NotFound},
+                   {StoreError::Constraint, ApiError::BadRequest}});
+
+static_assert(Result::map_error<ApiError>(StoreError::Missing) == ApiError::NotFound, "");
+static_assert(Result::Error(StoreError::Timeout).cast_to<ApiError>().error() == ApiError::Unavailable, "");
+static_assert(sizeof(Result::detail::ErrorTableOf<StoreError, ApiError>::table) == 3 * sizeof(ApiError), "");
+
+static Result::Expected<int, StoreError> store_get(int key)
+{
+    if (key < 0)
+        return Result::Error(StoreError::Missing);
+    return Result::Ok(key);
+}
+
+static Result::Expected<int, ApiError> api_get(int key)
+{
+    RESULT_TRY_ASSIGN(int val, store_get(key));
+    if (val == 0)
+        return Result::Error(StoreError::Constraint);
+    return Result::Ok(val * 2);
+}
+
+TEST(ErrorMap, TranslatesFailuresAndExpected)
+{
+    EXPECT_EQ(store_get(-1).map_error<ApiError>().error(), ApiError::NotFound);
+    EXPECT_EQ(store_get(4).map_error<ApiError>().value(), 4);
+    const Result::Expected<std::string, StoreError> text = Result::Error(StoreError::Timeout);
+    EXPECT_EQ(text.map_error<ApiError>().error(), ApiError::Unavailable);
+    Result::Expected<std::string, StoreError> moved = Result::Ok(std::string(64, 'x'));
+    EXPECT_EQ(std::move(moved).map_error<ApiError>().value(), std::string(64, 'x'));
+}
+
+TEST(ErrorMap, UsedByPropagation)
+{
+    EXPECT_EQ(api_get(3).value(), 6);
+    EXPECT_EQ(api_get(-1).error(), ApiError::NotFound);
+    EXPECT_EQ(api_get(0).error(), ApiError::BadRequest);
+}
+#endif
+
+struct Quote {
+    uint64_t id;
+    double price;
+    uint32_t qty;
+};
+enum class FeedError : uint16_t { Stale = 3, Halted };
+using QuoteResult = Result::Expected<Quote, FeedError>;
+
+TEST(Wire, EncodedQuoteIsReadInPlace)
+{
+    static_assert(Result::wire_payload_offset<Quote, FeedError>() == 16, "");
+    static_assert(Result::wire_size<Quote, FeedError>() == 16 + sizeof(Quote), "");
+    alignas(8) unsigned char slot[Result::wire_size<Quote, FeedError>()];
+
+    const QuoteResult quote = Result::Ok(Quote{7, 101.5, 30});
+    ASSERT_EQ(Result::encode(quote, slot, sizeof(slot)).value(), sizeof(slot));
+    const auto view = Result::ExpectedView<Quote, FeedError>::from(slot, sizeof(slot));
+    ASSERT_TRUE(view.is_ok());
+    ASSERT_TRUE(view.value().is_ok());
+    EXPECT_EQ(view.value().value_ptr(), reinterpret_cast<const Quote*>(slot + 16));
+    EXPECT_EQ(view.value().value().id, 7U);
+    EXPECT_EQ(view.value().value().price, 101.5);
+    EXPECT_EQ(view.value().error_ptr(), nullptr);
+
+    const QuoteResult stale = Result::Error(FeedError::Stale);
+    ASSERT_EQ(Result::encode(stale, slot, sizeof(slot)).value(), 16U + sizeof(FeedError));
+    const auto err_view = Result::ExpectedView<Quote, FeedError>::from(slot, 16 + sizeof(FeedError));
+    ASSERT_TRUE(err_view.is_ok());
+    EXPECT_FALSE(err_view.value().is_ok());
+    EXPECT_EQ(err_view.value().error(), FeedError::Stale);
+    const QuoteResult copy = err_view.value();
+    EXPECT_EQ(copy.error(), FeedError::Stale);
+}
+
+TEST(Wire, HeaderIsValidated)
+{
+    using View = Result::ExpectedView<Quote, FeedError>;
+    alignas(8) unsigned char slot[Result::wire_size<Quote, FeedError>() + 8];
+    const QuoteResult quote = Result::Ok(Quote{1, 2.0, 3});
+
+    EXPECT_EQ(Result::encode(quote, slot, 20).error(), Result::WireError::BufferTooSmall);
+    EXPECT_EQ(Result::encode(quote, slot + 4, sizeof(slot) - 4).error(), Result::WireError::Misaligned);
+    ASSERT_TRUE(Result::encode(quote, slot, sizeof(slot)).is_ok());
+
+    EXPECT_EQ(View::from(slot, 8).error(), Result::WireError::BufferTooSmall);
+    EXPECT_EQ(View::from(slot, 20).error(), Result::WireError::BufferTooSmall);
+    EXPECT_EQ((Result::ExpectedView<uint64_t, FeedError>::from(slot, sizeof(slot)).error()),
+              Result::WireError::TypeMismatch);
+
+    unsigned char moved[sizeof(slot) + 8];
+    unsigned char* unaligned = moved + (reinterpret_cast<uintptr_t>(moved) % 8 == 0 ? 4 : 0);
+    std::memcpy(unaligned, slot, sizeof(slot));
+    EXPECT_EQ(View::from(unaligned, sizeof(slot)).error(), Result::WireError::Misaligned);
+
+    slot[5] = 2;
+    EXPECT_EQ(View::from(slot, sizeof(slot)).error(), Result::WireError::BadState);
+    slot[5] = 1;
+    slot[4] = 2;
+    EXPECT_EQ(View::from(slot, sizeof(slot)).error(), Result::WireError::UnsupportedVersion);
+    std::swap(slot[0], slot[3]);
+    std::swap(slot[1], slot[2]);
+    EXPECT_EQ(View::from(slot, sizeof(slot)).error(), Result::WireError::ForeignEndianness);
+    slot[0] = 0;
+    EXPECT_EQ(View::from(slot, sizeof(slot)).error(), Result::WireError::BadMagic);
+}
+
+TEST(Wire, MovedFromIsRejected)
+{
+    alignas(8) unsigned char slot[Result::wire_size<Quote, FeedError>()];
+    QuoteResult quote = Result::Ok(Quote{1, 2.0, 3});
+    static_cast<void>(quote.move_ok());
+    EXPECT_EQ(Result::encode(quote, slot, sizeof(slot)).error(), Result::WireError::MovedFrom);
+}
+
+TEST(Future, ResultSetOnOtherThread)
+{
+    Result::Promise<std::string, int> promise;
+    Result::Future<std::string, int> future = promise.get_future();
+    EXPECT_TRUE(future.valid());
+    EXPECT_FALSE(promise.get_future().valid());
+    std::thread producer([&promise] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        promise.set_value(std::string(64, 'x'));
+    });
+    auto res = future.get();
+    producer.join();
+    EXPECT_FALSE(future.valid());
+    ASSERT_TRUE(res.is_ok());
+    EXPECT_EQ(res.value(), std::string(64, 'x'));
+}
+
+TEST(Future, ErrorAndBrokenPromise)
+{
+    Result::Promise<int, int> failing;
+    auto failed = failing.get_future();
+    failing.set_error(7);
+    EXPECT_TRUE(failed.ready());
+    EXPECT_EQ(failed.get().error(), 7);
+
+    Result::Future<int, int> broken;
+    {
+        Result::Promise<int, int> promise;
+        broken = promise.get_future();
+        EXPECT_FALSE(broken.ready());
+    }
+    auto res = broken.get();
+    ASSERT_FALSE(res.is_ok());
+    EXPECT_EQ(res.error(), 0);
+
+    Result::Promise<int, int> unused;
+    unused.set_value(1);
+}
+
+TEST(Future, InvalidFutureAndUsedUpPromise)
+{
+    Result::Future<int, int, Result::BadAccessNoThrow> invalid;
+    EXPECT_FALSE(invalid.valid());
+    EXPECT_FALSE(invalid.ready());
+    invalid.wait();
+    EXPECT_EQ(invalid.get().error(), 0);
+    auto next = invalid.then([](Result::Expected<int, int, Result::BadAccessNoThrow>&& res) { return res; });
+    EXPECT_FALSE(next.valid());
+
+    Result::Promise<int, int, Result::BadAccessNoThrow> promise;
+    auto future = promise.get_future();
+    EXPECT_TRUE(promise.valid());
+    EXPECT_TRUE(promise.set_value(1));
+    EXPECT_FALSE(promise.valid());
+    EXPECT_FALSE(promise.set_value(2));
+    EXPECT_FALSE(promise.set_error(3));
+    EXPECT_EQ(future.get().value(), 1);
+    EXPECT_FALSE(future.valid());
+    EXPECT_EQ(future.get().error(), 0);
+}
+
+TEST(Future, ContinuationsRunBeforeAndAfterResult)
+{
+    Result::Promise<int, std::string> late;
+    auto chained = late.get_future()
+                       .then([](Result::Expected<int, std::string>&& res) {
+                           return std::move(res).transform([](int val) { return val * 2; });
+                       })
+                       .then([](Result::Expected<int, std::string>&& res) -> Result::Expected<std::string, int> {
+                           if (!res)
+                               return Result::Error(-1);
+                           return Result::Ok(std::to_string(res.value()));
+                       });
+    std::thread producer([&late] { late.set_value(21); });
+    EXPECT_EQ(chained.get().value(), "42");
+    producer.join();
+
+    Result::Promise<int, std::string> early;
+    auto future = early.get_future();
+    early.set_error("offline");
+    auto inline_run = future.then([](Result::Expected<int, std::string>&& res) {
+        return Result::Expected<size_t, std::string>(Result::Ok(res.error().size()));
+    });
+    EXPECT_FALSE(future.valid());
+    EXPECT_TRUE(inline_run.ready());
+    EXPECT_EQ(inline_run.get().value(), 7U);
+}
+
+TEST(Future, PingPongBetweenThreads)
+{
+    constexpr size_t rounds = 1000;
+    std::vector<Result::Promise<int, int>> pings(rounds);
+    std::vector<Result::Promise<int, int>> pongs(rounds);
+    std::vector<Result::Future<int, int>> ping_futures;
+    std::vector<Result::Future<int, int>> pong_futures;
+    for (size_t idx = 0; idx < rounds; ++idx) {
+        ping_futures.push_back(pings[idx].get_future());
+        pong_futures.push_back(pongs[idx].get_future());
+    }
+    std::thread echo([&] {
+        for (size_t idx = 0; idx < rounds; ++idx)
+            pongs[idx].set(ping_futures[idx].get().transform([](int val) { return val + 1; }));
+    });
+    int sum = 0;
+    for (size_t idx = 0; idx < rounds; ++idx) {
+        pings[idx].set_value(static_cast<int>(idx));
+        sum += pong_futures[idx].get().value();
+    }
+    echo.join();
+    EXPECT_EQ(sum, static_cast<int>(rounds * (rounds + 1) / 2));
+}
+
+enum class LookupError { Internal, Database, NoUser };
+
+// Clock of cache tests, moved by hand
+struct ManualClock {
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<ManualClock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() { return time_point(duration(ticks.load())); }
+
+    static inline std::atomic<rep> ticks{0};
+};
+
+using UserCache = Result::ExpectedCache<std::string, int, LookupError, Result::DefaultBadAccess,
+                                        std::hash<std::string>, ManualClock>;
+
+TEST(ExpectedCache, CachesValuesAndSelectedErrors)
+{
+    std::atomic<int> calls{0};
+    UserCache::Options options;
+    options.cache_error = [](LookupError err) { return err != LookupError::Database; };
+    UserCache ids(
+        [&calls](const std::string& name) -> Result::Expected<int, LookupError> {
+            ++calls;
+            if (name == "down")
+                return Result::Error(LookupError::Database);
+            if (name == "ghost")
+                return Result::Error(LookupError::NoUser);
+            return Result::Ok(static_cast<int>(name.size()));
+        },
+        options);
+
+    for (int round = 0; round < 3; ++round) {
+        EXPECT_EQ(ids.get("admin").value(), 5);
+        EXPECT_EQ(ids.get("ghost").error(), LookupError::NoUser);
+        EXPECT_EQ(ids.get("down").error(), LookupError::Database);
+    }
+    EXPECT_EQ(calls.load(), 5);
+    EXPECT_EQ(ids.size(), 2U);
+    const UserCache::Stats stats = ids.stats();
+    EXPECT_EQ(stats.hits, 2U);
+    EXPECT_EQ(stats.negative_hits, 2U);
+    EXPECT_EQ(stats.loads, 5U);
+
+    ids.erase("admin");
+    EXPECT_TRUE(ids.get("admin").is_ok());
+    EXPECT_EQ(calls.load(), 6);
+}
+
+TEST(ExpectedCache, ValuesAndErrorsExpireSeparately)
+{
+    std::atomic<int> calls{0};
+    UserCache::Options options;
+    options.value_ttl = std::chrono::milliseconds(1000);
+    options.error_ttl = std::chrono::milliseconds(100);
+    UserCache ids(
+        [&calls](const std::string& name) -> Result::Expected<int, LookupError> {
+            ++calls;
+            if (name.empty())
+                return Result::Error(LookupError::NoUser);
+            return Result::Ok(1);
+        },
+        options);
+
+    ids.get("admin");
+    ids.get("");
+    EXPECT_EQ(calls.load(), 2);
+    ManualClock::ticks += 500;
+    ids.get("admin");
+    ids.get("");
+    EXPECT_EQ(calls.load(), 3);
+    ManualClock::ticks += 600;
+    ids.get("admin");
+    EXPECT_EQ(calls.load(), 4);
+}
+
+TEST(ExpectedCache, FullShardDropsLeastRecentlyStored)
+{
+    int calls = 0;
+    UserCache::Options options;
+    options.shards = 1;
+    options.capacity = 3;
+    options.value_ttl = std::chrono::milliseconds(1000);
+    UserCache ids(
+        [&calls](const std::string& name) -> Result::Expected<int, LookupError> {
+            ++calls;
+            return Result::Ok(static_cast<int>(name.size()));
+        },
+        options);
+
+    for (const char* name : {"a", "bb", "ccc", "dddd"})
+        ids.get(name);
+    EXPECT_EQ(ids.size(), 3U);
+    ids.get("bb");
+    ids.get("ccc");
+    ids.get("dddd");
+    EXPECT_EQ(calls, 4);
+
+    // "bb" stored again after it expired is the newest one, so "ccc" goes next
+    ManualClock::ticks += 1000;
+    ids.get("bb");
+    ids.get("a");
+    EXPECT_EQ(calls, 6);
+    ids.get("bb");
+    ids.get("a");
+    EXPECT_EQ(calls, 6);
+    ids.get("ccc");
+    EXPECT_EQ(calls, 7);
+    EXPECT_EQ(ids.size(), 3U);
+}
+
+TEST(ExpectedCache, ConcurrentMissesShareOneCall)
+{
+    std::atomic<int> calls{0};
+    std::atomic<bool> release{false};
+    UserCache ids([&](const std::string&) -> Result::Expected<int, LookupError> {
+        ++calls;
+        while (!release.load())
+            std::this_thread::yield();
+        return Result::Error(LookupError::NoUser);
+    });
+
+    std::vector<std::thread> threads;
+    std::atomic<int> failed{0};
+    for (int idx = 0; idx < 4; ++idx) {
+        threads.emplace_back([&] {
+            if (ids.get("ghost").error() == LookupError::NoUser)
+                ++failed;
+        });
+    }
+    while (calls.load() == 0 || ids.stats().coalesced < 3)
+        std::this_thread::yield();
+    release = true;
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_EQ(failed.load(), 4);
+}
+
+#if defined(USE_EXCEPTIONS)
+TEST(ExpectedCache, ThrowingCallReleasesWaiters)
+{
+    std::atomic<int> calls{0};
+    std::atomic<bool> waiting{false};
+    UserCache ids([&](const std::string&) -> Result::Expected<int, LookupError> {
+        if (++calls == 1) {
+            while (!waiting.load())
+                std::this_thread::yield();
+            throw std::runtime_error("backend down");
+        }
+        return Result::Ok(7);
+    });
+
+    int waited = 0;
+    std::thread waiter([&] {
+        while (calls.load() == 0)
+            std::this_thread::yield();
+        waited = ids.get("user").value();
+    });
+    std::thread watcher([&] {
+        while (ids.stats().coalesced == 0)
+            std::this_thread::yield();
+        waiting = true;
+    });
+    EXPECT_THROW(ids.get("user"), std::runtime_error);
+    waiter.join();
+    watcher.join();
+    // Waiter retried with a call of its own, nothing is left in flight
+    EXPECT_EQ(waited, 7);
+    EXPECT_EQ(calls.load(), 2);
+    EXPECT_EQ(ids.get("user").value(), 7);
+}
+#endif
+
+using Fetched = Result::Expected<int, Result::OneOf<StoreError, FeedError>>;
+
+static Fetched fetch_quote(int id)
+{
+    if (id < 0)
+        return Result::Error(StoreError::Missing);
+    if (id == 0)
+        return Result::Error(FeedError::Halted);
+    return Result::Ok(id * 10);
+}
+
+TEST(OneOf, FailureOfEveryListedTypeConverts)
+{
+    static_assert(sizeof(Fetched) == 2 * sizeof(int), "value, errors and one index byte");
+    static_assert(std::is_trivially_copyable<Fetched>::value, "");
+
+    const Fetched missing = fetch_quote(-1);
+    const Fetched halted = fetch_quote(0);
+    const Fetched found = fetch_quote(4);
+    EXPECT_EQ(found.value(), 40);
+    EXPECT_TRUE(missing.holds_error<StoreError>());
+    EXPECT_FALSE(missing.holds_error<FeedError>());
+    const FeedError* feed = halted.error_ptr<FeedError>();
+    ASSERT_NE(feed, nullptr);
+    EXPECT_EQ(*feed, FeedError::Halted);
+    EXPECT_EQ(halted.error_ptr<StoreError>(), nullptr);
+    EXPECT_EQ(halted.error(), FeedError::Halted);
+    EXPECT_EQ(missing.error().index(), 0U);
+    const StoreError* store = missing.error().get_if<StoreError>();
+    ASSERT_NE(store, nullptr);
+    EXPECT_EQ(*store, StoreError::Missing);
+    EXPECT_EQ(found.value_or(1), 40);
+    EXPECT_EQ(halted.value_or(1), 1);
+}
+
+TEST(OneOf, VisitCallsHandlerOfAliveMember)
+{
+    auto describe = [](const Fetched& res) {
+        return res.visit([](int val) { return std::to_string(val); }, [](StoreError) { return std::string("store"); },
+                         [](FeedError) { return std::string("feed"); });
+    };
+    EXPECT_EQ(describe(fetch_quote(2)), "20");
+    EXPECT_EQ(describe(fetch_quote(-1)), "store");
+    EXPECT_EQ(describe(fetch_quote(0)), "feed");
+
+    const int failed = fetch_quote(0).visit([](int) { return 0; }, [](auto) { return 1; });
+    EXPECT_EQ(failed, 1);
+    const Result::OneOf<StoreError, FeedError> err = fetch_quote(-1).error();
+    EXPECT_EQ(err.visit([](StoreError) { return 1; }, [](FeedError) { return 2; }), 1);
+}
+
+using Described = Result::Expected<std::string, Result::OneOf<FeedError, std::string>>;
+
+static Result::Expected<std::string, FeedError> feed_name(int id)
+{
+    if (id == 0)
+        return Result::Error(FeedError::Stale);
+    return Result::Ok(std::string(40, 'f'));
+}
+
+static Described describe_feed(int id)
+{
+    RESULT_TRY_ASSIGN(auto name, feed_name(id));
+    if (id < 0)
+        return Result::Error(std::string(40, 'e'));
+    return Result::Ok(name);
+}
+
+static Result::Expected<size_t, Result::OneOf<FeedError, std::string>> feed_length(int id)
+{
+    RESULT_TRY_ASSIGN(auto name, describe_feed(id));
+    return Result::Ok(name.size());
+}
+
+TEST(OneOf, NonTrivialMembersAndPropagation)
+{
+    Described stale = describe_feed(0);
+    Described error = describe_feed(-1);
+    Described named = describe_feed(1);
+    EXPECT_EQ(stale.error(), FeedError::Stale);
+    const std::string* text = error.error_ptr<std::string>();
+    ASSERT_NE(text, nullptr);
+    EXPECT_EQ(*text, std::string(40, 'e'));
+    EXPECT_EQ(named.value(), std::string(40, 'f'));
+
+    Described copy = error;
+    copy = named;
+    EXPECT_EQ(copy.value(), std::string(40, 'f'));
+    copy = std::move(error);
+    EXPECT_EQ(copy.error(), std::string(40, 'e'));
+    EXPECT_EQ(std::move(named).value(), std::string(40, 'f'));
+
+    EXPECT_EQ(feed_length(1).value(), 40U);
+    EXPECT_EQ(feed_length(-1).error(), std::string(40, 'e'));
+    EXPECT_EQ(feed_length(0).error(), FeedError::Stale);
+}
+
+#if defined(USE_EXCEPTIONS)
+// Copy and move throw when asked to, living instances are counted
+struct Fragile {
+    static int alive;
+    static bool fail;
+    Fragile(int num) : val(num) { ++alive; }
+    Fragile(const Fragile& other) : val(other.val) { check_alive(); }
+    Fragile(Fragile&& other) : val(other.val) { check_alive(); }
+    Fragile& operator=(const Fragile&) = default;
+    ~Fragile() { --alive; }
+    void check_alive()
+    {
+        if (fail)
+            throw std::runtime_error("fragile");
+        ++alive;
+    }
+    int val;
+};
+int Fragile::alive = 0;
+bool Fragile::fail = false;
+
+TEST(OneOf, ThrowingAssignment)
+{
+    using Stored = Result::Expected<Fragile, Result::OneOf<FeedError>>;
+    {
+        Stored target = Result::Ok(Fragile(1));
+        const Stored source = Result::Ok(Fragile(2));
+        Stored moved = Result::Ok(Fragile(3));
+        Fragile::fail = true;
+        // copy is made aside, target keeps its value
+        EXPECT_THROW(target = source, std::runtime_error);
+        EXPECT_EQ(target.value().val, 1);
+        // old value is gone before the move, target holds nothing
+        EXPECT_THROW(target = std::move(moved), std::runtime_error);
+        EXPECT_FALSE(target.is_ok());
+        Fragile::fail = false;
+        target = source;
+        EXPECT_EQ(target.value().val, 2);
+    }
+    EXPECT_EQ(Fragile::alive, 0);
+}
+#endif
+
+// Collects records handed out by flush, restores default reporting when done
+struct DeferredReports {
+    DeferredReports()
+    {
+        Result::flush_bad_access();
+        Result::set_bad_access_handler([this](const Result::BadAccessRecord& rec) {
+            std::lock_guard<std::mutex> lock(mutex);
+            records.push_back(rec);
+        });
+    }
+    ~DeferredReports()
+    {
+        Result::set_bad_access_handler(nullptr);
+        Result::set_bad_access_rate_limit(Result::detail::BadAccessQueue::default_rate_limit);
+    }
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records.size();
+    }
+
+    std::mutex mutex;
+    std::vector<Result::BadAccessRecord> records;
+};
+
+TEST(DeferredBadAccess, QueuedUntilFlush)
+{
+    DeferredReports reports;
+    const Result::Expected<int, int, Result::BadAccessDeferred> res = Result::Error(1);
+    EXPECT_EQ(res.value(), 0);
+    const Result::Expected<std::string, int, Result::BadAccessDeferred> text = Result::Ok(std::string("text"));
+    EXPECT_EQ(text.error(), 0);
+    EXPECT_EQ(reports.size(), 0U);
+
+    EXPECT_EQ(Result::flush_bad_access(), 2U);
+    ASSERT_EQ(reports.size(), 2U);
+    EXPECT_STREQ(reports.records[0].message, "Attempting to get Expected::value()");
+    EXPECT_STREQ(reports.records[1].message, "Attempting to get Expected::error()");
+    EXPECT_STREQ(reports.records[0].type, typeid(int).name());
+    EXPECT_EQ(Result::flush_bad_access(), 0U);
+}
+
+TEST(DeferredBadAccess, RateLimitedPerMessage)
+{
+    DeferredReports reports;
+    Result::set_bad_access_rate_limit(3);
+    const auto before = Result::bad_access_stats();
+    const Result::Expected<int, int, Result::BadAccessDeferred> res = Result::Error(1);
+    for (int idx = 0; idx < 10; ++idx)
+        EXPECT_EQ(res.value(), 0);
+    EXPECT_EQ(res.error(), 1);
+    EXPECT_EQ(Result::bad_access_stats().suppressed - before.suppressed, 7U);
+
+    // new window after each flush
+    EXPECT_EQ(Result::flush_bad_access(), 3U);
+    EXPECT_EQ(res.value(), 0);
+    EXPECT_EQ(Result::flush_bad_access(), 1U);
+}
+
+TEST(DeferredBadAccess, FullRingDropsReports)
+{
+    DeferredReports reports;
+    Result::set_bad_access_rate_limit(UINT32_MAX);
+    const auto before = Result::bad_access_stats();
+    const Result::Expected<int, int, Result::BadAccessDeferred> res = Result::Error(1);
+    for (size_t idx = 0; idx < Result::detail::BadAccessQueue::capacity + 10; ++idx)
+        EXPECT_EQ(res.value(), 0);
+    EXPECT_EQ(Result::bad_access_stats().dropped - before.dropped, 10U);
+    EXPECT_EQ(Result::flush_bad_access(), Result::detail::BadAccessQueue::capacity);
+}
+
+TEST(DeferredBadAccess, ReportedFromManyThreads)
+{
+    DeferredReports reports;
+    Result::set_bad_access_rate_limit(UINT32_MAX);
+    std::vector<std::thread> threads;
+    for (int worker = 0; worker < 4; ++worker) {
+        threads.emplace_back([] {
+            Result::ResultVector<int, int, Result::BadAccessDeferred> vec;
+            vec.push_back(Result::Error(1));
+            for (int idx = 0; idx < 100; ++idx)
+                EXPECT_EQ(vec[0].value(), 0);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(Result::flush_bad_access(), 400U);
+    EXPECT_STREQ(reports.records.back().message, "Attempting to get ResultVector value()");
+}
+
+TEST(DeferredBadAccess, DrainerFlushesInBackground)
+{
+    DeferredReports reports;
+    {
+        Result::BadAccessDrainer drainer(std::chrono::milliseconds(1));
+        const Result::Expected<int, int, Result::BadAccessDeferred> res = Result::Error(1);
+        EXPECT_EQ(res.value(), 0);
+        for (int wait = 0; wait < 1000 && reports.size() == 0; ++wait)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        EXPECT_EQ(reports.size(), 1U);
+        EXPECT_EQ(res.value(), 0);
+    }
+    // remaining reports are flushed by destructor
+    EXPECT_EQ(reports.size(), 2U);
+}
+
+#if defined(RESULT_TELEMETRY)
+// Count of event summed over callsites of this file, or at given line only
+static uint64_t telemetry_count(Result::telemetry::Event event, unsigned line = 0)
+{
+    uint64_t total = 0;
+    for (const auto& rec : Result::telemetry::snapshot()) {
+        if (rec.event == event && rec.file != nullptr && std::strstr(rec.file, "main.cc") != nullptr &&
+            (line == 0 || rec.line == line))
+            total += rec.count;
+    }
+    return total;
+}
+
+static const unsigned telemetry_failure_line = __LINE__ + 4;
+static Result::Expected<int, ErrorCode> telemetry_parse(int val)
+{
+    if (val < 0)
+        return Result::Error(ErrorCode::Any);
+    return Result::Ok(val);
+}
+
+TEST(Telemetry, FailuresCountedAtCallsite)
+{
+    using Result::telemetry::Event;
+    const auto before = telemetry_count(Event::Failure, telemetry_failure_line);
+    for (int idx = -5; idx < 5; ++idx)
+        telemetry_parse(idx);
+    EXPECT_EQ(telemetry_count(Event::Failure, telemetry_failure_line) - before, 5U);
+
+    const auto snapshot = Result::telemetry::snapshot();
+    const auto rec = std::find_if(snapshot.begin(), snapshot.end(), [](const Result::telemetry::Record& entry) {
+        return entry.event == Event::Failure && entry.line == telemetry_failure_line;
+    });
+    ASSERT_NE(rec, snapshot.end());
+    EXPECT_STREQ(rec->type, Result::telemetry::type_name<ErrorCode>());
+}
+
+TEST(Telemetry, ConversionIsNotAnotherFailure)
+{
+    using Result::telemetry::Event;
+    const auto before = telemetry_count(Event::Failure);
+    const Result::Expected<long, long> res = Result::Error(3);
+    EXPECT_EQ(telemetry_count(Event::Failure) - before, 1U);
+    EXPECT_EQ(telemetry_count(Event::Failure, __LINE__ - 2), 1U);
+    EXPECT_EQ(res.error(), 3);
+}
+
+TEST(Telemetry, BadAccessCountedAtAccessor)
+{
+    using Result::telemetry::Event;
+    const Result::Expected<int, int, Result::BadAccessNoThrow> res = Result::Error(1);
+    const auto before = telemetry_count(Event::BadAccess);
+    EXPECT_EQ(res.value(), 0);
+    EXPECT_EQ(telemetry_count(Event::BadAccess) - before, 1U);
+    EXPECT_EQ(telemetry_count(Event::BadAccess, __LINE__ - 2), 1U);
+}
+
+TEST(Telemetry, ExitedThreadsAreKept)
+{
+    using Result::telemetry::Event;
+    const auto before = telemetry_count(Event::Failure, telemetry_failure_line);
+    std::vector<std::thread> threads;
+    for (int worker = 0; worker < 4; ++worker) {
+        threads.emplace_back([] {
+            for (int idx = 0; idx < 1000; ++idx)
+                telemetry_parse(-1);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(telemetry_count(Event::Failure, telemetry_failure_line) - before, 4000U);
+}
+
+TEST(Telemetry, OverflowIsKeptPerEvent)
+{
+    using Result::telemetry::Event;
+    auto overflow = [](Event event) {
+        uint64_t total = 0;
+        for (const auto& rec : Result::telemetry::snapshot()) {
+            if (rec.event == event && rec.file == nullptr)
+                total += rec.count;
+        }
+        return total;
+    };
+    const auto failures = overflow(Event::Failure);
+    const auto accesses = overflow(Event::BadAccess);
+    // fresh thread has an empty table, every callsite past its capacity overflows
+    std::thread([] {
+        const unsigned sites = Result::telemetry::detail::ThreadCounters::capacity + 10;
+        for (unsigned line = 1; line <= sites; ++line)
+            Result::telemetry::record(Event::BadAccess, Result::telemetry::Callsite{"overflow.cc", line}, "int");
+    }).join();
+    EXPECT_EQ(overflow(Event::BadAccess) - accesses, 10U);
+    EXPECT_EQ(overflow(Event::Failure) - failures, 0U);
+}
+#endif
+
+#if defined(RESULT_HAS_RANGES)
+enum class StreamError { End, Malformed };
+
+// Counts how many times this instance was moved since it was built, copies are not allowed
+struct Hop {
+    explicit Hop(int val) : _val(val), _moves(0) {}
+    Hop(const Hop&) = delete;
+    Hop(Hop&& other) noexcept : _val(other._val), _moves(other._moves + 1) {}
+    Hop& operator=(Hop&& other) noexcept
+    {
+        _val = other._val;
+        _moves = other._moves + 1;
+        return *this;
+    }
+    int _val;
+    int _moves;
+};
+
+TEST(Views, GenerateUntilErrorKeepsTerminatingError)
+{
+    int next = 0;
+    auto numbers = Result::views::generate_until_error([&next]() -> Result::Expected<Hop, StreamError> {
+        if (next == 4)
+            return Result::Expected<Hop, StreamError>(Result::unexpect, StreamError::End);
+        return Result::Expected<Hop, StreamError>(Result::in_place, next++);
+    });
+    EXPECT_EQ(numbers.error_ptr(), nullptr);
+    std::vector<int> seen;
+    for (Hop&& hop : std::ranges::ref_view(numbers) | std::views::take(10)) {
+        EXPECT_EQ(hop._moves, 0);
+        const Hop taken(std::move(hop));
+        seen.push_back(taken._val);
+    }
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 3}));
+    const StreamError* end = numbers.error_ptr();
+    ASSERT_NE(end, nullptr);
+    EXPECT_EQ(*end, StreamError::End);
+}
+
+TEST(Views, FilterErrorsAndTakeWhileOk)
+{
+    using Res = Result::Expected<int, StreamError>;
+    std::vector<Res> input;
+    input.emplace_back(Result::Ok(1));
+    input.emplace_back(Result::Error(StreamError::Malformed));
+    input.emplace_back(Result::Ok(2));
+    input.emplace_back(Result::Error(StreamError::End));
+    input.emplace_back(Result::Ok(3));
+
+    std::vector<int> values;
+    for (int& val : input | Result::views::filter_ok)
+        values.push_back(val);
+    EXPECT_EQ(values, (std::vector<int>{1, 2, 3}));
+
+    std::vector<StreamError> errors;
+    for (StreamError err : input | Result::views::errors)
+        errors.push_back(err);
+    EXPECT_EQ(errors, (std::vector<StreamError>{StreamError::Malformed, StreamError::End}));
+
+    auto doubled = input | Result::views::transform_ok([](int val) { return val * 2; }) | std::views::drop(2) |
+                   Result::views::take_while_ok;
+    values.clear();
+    for (int&& val : doubled)
+        values.push_back(val);
+    EXPECT_EQ(values, (std::vector<int>{4}));
+    const StreamError* stop = doubled.error_ptr();
+    ASSERT_NE(stop, nullptr);
+    EXPECT_EQ(*stop, StreamError::End);
+
+    auto all = input | Result::views::filter_ok | std::views::take(1);
+    EXPECT_EQ(*all.begin(), 1);
+}
+
+TEST(Views, PayloadIsMovedOnlyByConsumer)
+{
+    auto make = [](int idx) {
+        return idx % 2 == 0 ? Result::Expected<Hop, StreamError>(Result::in_place, idx)
+                            : Result::Expected<Hop, StreamError>(Result::unexpect, StreamError::Malformed);
+    };
+    int taken = 0;
+    for (Hop&& hop : std::views::iota(0, 6) | std::views::transform(make) | Result::views::filter_ok) {
+        EXPECT_EQ(hop._moves, 0);
+        const Hop out(std::move(hop));
+        EXPECT_EQ(out._moves, 1);
+        ++taken;
+    }
+    EXPECT_EQ(taken, 3);
+
+    auto stage = [](Hop&& hop) {
+        EXPECT_EQ(hop._moves, 0);
+        return hop._val + 1;
+    };
+    auto limited = std::views::iota(0, 6) | std::views::transform(make) | Result::views::transform_ok(stage) |
+                   Result::views::take_while_ok;
+    std::vector<int> values;
+    for (int val : limited)
+        values.push_back(val);
+    EXPECT_EQ(values, (std::vector<int>{1}));
+    const StreamError* stop = limited.error_ptr();
+    ASSERT_NE(stop, nullptr);
+    EXPECT_EQ(*stop, StreamError::Malformed);
+}
+#endif
+
+#if defined(RESULT_HAS_IO)
+// Temporary file with given content, removed by the caller
+static std::string write_temp_file(const std::string& text)
+{
+    char path[] = "/tmp/result_io_XXXXXX";
+    const int fd = mkstemp(path);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(write(fd, text.data(), text.size()), static_cast<ssize_t>(text.size()));
+    close(fd);
+    return path;
+}
+
+// Lines until Eof or Failure, skipped long lines as "<too long>"
+static std::vector<std::string> read_lines(Result::io::LineReader& reader)
+{
+    std::vector<std::string> lines;
+    while (true) {
+        auto line = reader.next();
+        if (line)
+            lines.emplace_back(line.value());
+        else if (line.error() == Result::io::IoError::LineTooLong)
+            lines.emplace_back("<too long>");
+        else
+            break;
+    }
+    return lines;
+}
+
+TEST(LineReader, MappedAndBufferedReadSameLines)
+{
+    const std::string path = write_temp_file("alpha\nbeta\n\n" + std::string(20, 'x') + "\ngamma\r\nlast");
+    const std::vector<std::string> expected{"alpha", "beta", "", "<too long>", "gamma\r", "last"};
+    Result::io::LineReader::Options opts;
+    opts.max_line = 8;
+    auto mapped = Result::io::LineReader::open(path.c_str(), opts);
+    Result::io::LineReader* reader = mapped.value_ptr();
+    ASSERT_NE(reader, nullptr);
+    EXPECT_TRUE(reader->mapped());
+    EXPECT_EQ(read_lines(*reader), expected);
+    EXPECT_EQ(reader->next().error(), Result::io::IoError::Eof);
+
+    opts.map_files = false;
+    opts.block_size = 3;
+    auto buffered = Result::io::LineReader::open(path.c_str(), opts);
+    reader = buffered.value_ptr();
+    ASSERT_NE(reader, nullptr);
+    EXPECT_FALSE(reader->mapped());
+    EXPECT_EQ(read_lines(*reader), expected);
+    EXPECT_EQ(reader->next().error(), Result::io::IoError::Eof);
+    std::remove(path.c_str());
+}
+
+TEST(LineReader, PipeIsReadInBlocks)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    const std::string text = "first\nsecond line\n" + std::string(40, 'y');
+    ASSERT_EQ(write(fds[1], text.data(), text.size()), static_cast<ssize_t>(text.size()));
+    close(fds[1]);
+    Result::io::LineReader::Options opts;
+    opts.max_line = 16;
+    opts.block_size = 4;
+    auto reader = Result::io::LineReader::from_fd(fds[0], opts);
+    ASSERT_TRUE(reader);
+    Result::io::LineReader lines = reader.move_ok();
+    EXPECT_FALSE(lines.mapped());
+    EXPECT_EQ(read_lines(lines), (std::vector<std::string>{"first", "second line", "<too long>"}));
+    close(fds[0]);
+
+    const Result::io::LineReader taken(std::move(lines));
+    auto line = lines.next();
+    ASSERT_FALSE(line);
+    EXPECT_EQ(line.error(), Result::io::IoError::Failure);
+    EXPECT_EQ(lines.last_errno(), EBADF);
+}
+
+TEST(LineReader, OpenFailureKeepsErrno)
+{
+    auto reader = Result::io::LineReader::open("/nonexistent/result_io");
+    ASSERT_FALSE(reader);
+    EXPECT_EQ(reader.error(), Result::io::IoError::Failure);
+    EXPECT_EQ(errno, ENOENT);
+}
+#endif
+
 // int main(int argc, char** argv)
 //{
 //     ::testing::InitGoogleTest(&argc, argv);
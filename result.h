@@ -1,7 +1,11 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
 #include <new>
 #include <type_traits>
 #include <utility>
@@ -10,6 +14,44 @@
 #include <stdexcept>
 #endif
 
+// constexpr of functions with statements or non-const members (C++14)
+#if __cplusplus >= 201402L
+#define RESULT_CONSTEXPR14 constexpr
+#else
+#define RESULT_CONSTEXPR14
+#endif
+
+// constexpr destructors and std::construct_at (C++20), needed to replace or destroy payload at compile time
+#if defined(__cpp_constexpr_dynamic_alloc) && defined(__cpp_lib_constexpr_dynamic_alloc)
+#define RESULT_HAS_CONSTEXPR20 1
+#define RESULT_CONSTEXPR20 constexpr
+#else
+#define RESULT_HAS_CONSTEXPR20 0
+#define RESULT_CONSTEXPR20
+#endif
+
+// requires-clauses and if constexpr in place of enable_if overload pairs and conditionally trivial special members
+// (C++20, P0848), so every Expected specialization instantiates fewer templates
+#if defined(__cpp_concepts) && __cpp_concepts >= 202002L
+#define RESULT_HAS_CONCEPTS 1
+#else
+#define RESULT_HAS_CONCEPTS 0
+#endif
+
+// Opt-in failure telemetry, accessors and Failure get a defaulted callsite parameter (see result_telemetry.h)
+#if defined(RESULT_TELEMETRY)
+#include "result_telemetry.h"
+#define RESULT_TELEMETRY_SITE_PARAM ::Result::telemetry::Callsite site = ::Result::telemetry::Callsite::current()
+#define RESULT_TELEMETRY_AND_SITE_PARAM , RESULT_TELEMETRY_SITE_PARAM
+#define RESULT_TELEMETRY_AND_SITE , site
+#define RESULT_TELEMETRY_AND_NO_SITE , ::Result::telemetry::Callsite{nullptr, 0}
+#else
+#define RESULT_TELEMETRY_SITE_PARAM
+#define RESULT_TELEMETRY_AND_SITE_PARAM
+#define RESULT_TELEMETRY_AND_SITE
+#define RESULT_TELEMETRY_AND_NO_SITE
+#endif
+
 namespace detail
 {
 template <typename From, typename To, typename = void>
@@ -38,6 +80,9 @@ struct BadAccessNoThrow {
 };
 struct BadAccessTerminate {
 };
+// Like BadAccessNoThrow, but message is queued and written later by result_report.h instead of stderr
+struct BadAccessDeferred {
+};
 #if defined(USE_EXCEPTIONS)
 struct BadAccessThrow {
 };
@@ -47,40 +92,166 @@ using DefaultBadAccess = BadAccessNoThrow;
 #endif
 
 struct EmptyValue {
-    bool operator==(const EmptyValue&) const noexcept(true) { return true; }
+    constexpr bool operator==(const EmptyValue&) const noexcept(true) { return true; }
 };
 struct SimpleError {
-    bool operator==(const SimpleError&) const noexcept(true) { return true; }
+    constexpr bool operator==(const SimpleError&) const noexcept(true) { return true; }
+};
+
+// Tags selecting which side of Expected is constructed in place from the remaining arguments
+struct in_place_t {
+    explicit in_place_t() = default;
+};
+struct unexpect_t {
+    explicit unexpect_t() = default;
 };
+constexpr in_place_t in_place{};
+constexpr unexpect_t unexpect{};
 
 template <typename, typename, typename>
 struct Expected;
 
+namespace detail
+{
+// Error types built from errors of other types, like AnyError of result_any_error.h or OneOf of result_one_of.h.
+// Failure of a type they can be built from converts to them, as any Failure does to Failure<SimpleError>.
+template <typename T>
+struct is_widening_error : std::false_type {
+};
+}  // namespace detail
+
+// Translation of one error enum into another, declared with RESULT_MAP_ERRORS (C++14):
+//     RESULT_MAP_ERRORS(DbError, ServiceError, {{DbError::Timeout, ServiceError::Unavailable},
+//                                               {DbError::Constraint, ServiceError::BadRequest}});
+// Values of From are indices of a dense table, every value from 0 to the largest one has to be mapped exactly
+// once, which is checked at compile time. Then Failure<DbError>::cast_to<ServiceError>(), map_error() and
+// RESULT_TRY translate errors with one table load.
+template <typename From, typename To>
+struct error_map {
+    static constexpr bool available = false;
+};
+
+namespace detail
+{
+template <typename From, typename To>
+struct ErrorMapping {
+    From from;
+    To to;
+};
+
+template <typename To, size_t Size>
+struct ErrorTable {
+    To values[Size];
+};
+
+template <typename From, typename To>
+struct ErrorTableOf;
+
+#if __cplusplus >= 201402L
+template <typename From, typename To, size_t N>
+constexpr size_t error_table_size(const ErrorMapping<From, To> (&pairs)[N]) noexcept(true)
+{
+    size_t size = 0;
+    for (size_t idx = 0; idx < N; ++idx) {
+        if (static_cast<size_t>(pairs[idx].from) + 1 > size)
+            size = static_cast<size_t>(pairs[idx].from) + 1;
+    }
+    return size;
+}
+
+template <typename From, typename To, size_t N>
+constexpr bool maps_every_error(const ErrorMapping<From, To> (&pairs)[N]) noexcept(true)
+{
+    const size_t size = error_table_size(pairs);
+    if (size != N)
+        return false;
+    for (size_t value = 0; value < size; ++value) {
+        size_t found = 0;
+        for (size_t idx = 0; idx < N; ++idx)
+            found += static_cast<size_t>(pairs[idx].from) == value ? 1 : 0;
+        if (found != 1)
+            return false;
+    }
+    return true;
+}
+
+template <size_t Size, typename From, typename To, size_t N>
+constexpr ErrorTable<To, Size> make_error_table(const ErrorMapping<From, To> (&pairs)[N]) noexcept(true)
+{
+    ErrorTable<To, Size> table{};
+    for (size_t idx = 0; idx < N; ++idx)
+        table.values[static_cast<size_t>(pairs[idx].from)] = pairs[idx].to;
+    return table;
+}
+
+template <typename From, typename To>
+struct ErrorTableOf {
+    static constexpr size_t size = error_table_size(error_map<From, To>::pairs);
+    static constexpr ErrorTable<To, size> table = make_error_table<size>(error_map<From, To>::pairs);
+};
+
+template <typename From, typename To>
+constexpr size_t ErrorTableOf<From, To>::size;
+
+template <typename From, typename To>
+constexpr ErrorTable<To, ErrorTableOf<From, To>::size> ErrorTableOf<From, To>::table;
+#endif
+}  // namespace detail
+
+// Error translated by its RESULT_MAP_ERRORS table, err has to be one of mapped values
+template <typename To, typename From>
+constexpr To map_error(From err) noexcept(true)
+{
+    static_assert(error_map<From, To>::available, "no RESULT_MAP_ERRORS declared for these error types");
+    return detail::ErrorTableOf<From, To>::table.values[static_cast<size_t>(err)];
+}
+
 template <typename Value = EmptyValue>
 struct Success {
     using ok_t = Value;
 
-    Success(const ok_t& value) : _value(value) {}
-
-    Success(ok_t&& value) : _value(std::move(value)) {}
+    template <typename U = ok_t, typename std::enable_if<std::is_constructible<ok_t, U&&>::value, bool>::type = true>
+    constexpr Success(U&& value) : _value(std::forward<U>(value))
+    {
+    }
 
-    const Value& value() const noexcept(true) { return _value; }
+    constexpr const Value& value() const noexcept(true) { return _value; }
 
-    Value&& move() noexcept(std::is_move_assignable<Value>::value) { return std::move(_value); }
+    RESULT_CONSTEXPR14 Value&& move() noexcept(std::is_move_assignable<Value>::value)
+    {
+        return static_cast<Value&&>(_value);
+    }
 
     template <typename T, typename std::enable_if<!is_narrowing_conversion<ok_t, T>::value, Value>::type* = nullptr>
-    auto cast_to() const noexcept(std::is_copy_constructible<Success<T>>::value) -> Success<T>
+    RESULT_CONSTEXPR14 auto cast_to() const& noexcept(std::is_nothrow_constructible<T, const ok_t&>::value)
+        -> Success<T>
     {
         return Success<T>(_value);
     }
 
-    template <typename T, typename U = SimpleError, typename V = DefaultBadAccess>
-    operator Expected<T, U, V>() const noexcept(noexcept(cast_to<T>()))
+    template <typename T, typename std::enable_if<!is_narrowing_conversion<ok_t, T>::value, Value>::type* = nullptr>
+    RESULT_CONSTEXPR14 auto cast_to() && noexcept(std::is_nothrow_constructible<T, ok_t&&>::value) -> Success<T>
+    {
+        return Success<T>(std::move(_value));
+    }
+
+    template <typename T, typename U = SimpleError, typename V = DefaultBadAccess,
+              typename std::enable_if<!std::is_same<T, ok_t>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 operator Expected<T, U, V>() const& noexcept(
+        noexcept(std::declval<const Success&>().template cast_to<T>()))
     {
         return Expected<T, U, V>(cast_to<T>());
     }
 
-    explicit operator bool() const noexcept(true) { return true; }
+    template <typename T, typename U = SimpleError, typename V = DefaultBadAccess,
+              typename std::enable_if<!std::is_same<T, ok_t>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 operator Expected<T, U, V>() && noexcept(
+        noexcept(std::declval<Success&&>().template cast_to<T>()))
+    {
+        return Expected<T, U, V>(std::move(*this).template cast_to<T>());
+    }
+
+    constexpr explicit operator bool() const noexcept(true) { return true; }
 
 private:
     ok_t _value;
@@ -90,32 +261,108 @@ template <typename ErrorType = SimpleError>
 struct Failure {
     using err_t = ErrorType;
 
-    Failure(const err_t& error) : _error(error) {}
+#if defined(RESULT_TELEMETRY)
+    template <typename U = err_t, typename std::enable_if<std::is_constructible<err_t, U&&>::value, bool>::type = true>
+    constexpr Failure(U&& error, RESULT_TELEMETRY_SITE_PARAM)
+        : _error((static_cast<void>(telemetry::note_failure<err_t>(site)), std::forward<U>(error)))
+    {
+    }
+#else
+    template <typename U = err_t, typename std::enable_if<std::is_constructible<err_t, U&&>::value, bool>::type = true>
+    constexpr Failure(U&& error) : _error(std::forward<U>(error))
+    {
+    }
+#endif
+
+    constexpr const ErrorType& error() const noexcept(true) { return _error; }
+
+    RESULT_CONSTEXPR14 ErrorType&& move() noexcept(std::is_move_constructible<err_t>::value)
+    {
+        return static_cast<ErrorType&&>(_error);
+    }
 
-    Failure(err_t&& error) : _error(std::move(error)) {}
+    template <typename T,
+              typename std::enable_if<std::is_same<typename std::common_type<T, err_t>::type, T>::value &&
+                                          !error_map<err_t, T>::available,
+                                      ErrorType>::type* = nullptr>
+    RESULT_CONSTEXPR14 auto cast_to() const& noexcept(std::is_nothrow_constructible<T, const err_t&>::value)
+        -> Failure<T>
+    {
+        return Failure<T>(_error RESULT_TELEMETRY_AND_NO_SITE);
+    }
 
-    const ErrorType& error() const noexcept(true) { return _error; }
+    template <typename T,
+              typename std::enable_if<std::is_same<typename std::common_type<T, err_t>::type, T>::value &&
+                                          !error_map<err_t, T>::available,
+                                      ErrorType>::type* = nullptr>
+    RESULT_CONSTEXPR14 auto cast_to() && noexcept(std::is_nothrow_constructible<T, err_t&&>::value) -> Failure<T>
+    {
+        return Failure<T>(std::move(_error) RESULT_TELEMETRY_AND_NO_SITE);
+    }
 
-    ErrorType&& move() noexcept(std::is_move_constructible<err_t>::value) { return std::move(_error); }
+    // Translation declared with RESULT_MAP_ERRORS
+    template <typename T, typename std::enable_if<error_map<err_t, T>::available, bool>::type = true>
+    constexpr auto cast_to() const noexcept(true) -> Failure<T>
+    {
+        return Failure<T>(map_error<T>(_error) RESULT_TELEMETRY_AND_NO_SITE);
+    }
 
-    template <typename T, typename std::enable_if<std::is_same<typename std::common_type<T, err_t>::type, T>::value,
-                                                  ErrorType>::type* = nullptr>
-    auto cast_to() const noexcept(std::is_copy_constructible<Failure<T>>::value) -> Failure<T>
+    template <typename T, typename U, typename V,
+              typename std::enable_if<std::is_same<typename std::common_type<T, err_t>::type, T>::value,
+                                      ErrorType>::type* = nullptr,
+              typename std::enable_if<!std::is_same<U, err_t>::value && !detail::is_widening_error<U>::value &&
+                                          !error_map<err_t, U>::available,
+                                      bool>::type = true>
+    RESULT_CONSTEXPR14 operator Expected<T, U, V>() const& noexcept(
+        noexcept(std::declval<const Failure&>().template cast_to<U>()))
     {
-        return Failure<T>(_error);
+        return Expected<T, U, V>(cast_to<U>());
     }
 
     template <typename T, typename U, typename V,
               typename std::enable_if<std::is_same<typename std::common_type<T, err_t>::type, T>::value,
-                                      ErrorType>::type* = nullptr>
-    operator Expected<T, U, V>() const noexcept(noexcept(cast_to<U>()))
+                                      ErrorType>::type* = nullptr,
+              typename std::enable_if<!std::is_same<U, err_t>::value && !detail::is_widening_error<U>::value &&
+                                          !error_map<err_t, U>::available,
+                                      bool>::type = true>
+    RESULT_CONSTEXPR14 operator Expected<T, U, V>() && noexcept(
+        noexcept(std::declval<Failure&&>().template cast_to<U>()))
+    {
+        return Expected<T, U, V>(std::move(*this).template cast_to<U>());
+    }
+
+    template <typename T, typename U, typename V,
+              typename std::enable_if<error_map<err_t, U>::available, bool>::type = true>
+    constexpr operator Expected<T, U, V>() const noexcept(true)
     {
         return Expected<T, U, V>(cast_to<U>());
     }
 
-    operator Failure<SimpleError>() const noexcept(true) { return Failure<SimpleError>({}); }
+    constexpr operator Failure<SimpleError>() const noexcept(true)
+    {
+        return Failure<SimpleError>({} RESULT_TELEMETRY_AND_NO_SITE);
+    }
+
+    template <typename U,
+              typename std::enable_if<detail::is_widening_error<U>::value && !std::is_same<U, err_t>::value &&
+                                          std::is_constructible<U, const err_t&>::value,
+                                      bool>::type = true>
+    RESULT_CONSTEXPR14 operator Failure<U>() const noexcept(std::is_nothrow_constructible<U, const err_t&>::value)
+    {
+        return Failure<U>(U(_error) RESULT_TELEMETRY_AND_NO_SITE);
+    }
+
+    template <typename T, typename U, typename V,
+              typename std::enable_if<detail::is_widening_error<U>::value && !std::is_same<U, err_t>::value &&
+                                          std::is_constructible<U, const err_t&>::value,
+                                      bool>::type = true>
+    RESULT_CONSTEXPR14 operator Expected<T, U, V>() const
+        noexcept(std::is_nothrow_constructible<U, const err_t&>::value)
+    {
+        return Expected<T, U, V>(unexpect, _error);
+    }
 
-    explicit operator bool() const noexcept(true) { return false; }
+    constexpr explicit operator bool() const noexcept(true) { return false; }
 
 private:
     err_t _error;
@@ -130,201 +377,1680 @@ constexpr size_t size_of()
 template <typename T, typename U>
 constexpr size_t align_of()
 {
-    return sizeof(T) > sizeof(U) ? alignof(T) : alignof(U);
+    return alignof(T) > alignof(U) ? alignof(T) : alignof(U);
 }
 
-template <typename Value = EmptyValue, typename ErrorType = SimpleError, typename BadAccess = DefaultBadAccess>
-struct Expected {
-public:
-    using ok_t = Value;
-    using err_t = ErrorType;
-    using access_t = BadAccess;
-    static_assert(!std::is_same<err_t, void>::value, "void error type is not allowed");
-    static constexpr size_t _size = size_of<ok_t, err_t>();
-    static constexpr size_t _align = align_of<ok_t, err_t>();
+// Opt-in description of a bit pattern that type never uses for a real value. When one side of an Expected
+// has such pattern and the other one is empty, the pattern marks the other side and no discriminant is stored,
+// e.g. Expected<Enum, SimpleError> is as big as the enum. Specialization has to provide:
+//     static constexpr bool available = true;
+//     static T niche() noexcept;                  // value with the spare pattern
+//     static bool is_niche(const T& v) noexcept;  // true if v holds the spare pattern
+// Both may be constexpr, such Expected can be then used in constant expressions.
+// Type with niche must be trivially copyable, moving it out does not consume it, so such Expected does not
+// track moved state.
+template <typename T, typename = void>
+struct niche_traits {
+    static constexpr bool available = false;
+};
+
+
+// Helper for enums with a declared unused value
+//     template <> struct Result::niche_traits<DbError> : Result::enum_niche<DbError, DbError::Unused> {};
+template <typename Enum, Enum Unused>
+struct enum_niche {
+    static_assert(std::is_enum<Enum>::value, "enum_niche can be used only with enums");
+    static constexpr bool available = true;
+    static constexpr Enum niche() noexcept(true) { return Unused; }
+    static constexpr bool is_niche(const Enum& val) noexcept(true) { return val == Unused; }
+};
+
+// Helper for pointers, which are never valid in the first page, address 1 is used as spare pattern (nullptr stays
+// a valid value). It needs reinterpret_cast, so such Expected can not be constexpr.
+//     template <> struct Result::niche_traits<Node*> : Result::pointer_niche<Node> {};
+template <typename T>
+struct pointer_niche {
+    static constexpr bool available = true;
+    static T* niche() noexcept(true) { return reinterpret_cast<T*>(static_cast<std::uintptr_t>(1)); }
+    static bool is_niche(T* const& ptr) noexcept(true) { return ptr == niche(); }
+};
+
+namespace detail
+{
+// Reference payload of Expected<T&, E> is kept as a rebindable pointer
+template <typename T>
+struct RefHolder {
+    constexpr RefHolder(T& ref) noexcept(true) : _ptr(&ref) {}
+    constexpr T& get() const noexcept(true) { return *_ptr; }
+    static constexpr RefHolder null() noexcept(true) { return RefHolder(); }
+    constexpr bool is_null() const noexcept(true) { return _ptr == nullptr; }
+
+private:
+    constexpr RefHolder() noexcept(true) : _ptr(nullptr) {}
+    T* _ptr;
+};
+
+template <typename T>
+struct stored {
+    using type = T;
+};
+
+template <typename T>
+struct stored<T&> {
+    using type = RefHolder<T>;
+};
+
+template <typename T>
+using stored_t = typename stored<T>::type;
+
+template <typename T>
+constexpr T& unwrap(T& val) noexcept(true)
+{
+    return val;
+}
+
+template <typename T>
+constexpr const T& unwrap(const T& val) noexcept(true)
+{
+    return val;
+}
+
+template <typename T>
+constexpr T& unwrap(RefHolder<T>& ref) noexcept(true)
+{
+    return ref.get();
+}
+
+template <typename T>
+constexpr T& unwrap(const RefHolder<T>& ref) noexcept(true)
+{
+    return ref.get();
+}
+
+template <typename T>
+struct unwrap_ref_decay {
+    using type = typename std::decay<T>::type;
+};
+
+template <typename T>
+struct unwrap_ref_decay<std::reference_wrapper<T>> {
+    using type = T&;
+};
+
+template <typename T>
+using unwrap_ref_decay_t = typename unwrap_ref_decay<typename std::decay<T>::type>::type;
+
+// Policies which return default instance on bad access instead of leaving the accessor
+template <typename Access>
+struct recovers_from_bad_access
+    : std::integral_constant<bool, std::is_same<Access, BadAccessNoThrow>::value ||
+                                       std::is_same<Access, BadAccessDeferred>::value> {
+};
+
+#if RESULT_HAS_CONCEPTS
+// Accessor can be called: policy leaves it on bad access or there is a default instance to return
+template <typename Access, typename T>
+concept accessible_under = !recovers_from_bad_access<Access>::value || std::is_default_constructible<T>::value;
+#endif
+
+// Caller of the function which uses it, to tell where bad access happened
+#if defined(__GNUC__) || defined(__clang__)
+#define RESULT_RETURN_ADDRESS() __builtin_return_address(0)
+#else
+#define RESULT_RETURN_ADDRESS() static_cast<const void*>(nullptr)
+#endif
+
+// Writes bad access message of Expected with given error type
+template <typename Access>
+struct bad_access_reporter {
+    template <typename ErrorType>
+    static void report(const char* str, const void*) noexcept(true)
+    {
+        fprintf(stderr, "%s\n", str);
+    }
+};
+// Queue of deferred reports, defined in result_report.h
+template <>
+struct bad_access_reporter<BadAccessDeferred>;
+
+// Instance returned by BadAccessNoThrow accessors when there is nothing to return
+template <typename T>
+const T& default_instance() noexcept(std::is_nothrow_default_constructible<T>::value)
+{
+    static const T instance{};
+    return instance;
+}
+
+struct ok_tag_t {
+};
+struct err_tag_t {
+};
+struct copy_tag_t {
+};
+// Nothing is constructed yet, owner constructs the whole object in place before it is used or destroyed
+struct unset_tag_t {
+};
+
+#if __cplusplus >= 201402L
+template <typename T>
+using is_final = std::is_final<T>;
+#else
+template <typename T>
+struct is_final : std::integral_constant<bool, __is_final(T)> {
+};
+#endif
+
+}  // namespace detail
+
+// References are never null
+template <typename T>
+struct niche_traits<detail::RefHolder<T>> {
+    static constexpr bool available = true;
+    static constexpr detail::RefHolder<T> niche() noexcept(true) { return detail::RefHolder<T>::null(); }
+    static constexpr bool is_niche(const detail::RefHolder<T>& ref) noexcept(true) { return ref.is_null(); }
+};
+
+namespace detail
+{
+// Empty type which can be kept as a base (EBO), so it takes no space in Expected
+template <typename T>
+struct is_ebo_empty : std::integral_constant<bool, std::is_empty<T>::value && !is_final<T>::value &&
+                                                       std::is_trivially_copyable<T>::value &&
+                                                       std::is_trivially_default_constructible<T>::value> {
+};
+
+template <typename T>
+struct has_niche : std::integral_constant<bool, niche_traits<T>::available && std::is_trivially_copyable<T>::value> {
+};
+
+enum class Layout { Union, Empty, NicheOk, NicheErr };
+
+template <typename T, typename E>
+struct layout_for
+    : std::integral_constant<Layout, is_ebo_empty<T>::value && is_ebo_empty<E>::value ? Layout::Empty
+                                     : is_ebo_empty<E>::value && has_niche<T>::value  ? Layout::NicheOk
+                                     : is_ebo_empty<T>::value && has_niche<E>::value  ? Layout::NicheErr
+                                                                                      : Layout::Union> {
+};
+
+// State of Expected packed into a single byte: bit 0 - holds ok value, bit 1 - value was moved out
+enum State : unsigned char { StateErr = 0, StateOk = 1, StateMoved = 2 };
+
+template <typename T, int Tag>
+struct EmptyHolder : T {
+};
+
+// Begins lifetime of a union member, at compile time too in C++20
+template <typename T, typename... Args>
+RESULT_CONSTEXPR20 void construct_at(T& slot, Args&&... args) noexcept(std::is_nothrow_constructible<T, Args...>::value)
+{
+#if RESULT_HAS_CONSTEXPR20
+    std::construct_at(std::addressof(slot), std::forward<Args>(args)...);
+#else
+    ::new (static_cast<void*>(std::addressof(slot))) T(std::forward<Args>(args)...);
+#endif
+}
+
+template <typename T>
+RESULT_CONSTEXPR20 void destroy_at(T& slot) noexcept(true)
+{
+    slot.~T();
+}
+
+// Union holding either payload. Members are initialized by tagged constructors, so Expected of literal types can be
+// built in constant expressions, later replacements go through construct_at().
+template <typename T, typename E,
+          bool = std::is_trivially_destructible<T>::value && std::is_trivially_destructible<E>::value>
+union UnionStorage {
+    constexpr UnionStorage() noexcept(true) : _none() {}
 
-    template <typename T = ok_t, typename std::enable_if<std::is_copy_constructible<T>::value, T>::type* = nullptr>
-    Expected(const Success<ok_t>& success) : _success(true)
+    template <typename... Args>
+    constexpr UnionStorage(ok_tag_t, Args&&... args) : _ok(std::forward<Args>(args)...)
     {
-        new (&_storage) ok_t(success.value());
     }
 
-    template <typename T = ok_t, typename std::enable_if<!std::is_copy_constructible<T>::value, T>::type* = nullptr>
-    Expected(Success<ok_t>&& success) : _success(true)
+    template <typename... Args>
+    constexpr UnionStorage(err_tag_t, Args&&... args) : _err(std::forward<Args>(args)...)
     {
-        new (&_storage) ok_t(success.move());
     }
 
-    template <typename T = err_t, typename std::enable_if<std::is_copy_constructible<T>::value, T>::type* = nullptr>
-    Expected(const Failure<err_t>& error) : _success(false)
+    unsigned char _none;
+    T _ok;
+    E _err;
+};
+
+template <typename T, typename E>
+union UnionStorage<T, E, false> {
+    constexpr UnionStorage() noexcept(true) : _none() {}
+
+    template <typename... Args>
+    constexpr UnionStorage(ok_tag_t, Args&&... args) : _ok(std::forward<Args>(args)...)
     {
-        new (&_storage) err_t(error.error());
     }
 
-    template <typename T = err_t, typename std::enable_if<!std::is_copy_constructible<T>::value, T>::type* = nullptr>
-    Expected(Failure<err_t>&& error) : _success(false)
+    template <typename... Args>
+    constexpr UnionStorage(err_tag_t, Args&&... args) : _err(std::forward<Args>(args)...)
     {
-        new (&_storage) err_t(error.move());
     }
 
-    void handle_error(const char* str = "") const noexcept(std::is_same<BadAccess, BadAccessNoThrow>::value)
+    // Alive member is destroyed by ExpectedDestroy, which knows which one it is
+    RESULT_CONSTEXPR20 ~UnionStorage() {}
+
+    unsigned char _none;
+    T _ok;
+    E _err;
+};
+
+// Representation of payload and its state, selected by Layout. It knows which member is alive and constructs it
+// when asked to, but never destroys anything on its own.
+template <typename T, typename E, Layout = layout_for<T, E>::value>
+struct ExpectedRepr {
+    constexpr ExpectedRepr() noexcept(true) : _storage(), _state(StateErr) {}
+
+    template <typename... Args>
+    constexpr ExpectedRepr(ok_tag_t tag, Args&&... args) : _storage(tag, std::forward<Args>(args)...), _state(StateOk)
     {
-        // can be if constexpr with c++17 or templated with pre c++17
-#if defined(USE_EXCEPTIONS)
-        if (std::is_same<BadAccess, BadAccessThrow>::value)
-            throw bad_access(str);
-#endif
-        fprintf(stderr, "%s\n", str);
-        if (std::is_same<BadAccess, BadAccessNoThrow>::value)
-            return;
-        std::terminate();
     }
 
-    // Add concept for that case, also handle primitive type
-    template <typename Ret = ok_t, typename Access = access_t,
-              typename std::enable_if<std::is_same<Access, BadAccessNoThrow>::value, bool>::type = true,
-              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
-    auto value() const noexcept(noexcept(handle_error())) -> Ret
+    template <typename... Args>
+    constexpr ExpectedRepr(err_tag_t tag, Args&&... args)
+        : _storage(tag, std::forward<Args>(args)...), _state(StateErr)
     {
-        if (!_success || _moved) {
-            handle_error("Attempting to get Expected::value()");
-            return {};
-        }
-        return Ok();
     }
 
-    template <typename Ret = const ok_t&, typename Access = access_t,
-              typename std::enable_if<!std::is_same<Access, BadAccessNoThrow>::value, bool>::type = true>
-    auto value() const noexcept(noexcept(handle_error())) -> Ret
+    RESULT_CONSTEXPR14 T& ok() noexcept(true) { return _storage._ok; }
+    constexpr const T& ok() const noexcept(true) { return _storage._ok; }
+    RESULT_CONSTEXPR14 E& err() noexcept(true) { return _storage._err; }
+    constexpr const E& err() const noexcept(true) { return _storage._err; }
+
+    constexpr bool is_ok() const noexcept(true) { return (_state & StateOk) != 0; }
+    constexpr bool is_moved() const noexcept(true) { return (_state & StateMoved) != 0; }
+    constexpr bool holds_ok() const noexcept(true) { return _state == StateOk; }
+    constexpr bool holds_err() const noexcept(true) { return _state == StateErr; }
+    RESULT_CONSTEXPR14 void set_moved(bool moved = true) noexcept(true)
     {
-        if (!_success || _moved)
-            handle_error("Attempting to get Expected::value()");
-        return Ok();
+        _state = static_cast<unsigned char>((_state & StateOk) | (moved ? StateMoved : 0));
     }
 
-    template <typename Ret = ok_t, typename Access = access_t,
-              typename std::enable_if<std::is_copy_constructible<Ret>::value, Ret>::type* = nullptr>
-    auto value_or(const Ret& ret) const noexcept(true) -> ok_t
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void construct_ok(Args&&... args) noexcept(std::is_nothrow_constructible<T, Args...>::value)
     {
-        if (!_success || _moved)
-            return ret;
-        return Ok();
+        detail::construct_at(_storage._ok, std::forward<Args>(args)...);
+        _state = StateOk;
     }
 
-    template <typename Ret = err_t, typename Access = access_t,
-              typename std::enable_if<std::is_same<Access, BadAccessNoThrow>::value, bool>::type = true,
-              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
-    auto error() noexcept(noexcept(handle_error())) -> Ret
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void construct_err(Args&&... args) noexcept(std::is_nothrow_constructible<E, Args...>::value)
     {
-        if (_success || _moved) {
-            handle_error("Attempting to get Expected::error()");
-            return {};
-        }
-        return Err();
+        detail::construct_at(_storage._err, std::forward<Args>(args)...);
+        _state = StateErr;
     }
 
-    template <typename Ret = const err_t&, typename Access = access_t,
-              typename std::enable_if<!std::is_same<Access, BadAccessNoThrow>::value, bool>::type = true>
-    auto error() noexcept(noexcept(handle_error())) -> Ret
+    UnionStorage<T, E> _storage;
+    unsigned char _state;
+};
+
+template <typename T, typename E>
+struct ExpectedRepr<T, E, Layout::Empty> : EmptyHolder<T, 0>, EmptyHolder<E, 1> {
+    constexpr ExpectedRepr() noexcept(true) : EmptyHolder<T, 0>(), EmptyHolder<E, 1>(), _state(StateErr) {}
+
+    // Both types are trivial and empty, they live in bases all the time
+    template <typename... Args>
+    constexpr ExpectedRepr(ok_tag_t, Args&&...) noexcept(true)
+        : EmptyHolder<T, 0>(), EmptyHolder<E, 1>(), _state(StateOk)
     {
-        if (_success || _moved)
-            handle_error("Attempting to get Expected::error()");
-        return Err();
+        static_assert(std::is_constructible<T, Args...>::value, "can not construct value from given arguments");
     }
 
-    // What return type? ok_t or const ok_t&
-    template <typename Ret = const err_t&, typename Access = access_t>
-    const Ret& error_or(const Ret& ret) const noexcept(/*noexcept(Err())*/ true)  // -> Ret
+    template <typename... Args>
+    constexpr ExpectedRepr(err_tag_t, Args&&...) noexcept(true)
+        : EmptyHolder<T, 0>(), EmptyHolder<E, 1>(), _state(StateErr)
     {
-        if (_success || _moved)
-            return ret;
-        return Err();
+        static_assert(std::is_constructible<E, Args...>::value, "can not construct error from given arguments");
     }
 
-    auto move_ok() noexcept(noexcept(this->MoveOk())) -> ok_t&& { return MoveOk(); }
+    RESULT_CONSTEXPR14 T& ok() noexcept(true) { return static_cast<EmptyHolder<T, 0>&>(*this); }
+    constexpr const T& ok() const noexcept(true) { return static_cast<const EmptyHolder<T, 0>&>(*this); }
+    RESULT_CONSTEXPR14 E& err() noexcept(true) { return static_cast<EmptyHolder<E, 1>&>(*this); }
+    constexpr const E& err() const noexcept(true) { return static_cast<const EmptyHolder<E, 1>&>(*this); }
 
-    auto move_error() noexcept(noexcept(this->MoveErr())) -> err_t&& { return MoveErr(); }
+    constexpr bool is_ok() const noexcept(true) { return (_state & StateOk) != 0; }
+    constexpr bool is_moved() const noexcept(true) { return (_state & StateMoved) != 0; }
+    constexpr bool holds_ok() const noexcept(true) { return _state == StateOk; }
+    constexpr bool holds_err() const noexcept(true) { return _state == StateErr; }
+    RESULT_CONSTEXPR14 void set_moved(bool moved = true) noexcept(true)
+    {
+        _state = static_cast<unsigned char>((_state & StateOk) | (moved ? StateMoved : 0));
+    }
 
-    void set_value(const ok_t& value) noexcept(std::is_nothrow_constructible<ok_t>::value)
+    template <typename... Args>
+    RESULT_CONSTEXPR14 void construct_ok(Args&&...) noexcept(true)
     {
-        _moved = false;
-        _success = true;
-        new (&_storage) ok_t(value);
+        static_assert(std::is_constructible<T, Args...>::value, "can not construct value from given arguments");
+        _state = StateOk;
     }
 
-    void set_error(const err_t& error) noexcept(std::is_nothrow_constructible<err_t>::value)
+    template <typename... Args>
+    RESULT_CONSTEXPR14 void construct_err(Args&&...) noexcept(true)
     {
-        _moved = false;
-        _success = false;
-        new (&_storage) err_t(error);
+        static_assert(std::is_constructible<E, Args...>::value, "can not construct error from given arguments");
+        _state = StateErr;
     }
 
-    template <typename T = ok_t, typename std::enable_if<std::is_same<T, EmptyValue>::value, T>::type* = nullptr>
-    void set_success() noexcept(noexcept(set_value({})))
+    unsigned char _state;
+};
+
+// Single slot of a niche layout, payload types with niche are trivially copyable
+template <typename T>
+union NicheStorage {
+    constexpr NicheStorage() noexcept(true) : _none() {}
+
+    template <typename... Args>
+    constexpr NicheStorage(ok_tag_t, Args&&... args) : _value(std::forward<Args>(args)...)
     {
-        set_value({});
     }
 
-    template <typename T = err_t, typename std::enable_if<std::is_same<T, SimpleError>::value, T>::type* = nullptr>
-    void set_failure() noexcept(noexcept(set_error({})))
+    unsigned char _none;
+    T _value;
+};
+
+template <typename T, typename E>
+struct ExpectedRepr<T, E, Layout::NicheOk> : EmptyHolder<E, 1> {
+    constexpr ExpectedRepr() noexcept(true) : EmptyHolder<E, 1>(), _storage() {}
+
+    template <typename... Args>
+    constexpr ExpectedRepr(ok_tag_t tag, Args&&... args)
+        : EmptyHolder<E, 1>(), _storage(tag, std::forward<Args>(args)...)
     {
-        set_error({});
     }
 
-    bool is_ok() const noexcept(true) { return _success; }
+    template <typename... Args>
+    constexpr ExpectedRepr(err_tag_t, Args&&...) noexcept(true)
+        : EmptyHolder<E, 1>(), _storage(ok_tag_t{}, niche_traits<T>::niche())
+    {
+        static_assert(std::is_constructible<E, Args...>::value, "can not construct error from given arguments");
+    }
+
+    RESULT_CONSTEXPR14 T& ok() noexcept(true) { return _storage._value; }
+    constexpr const T& ok() const noexcept(true) { return _storage._value; }
+    RESULT_CONSTEXPR14 E& err() noexcept(true) { return static_cast<EmptyHolder<E, 1>&>(*this); }
+    constexpr const E& err() const noexcept(true) { return static_cast<const EmptyHolder<E, 1>&>(*this); }
 
-    explicit operator bool() const noexcept(noexcept(is_ok())) { return is_ok(); }
+    constexpr bool is_ok() const noexcept(true) { return !niche_traits<T>::is_niche(ok()); }
+    constexpr bool is_moved() const noexcept(true) { return false; }
+    constexpr bool holds_ok() const noexcept(true) { return is_ok(); }
+    constexpr bool holds_err() const noexcept(true) { return !is_ok(); }
+    RESULT_CONSTEXPR14 void set_moved(bool = true) noexcept(true) {}
 
-private:
-    ok_t& Ok() noexcept(true) { return *reinterpret_cast<ok_t*>(&_storage); }
-    const ok_t& Ok() const noexcept(true) { return *reinterpret_cast<const ok_t*>(&_storage); }
-    ok_t&& MoveOk() noexcept(noexcept(handle_error()))
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void construct_ok(Args&&... args) noexcept(std::is_nothrow_constructible<T, Args...>::value)
     {
-        if (!_success || _moved)
-            handle_error("Attempting to move in MoveOk");
-        _moved = true;
-        return std::move(*reinterpret_cast<ok_t*>(&_storage));
+        detail::construct_at(_storage._value, std::forward<Args>(args)...);
     }
-    err_t& Err() noexcept(true) { return *reinterpret_cast<err_t*>(&_storage); }
-    const err_t& Err() const noexcept(true) { return *reinterpret_cast<const err_t*>(&_storage); }
-    err_t&& MoveErr() noexcept(noexcept(handle_error()))
+
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void construct_err(Args&&...) noexcept(true)
     {
-        if (_success || _moved)
-            handle_error("Attempting to move in MoveErr");
-        _moved = true;
-        return std::move(*reinterpret_cast<err_t*>(&_storage));
+        static_assert(std::is_constructible<E, Args...>::value, "can not construct error from given arguments");
+        detail::construct_at(_storage._value, niche_traits<T>::niche());
     }
 
-    typename std::aligned_storage<_size, _align>::type _storage;
-    bool _moved = false;
-    bool _success = false;
+    NicheStorage<T> _storage;
 };
 
-template <typename Value = EmptyValue,
-          typename std::enable_if<std::is_copy_constructible<Value>::value, Value>::type* = nullptr>
-[[nodiscard]] auto Ok(const Value& val = {}) -> Success<Value>
-{
-    return Success<Value>(val);
-}
+template <typename T, typename E>
+struct ExpectedRepr<T, E, Layout::NicheErr> : EmptyHolder<T, 0> {
+    constexpr ExpectedRepr() noexcept(true) : EmptyHolder<T, 0>(), _storage() {}
 
-template <typename Value = EmptyValue,
-          typename std::enable_if<!std::is_copy_constructible<Value>::value, Value>::type* = nullptr>
-[[nodiscard]] auto Ok(Value&& val) -> Success<Value>
-{
-    return Success<Value>(std::move(val));
-}
+    template <typename... Args>
+    constexpr ExpectedRepr(ok_tag_t, Args&&...) noexcept(true)
+        : EmptyHolder<T, 0>(), _storage(ok_tag_t{}, niche_traits<E>::niche())
+    {
+        static_assert(std::is_constructible<T, Args...>::value, "can not construct value from given arguments");
+    }
 
-template <typename ErrorType = SimpleError,
-          typename std::enable_if<std::is_copy_constructible<ErrorType>::value, ErrorType>::type* = nullptr>
-[[nodiscard]] auto Error(const ErrorType& err = {}) -> Failure<ErrorType>
-{
-    return Failure<ErrorType>(err);
-}
+    template <typename... Args>
+    constexpr ExpectedRepr(err_tag_t, Args&&... args)
+        : EmptyHolder<T, 0>(), _storage(ok_tag_t{}, std::forward<Args>(args)...)
+    {
+    }
 
-template <typename ErrorType = SimpleError,
-          typename std::enable_if<!std::is_copy_constructible<ErrorType>::value, ErrorType>::type* = nullptr>
-[[nodiscard]] auto Error(ErrorType&& err) -> Failure<ErrorType>
-{
-    return Failure<ErrorType>(std::move(err));
-}
-}  // namespace Result
\ No newline at end of file
+    RESULT_CONSTEXPR14 T& ok() noexcept(true) { return static_cast<EmptyHolder<T, 0>&>(*this); }
+    constexpr const T& ok() const noexcept(true) { return static_cast<const EmptyHolder<T, 0>&>(*this); }
+    RESULT_CONSTEXPR14 E& err() noexcept(true) { return _storage._value; }
+    constexpr const E& err() const noexcept(true) { return _storage._value; }
+
+    constexpr bool is_ok() const noexcept(true) { return niche_traits<E>::is_niche(err()); }
+    constexpr bool is_moved() const noexcept(true) { return false; }
+    constexpr bool holds_ok() const noexcept(true) { return is_ok(); }
+    constexpr bool holds_err() const noexcept(true) { return !is_ok(); }
+    RESULT_CONSTEXPR14 void set_moved(bool = true) noexcept(true) {}
+
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void construct_ok(Args&&...) noexcept(true)
+    {
+        static_assert(std::is_constructible<T, Args...>::value, "can not construct value from given arguments");
+        detail::construct_at(_storage._value, niche_traits<E>::niche());
+    }
+
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void construct_err(Args&&... args) noexcept(std::is_nothrow_constructible<E, Args...>::value)
+    {
+        detail::construct_at(_storage._value, std::forward<Args>(args)...);
+    }
+
+    NicheStorage<E> _storage;
+};
+
+// Payload of Expected with construction and assignment, but without destruction on its own
+template <typename T, typename E>
+struct ExpectedData : ExpectedRepr<stored_t<T>, stored_t<E>> {
+    using Repr = ExpectedRepr<stored_t<T>, stored_t<E>>;
+    using ok_storage_t = stored_t<T>;
+    using err_storage_t = stored_t<E>;
+
+    template <typename... Args>
+    constexpr ExpectedData(ok_tag_t tag, Args&&... args) noexcept(
+        std::is_nothrow_constructible<ok_storage_t, Args...>::value)
+        : Repr(tag, std::forward<Args>(args)...)
+    {
+    }
+
+    template <typename... Args>
+    constexpr ExpectedData(err_tag_t tag, Args&&... args) noexcept(
+        std::is_nothrow_constructible<err_storage_t, Args...>::value)
+        : Repr(tag, std::forward<Args>(args)...)
+    {
+    }
+
+    constexpr explicit ExpectedData(unset_tag_t) noexcept(true) : Repr() {}
+
+    template <typename Other>
+    RESULT_CONSTEXPR20 ExpectedData(copy_tag_t, Other&& other) : Repr()
+    {
+        if (other.is_ok())
+            this->construct_ok(forward_member<Other>(other.Repr::ok()));
+        else
+            this->construct_err(forward_member<Other>(other.Repr::err()));
+        if (other.is_moved())
+            this->set_moved();
+    }
+
+    // Payload as seen by the user, references are unwrapped
+    RESULT_CONSTEXPR14 T& ok() & noexcept(true) { return unwrap(Repr::ok()); }
+    RESULT_CONSTEXPR14 const T& ok() const& noexcept(true) { return unwrap(Repr::ok()); }
+    RESULT_CONSTEXPR14 T&& ok() && noexcept(true) { return static_cast<T&&>(unwrap(Repr::ok())); }
+    RESULT_CONSTEXPR14 E& err() & noexcept(true) { return unwrap(Repr::err()); }
+    RESULT_CONSTEXPR14 const E& err() const& noexcept(true) { return unwrap(Repr::err()); }
+    RESULT_CONSTEXPR14 E&& err() && noexcept(true) { return static_cast<E&&>(unwrap(Repr::err())); }
+
+    RESULT_CONSTEXPR20 void destroy() noexcept(true)
+    {
+        if (this->is_ok())
+            detail::destroy_at(Repr::ok());
+        else
+            detail::destroy_at(Repr::err());
+    }
+
+    // Replace current payload. When construction may throw it is done into a temporary first,
+    // so the old payload is still alive if it does.
+    template <typename... Args,
+              typename std::enable_if<std::is_nothrow_constructible<ok_storage_t, Args...>::value, bool>::type = true>
+    RESULT_CONSTEXPR20 void reset_ok(Args&&... args) noexcept(true)
+    {
+        destroy();
+        this->construct_ok(std::forward<Args>(args)...);
+    }
+
+    template <typename... Args,
+              typename std::enable_if<!std::is_nothrow_constructible<ok_storage_t, Args...>::value, bool>::type = true>
+    RESULT_CONSTEXPR20 void reset_ok(Args&&... args)
+    {
+        ok_storage_t tmp(std::forward<Args>(args)...);
+        destroy();
+        this->construct_ok(std::move(tmp));
+    }
+
+    template <typename... Args,
+              typename std::enable_if<std::is_nothrow_constructible<err_storage_t, Args...>::value, bool>::type = true>
+    RESULT_CONSTEXPR20 void reset_err(Args&&... args) noexcept(true)
+    {
+        destroy();
+        this->construct_err(std::forward<Args>(args)...);
+    }
+
+    template <typename... Args,
+              typename std::enable_if<!std::is_nothrow_constructible<err_storage_t, Args...>::value, bool>::type = true>
+    RESULT_CONSTEXPR20 void reset_err(Args&&... args)
+    {
+        err_storage_t tmp(std::forward<Args>(args)...);
+        destroy();
+        this->construct_err(std::move(tmp));
+    }
+
+    // Builds new payload right in storage for emplace(), without a temporary. A constructor which may throw
+    // gives the basic guarantee: old payload is gone and default constructed error (or value) is left in moved
+    // state. When neither side can be default constructed without throwing, payload goes through a temporary
+    // if its move can not throw, otherwise the exception terminates.
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void emplace_ok(Args&&... args) noexcept(
+        std::is_nothrow_constructible<ok_storage_t, Args...>::value)
+    {
+        emplace_as(ok_tag_t{}, emplace_kind<ok_storage_t, Args...>{}, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void emplace_err(Args&&... args) noexcept(
+        std::is_nothrow_constructible<err_storage_t, Args...>::value)
+    {
+        emplace_as(err_tag_t{}, emplace_kind<err_storage_t, Args...>{}, std::forward<Args>(args)...);
+    }
+
+    // Assigns stored objects, so Expected<T&> rebinds instead of assigning through the reference
+    template <typename Other>
+    RESULT_CONSTEXPR20 void assign(Other&& other)
+    {
+        if (this->is_ok() && other.is_ok())
+            Repr::ok() = forward_member<Other>(other.Repr::ok());
+        else if (!this->is_ok() && !other.is_ok())
+            Repr::err() = forward_member<Other>(other.Repr::err());
+        else if (other.is_ok())
+            reset_ok(forward_member<Other>(other.Repr::ok()));
+        else
+            reset_err(forward_member<Other>(other.Repr::err()));
+        this->set_moved(other.is_moved());
+    }
+
+private:
+    enum class Emplace { Direct, Recover, Temporary, Terminate };
+
+    template <typename U, typename... Args>
+    using emplace_kind = std::integral_constant<
+        Emplace,
+#if defined(__cpp_exceptions)
+        std::is_nothrow_constructible<U, Args...>::value ? Emplace::Direct
+        : std::is_nothrow_default_constructible<err_storage_t>::value ||
+                std::is_nothrow_default_constructible<ok_storage_t>::value
+            ? Emplace::Recover
+        : std::is_nothrow_move_constructible<U>::value ? Emplace::Temporary
+                                                       : Emplace::Terminate
+#else
+        Emplace::Direct
+#endif
+        >;
+
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void construct(ok_tag_t, Args&&... args)
+    {
+        this->construct_ok(std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    RESULT_CONSTEXPR20 void construct(err_tag_t, Args&&... args)
+    {
+        this->construct_err(std::forward<Args>(args)...);
+    }
+
+    template <typename Tag, typename... Args>
+    RESULT_CONSTEXPR20 void emplace_as(Tag tag, std::integral_constant<Emplace, Emplace::Direct>, Args&&... args)
+    {
+        destroy();
+        construct(tag, std::forward<Args>(args)...);
+    }
+
+#if defined(__cpp_exceptions)
+    template <typename Tag, typename... Args>
+    RESULT_CONSTEXPR20 void emplace_as(Tag tag, std::integral_constant<Emplace, Emplace::Recover>, Args&&... args)
+    {
+        destroy();
+        try {
+            construct(tag, std::forward<Args>(args)...);
+        } catch (...) {
+            recover(std::is_nothrow_default_constructible<err_storage_t>{});
+            throw;
+        }
+    }
+
+    template <typename Tag, typename... Args>
+    RESULT_CONSTEXPR20 void emplace_as(Tag tag, std::integral_constant<Emplace, Emplace::Temporary>, Args&&... args)
+    {
+        typename std::conditional<std::is_same<Tag, ok_tag_t>::value, ok_storage_t, err_storage_t>::type tmp(
+            std::forward<Args>(args)...);
+        destroy();
+        construct(tag, std::move(tmp));
+    }
+
+    template <typename Tag, typename... Args>
+    RESULT_CONSTEXPR20 void emplace_as(Tag tag, std::integral_constant<Emplace, Emplace::Terminate>,
+                                       Args&&... args) noexcept(true)
+    {
+        destroy();
+        construct(tag, std::forward<Args>(args)...);
+    }
+
+    RESULT_CONSTEXPR20 void recover(std::true_type) noexcept(true)
+    {
+        this->construct_err();
+        this->set_moved();
+    }
+
+    RESULT_CONSTEXPR20 void recover(std::false_type) noexcept(true)
+    {
+        this->construct_ok();
+        this->set_moved();
+    }
+#endif
+
+    // Member of other with value category of other
+    template <typename Other, typename Member>
+    static constexpr auto forward_member(Member& member) noexcept(true) ->
+        typename std::conditional<std::is_lvalue_reference<Other>::value, Member&, Member&&>::type
+    {
+        return static_cast<typename std::conditional<std::is_lvalue_reference<Other>::value, Member&, Member&&>::type>(
+            member);
+    }
+};
+
+template <typename T, typename E>
+struct both_trivially_destructible
+    : std::integral_constant<bool, std::is_trivially_destructible<stored_t<T>>::value &&
+                                       std::is_trivially_destructible<stored_t<E>>::value> {
+};
+
+template <typename T, typename E>
+struct both_trivially_copy_constructible
+    : std::integral_constant<bool, std::is_trivially_copy_constructible<stored_t<T>>::value &&
+                                       std::is_trivially_copy_constructible<stored_t<E>>::value> {
+};
+
+template <typename T, typename E>
+struct both_trivially_move_constructible
+    : std::integral_constant<bool, std::is_trivially_move_constructible<stored_t<T>>::value &&
+                                       std::is_trivially_move_constructible<stored_t<E>>::value> {
+};
+
+template <typename T, typename E>
+struct both_trivially_copy_assignable
+    : std::integral_constant<bool, std::is_trivially_copy_assignable<stored_t<T>>::value &&
+                                       std::is_trivially_copy_assignable<stored_t<E>>::value &&
+                                       both_trivially_copy_constructible<T, E>::value &&
+                                       both_trivially_destructible<T, E>::value> {
+};
+
+template <typename T, typename E>
+struct both_trivially_move_assignable
+    : std::integral_constant<bool, std::is_trivially_move_assignable<stored_t<T>>::value &&
+                                       std::is_trivially_move_assignable<stored_t<E>>::value &&
+                                       both_trivially_move_constructible<T, E>::value &&
+                                       both_trivially_destructible<T, E>::value> {
+};
+
+#if RESULT_HAS_CONCEPTS
+// Special members are defaulted (trivial) when both payload types have them trivial, so e.g. Expected<int, ErrorEnum>
+// stays trivially copyable and is passed in registers. Constraints pick the variant, no layer per member is needed.
+template <typename T, typename E>
+struct ExpectedStorage : ExpectedData<T, E> {
+    using ExpectedData<T, E>::ExpectedData;
+
+    ExpectedStorage(const ExpectedStorage&) requires both_trivially_copy_constructible<T, E>::value = default;
+    RESULT_CONSTEXPR20 ExpectedStorage(const ExpectedStorage& other) : ExpectedData<T, E>(copy_tag_t{}, other) {}
+
+    ExpectedStorage(ExpectedStorage&&) requires both_trivially_move_constructible<T, E>::value = default;
+    RESULT_CONSTEXPR20 ExpectedStorage(ExpectedStorage&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_constructible<E>::value)
+        : ExpectedData<T, E>(copy_tag_t{}, std::move(other))
+    {
+    }
+
+    ExpectedStorage& operator=(const ExpectedStorage&) requires both_trivially_copy_assignable<T, E>::value = default;
+    RESULT_CONSTEXPR20 ExpectedStorage& operator=(const ExpectedStorage& other)
+    {
+        this->assign(other);
+        return *this;
+    }
+
+    ExpectedStorage& operator=(ExpectedStorage&&) requires both_trivially_move_assignable<T, E>::value = default;
+    RESULT_CONSTEXPR20 ExpectedStorage& operator=(ExpectedStorage&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value &&
+        std::is_nothrow_move_constructible<E>::value && std::is_nothrow_move_assignable<E>::value)
+    {
+        this->assign(std::move(other));
+        return *this;
+    }
+
+    ~ExpectedStorage() requires both_trivially_destructible<T, E>::value = default;
+    RESULT_CONSTEXPR20 ~ExpectedStorage() { this->destroy(); }
+};
+#else
+// Each layer below provides one special member. It is left implicit (trivial) when both payload types
+// have it trivial, so e.g. Expected<int, ErrorEnum> stays trivially copyable and is passed in registers
+template <typename T, typename E, bool = both_trivially_destructible<T, E>::value>
+struct ExpectedDestroy : ExpectedData<T, E> {
+    using ExpectedData<T, E>::ExpectedData;
+};
+
+template <typename T, typename E>
+struct ExpectedDestroy<T, E, false> : ExpectedData<T, E> {
+    using ExpectedData<T, E>::ExpectedData;
+    ExpectedDestroy(const ExpectedDestroy&) = default;
+    ExpectedDestroy(ExpectedDestroy&&) = default;
+    ExpectedDestroy& operator=(const ExpectedDestroy&) = default;
+    ExpectedDestroy& operator=(ExpectedDestroy&&) = default;
+    RESULT_CONSTEXPR20 ~ExpectedDestroy() { this->destroy(); }
+};
+
+template <typename T, typename E, bool = both_trivially_copy_constructible<T, E>::value>
+struct ExpectedCopy : ExpectedDestroy<T, E> {
+    using ExpectedDestroy<T, E>::ExpectedDestroy;
+};
+
+template <typename T, typename E>
+struct ExpectedCopy<T, E, false> : ExpectedDestroy<T, E> {
+    using ExpectedDestroy<T, E>::ExpectedDestroy;
+    RESULT_CONSTEXPR20 ExpectedCopy(const ExpectedCopy& other) : ExpectedDestroy<T, E>(copy_tag_t{}, other) {}
+    ExpectedCopy(ExpectedCopy&&) = default;
+    ExpectedCopy& operator=(const ExpectedCopy&) = default;
+    ExpectedCopy& operator=(ExpectedCopy&&) = default;
+};
+
+template <typename T, typename E, bool = both_trivially_move_constructible<T, E>::value>
+struct ExpectedMove : ExpectedCopy<T, E> {
+    using ExpectedCopy<T, E>::ExpectedCopy;
+};
+
+template <typename T, typename E>
+struct ExpectedMove<T, E, false> : ExpectedCopy<T, E> {
+    using ExpectedCopy<T, E>::ExpectedCopy;
+    ExpectedMove(const ExpectedMove&) = default;
+    RESULT_CONSTEXPR20 ExpectedMove(ExpectedMove&& other) noexcept(std::is_nothrow_move_constructible<T>::value &&
+                                                std::is_nothrow_move_constructible<E>::value)
+        : ExpectedCopy<T, E>(copy_tag_t{}, std::move(other))
+    {
+    }
+    ExpectedMove& operator=(const ExpectedMove&) = default;
+    ExpectedMove& operator=(ExpectedMove&&) = default;
+};
+
+template <typename T, typename E, bool = both_trivially_copy_assignable<T, E>::value>
+struct ExpectedCopyAssign : ExpectedMove<T, E> {
+    using ExpectedMove<T, E>::ExpectedMove;
+};
+
+template <typename T, typename E>
+struct ExpectedCopyAssign<T, E, false> : ExpectedMove<T, E> {
+    using ExpectedMove<T, E>::ExpectedMove;
+    ExpectedCopyAssign(const ExpectedCopyAssign&) = default;
+    ExpectedCopyAssign(ExpectedCopyAssign&&) = default;
+    RESULT_CONSTEXPR20 ExpectedCopyAssign& operator=(const ExpectedCopyAssign& other)
+    {
+        this->assign(other);
+        return *this;
+    }
+    ExpectedCopyAssign& operator=(ExpectedCopyAssign&&) = default;
+};
+
+template <typename T, typename E, bool = both_trivially_move_assignable<T, E>::value>
+struct ExpectedStorage : ExpectedCopyAssign<T, E> {
+    using ExpectedCopyAssign<T, E>::ExpectedCopyAssign;
+};
+
+template <typename T, typename E>
+struct ExpectedStorage<T, E, false> : ExpectedCopyAssign<T, E> {
+    using ExpectedCopyAssign<T, E>::ExpectedCopyAssign;
+    ExpectedStorage(const ExpectedStorage&) = default;
+    ExpectedStorage(ExpectedStorage&&) = default;
+    ExpectedStorage& operator=(const ExpectedStorage&) = default;
+    RESULT_CONSTEXPR20 ExpectedStorage& operator=(ExpectedStorage&& other) noexcept(
+        std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value &&
+        std::is_nothrow_move_constructible<E>::value && std::is_nothrow_move_assignable<E>::value)
+    {
+        this->assign(std::move(other));
+        return *this;
+    }
+};
+
+#endif
+
+// Empty bases deleting the special members which payload types do not support
+template <bool>
+struct EnableCopy {
+};
+template <>
+struct EnableCopy<false> {
+    EnableCopy() = default;
+    EnableCopy(const EnableCopy&) = delete;
+    EnableCopy(EnableCopy&&) = default;
+    EnableCopy& operator=(const EnableCopy&) = default;
+    EnableCopy& operator=(EnableCopy&&) = default;
+};
+
+template <bool>
+struct EnableMove {
+};
+template <>
+struct EnableMove<false> {
+    EnableMove() = default;
+    EnableMove(const EnableMove&) = default;
+    EnableMove(EnableMove&&) = delete;
+    EnableMove& operator=(const EnableMove&) = default;
+    EnableMove& operator=(EnableMove&&) = default;
+};
+
+template <bool>
+struct EnableCopyAssign {
+};
+template <>
+struct EnableCopyAssign<false> {
+    EnableCopyAssign() = default;
+    EnableCopyAssign(const EnableCopyAssign&) = default;
+    EnableCopyAssign(EnableCopyAssign&&) = default;
+    EnableCopyAssign& operator=(const EnableCopyAssign&) = delete;
+    EnableCopyAssign& operator=(EnableCopyAssign&&) = default;
+};
+
+template <bool>
+struct EnableMoveAssign {
+};
+template <>
+struct EnableMoveAssign<false> {
+    EnableMoveAssign() = default;
+    EnableMoveAssign(const EnableMoveAssign&) = default;
+    EnableMoveAssign(EnableMoveAssign&&) = default;
+    EnableMoveAssign& operator=(const EnableMoveAssign&) = default;
+    EnableMoveAssign& operator=(EnableMoveAssign&&) = delete;
+};
+
+template <typename T, typename E>
+using EnableCopyFor =
+    EnableCopy<std::is_copy_constructible<stored_t<T>>::value && std::is_copy_constructible<stored_t<E>>::value>;
+
+template <typename T, typename E>
+using EnableMoveFor =
+    EnableMove<std::is_move_constructible<stored_t<T>>::value && std::is_move_constructible<stored_t<E>>::value>;
+
+template <typename T, typename E>
+using EnableCopyAssignFor =
+    EnableCopyAssign<std::is_copy_constructible<stored_t<T>>::value && std::is_copy_constructible<stored_t<E>>::value &&
+                     std::is_copy_assignable<stored_t<T>>::value && std::is_copy_assignable<stored_t<E>>::value>;
+
+template <typename T, typename E>
+using EnableMoveAssignFor =
+    EnableMoveAssign<std::is_move_constructible<stored_t<T>>::value && std::is_move_constructible<stored_t<E>>::value &&
+                     std::is_move_assignable<stored_t<T>>::value && std::is_move_assignable<stored_t<E>>::value>;
+template <typename T>
+struct is_expected : std::false_type {
+};
+
+template <typename T, typename E, typename A>
+struct is_expected<Expected<T, E, A>> : std::true_type {
+};
+
+template <typename F, typename... Args>
+using invoke_result_t = typename std::decay<decltype(std::declval<F>()(std::declval<Args>()...))>::type;
+
+// Calls transform() function and wraps its result, void result becomes EmptyValue
+template <typename R>
+struct TransformCall {
+    template <typename Ret, typename F, typename... Args>
+    static RESULT_CONSTEXPR14 Ret call(F&& f, Args&&... args)
+    {
+        return Ret(ok_tag_t{}, std::forward<F>(f)(std::forward<Args>(args)...));
+    }
+};
+
+template <>
+struct TransformCall<void> {
+    template <typename Ret, typename F, typename... Args>
+    static RESULT_CONSTEXPR14 Ret call(F&& f, Args&&... args)
+    {
+        std::forward<F>(f)(std::forward<Args>(args)...);
+        return Ret(ok_tag_t{});
+    }
+};
+
+template <typename R>
+using transform_value_t = typename std::conditional<std::is_void<R>::value, EmptyValue, R>::type;
+
+// Return object of a coroutine returning Expected, see result_coroutine.h
+template <typename Exp>
+struct ExpectedReturn;
+
+// Payload access for RESULT_TRY macros. State is already checked there, so nothing is checked again and
+// payload is moved out of temporaries without marking them as moved.
+struct TryAccess {
+    template <typename Exp>
+    static RESULT_CONSTEXPR14 auto value(Exp&& res) -> typename std::decay<Exp>::type::ok_t
+    {
+        return std::forward<Exp>(res)._data.ok();
+    }
+
+    template <typename Exp>
+    static constexpr auto error(Exp&& res) noexcept(true) -> decltype(std::forward<Exp>(res)._data.err())
+    {
+        return std::forward<Exp>(res)._data.err();
+    }
+};
+
+// Error passed on as it is, or translated when RESULT_MAP_ERRORS table is declared for it
+template <typename To, typename From,
+          typename std::enable_if<!error_map<typename std::decay<From>::type, To>::available, bool>::type = true>
+constexpr From&& propagated_error(From&& err) noexcept(true)
+{
+    return std::forward<From>(err);
+}
+
+template <typename To, typename From,
+          typename std::enable_if<error_map<typename std::decay<From>::type, To>::available, bool>::type = true>
+constexpr To propagated_error(From&& err) noexcept(true)
+{
+    return map_error<To>(err);
+}
+
+// Error of a failed RESULT_TRY on its way out, it builds error of the function's Expected directly in place
+template <typename Exp>
+struct Propagation {
+    template <typename T, typename E, typename A>
+    RESULT_CONSTEXPR14 operator Expected<T, E, A>() &&
+    {
+        static_assert(std::is_constructible<stored_t<E>, decltype(propagated_error<E>(
+                                                             TryAccess::error(std::declval<Exp>())))>::value,
+                      "RESULT_TRY error can not be converted to error of returned Expected");
+        return Expected<T, E, A>(unexpect, propagated_error<E>(TryAccess::error(std::forward<Exp>(_source))));
+    }
+
+    Exp&& _source;
+};
+
+template <typename Exp>
+constexpr auto propagate(Exp&& res) noexcept(true) -> Propagation<Exp>
+{
+    return Propagation<Exp>{std::forward<Exp>(res)};
+}
+}  // namespace detail
+
+template <typename Value = EmptyValue, typename ErrorType = SimpleError, typename BadAccess = DefaultBadAccess>
+struct Expected : private detail::EnableCopyFor<Value, ErrorType>,
+                  private detail::EnableMoveFor<Value, ErrorType>,
+                  private detail::EnableCopyAssignFor<Value, ErrorType>,
+                  private detail::EnableMoveAssignFor<Value, ErrorType> {
+public:
+    using ok_t = Value;
+    using err_t = ErrorType;
+    using access_t = BadAccess;
+    static_assert(!std::is_same<err_t, void>::value, "void error type is not allowed");
+    static constexpr size_t _size = size_of<detail::stored_t<ok_t>, detail::stored_t<err_t>>();
+    static constexpr size_t _align = align_of<detail::stored_t<ok_t>, detail::stored_t<err_t>>();
+
+#if RESULT_HAS_CONCEPTS
+    constexpr Expected(const Success<ok_t>& success) requires std::is_copy_constructible<ok_t>::value
+        : _data(detail::ok_tag_t{}, success.value())
+    {
+    }
+
+    constexpr Expected(Success<ok_t>&& success) requires std::is_move_constructible<ok_t>::value
+        : _data(detail::ok_tag_t{}, success.move())
+    {
+    }
+
+    constexpr Expected(const Failure<err_t>& error) requires std::is_copy_constructible<err_t>::value
+        : _data(detail::err_tag_t{}, error.error())
+    {
+    }
+
+    constexpr Expected(Failure<err_t>&& error) requires std::is_move_constructible<err_t>::value
+        : _data(detail::err_tag_t{}, error.move())
+    {
+    }
+#else
+    template <typename T = ok_t, typename std::enable_if<std::is_copy_constructible<T>::value, bool>::type = true>
+    constexpr Expected(const Success<ok_t>& success) : _data(detail::ok_tag_t{}, success.value()) {}
+
+    template <typename T = ok_t, typename std::enable_if<std::is_move_constructible<T>::value, bool>::type = true>
+    constexpr Expected(Success<ok_t>&& success) : _data(detail::ok_tag_t{}, success.move()) {}
+
+    template <typename T = err_t, typename std::enable_if<std::is_copy_constructible<T>::value, bool>::type = true>
+    constexpr Expected(const Failure<err_t>& error) : _data(detail::err_tag_t{}, error.error()) {}
+
+    template <typename T = err_t, typename std::enable_if<std::is_move_constructible<T>::value, bool>::type = true>
+    constexpr Expected(Failure<err_t>&& error) : _data(detail::err_tag_t{}, error.move()) {}
+#endif
+
+    // Payload is built directly in storage from args, no Success/Failure temporary is involved
+    template <typename... Args, typename std::enable_if<std::is_constructible<detail::stored_t<ok_t>, Args&&...>::value,
+                                                        bool>::type = true>
+    explicit constexpr Expected(in_place_t, Args&&... args) noexcept(
+        std::is_nothrow_constructible<detail::stored_t<ok_t>, Args&&...>::value)
+        : _data(detail::ok_tag_t{}, std::forward<Args>(args)...)
+    {
+    }
+
+    template <typename U, typename... Args,
+              typename std::enable_if<std::is_constructible<ok_t, std::initializer_list<U>&, Args&&...>::value,
+                                      bool>::type = true>
+    explicit constexpr Expected(in_place_t, std::initializer_list<U> list, Args&&... args) noexcept(
+        std::is_nothrow_constructible<ok_t, std::initializer_list<U>&, Args&&...>::value)
+        : _data(detail::ok_tag_t{}, list, std::forward<Args>(args)...)
+    {
+    }
+
+    template <typename... Args, typename std::enable_if<
+                                    std::is_constructible<detail::stored_t<err_t>, Args&&...>::value, bool>::type = true>
+    explicit constexpr Expected(unexpect_t, Args&&... args) noexcept(
+        std::is_nothrow_constructible<detail::stored_t<err_t>, Args&&...>::value)
+        : _data(detail::err_tag_t{}, std::forward<Args>(args)...)
+    {
+    }
+
+    template <typename U, typename... Args,
+              typename std::enable_if<std::is_constructible<err_t, std::initializer_list<U>&, Args&&...>::value,
+                                      bool>::type = true>
+    explicit constexpr Expected(unexpect_t, std::initializer_list<U> list, Args&&... args) noexcept(
+        std::is_nothrow_constructible<err_t, std::initializer_list<U>&, Args&&...>::value)
+        : _data(detail::err_tag_t{}, list, std::forward<Args>(args)...)
+    {
+    }
+
+    // address is taken in the accessor, here it would point into the accessor itself
+    static void handle_error(const char* str = "",
+                             const void* address = nullptr RESULT_TELEMETRY_AND_SITE_PARAM) noexcept(
+        detail::recovers_from_bad_access<BadAccess>::value)
+    {
+#if defined(RESULT_TELEMETRY)
+        telemetry::record(telemetry::Event::BadAccess, site, telemetry::type_name<err_t>());
+#endif
+        // can be if constexpr with c++17 or templated with pre c++17
+#if defined(USE_EXCEPTIONS)
+        if (std::is_same<BadAccess, BadAccessThrow>::value)
+            throw bad_access(str);
+#endif
+        detail::bad_access_reporter<BadAccess>::template report<err_t>(str, address);
+        if (detail::recovers_from_bad_access<BadAccess>::value)
+            return;
+        std::terminate();
+    }
+
+    // Accessors return references and report bad access according to BadAccess policy. BadAccessNoThrow and
+    // BadAccessDeferred can not throw nor terminate, so they return reference to default constructed instance
+    // instead (requires default ctor).
+    // On temporaries payload is moved out and returned by value, so it never dangles.
+#if RESULT_HAS_CONCEPTS
+    RESULT_CONSTEXPR14 auto value(RESULT_TELEMETRY_SITE_PARAM) const& noexcept(noexcept(handle_error())) -> const ok_t&
+        requires detail::accessible_under<access_t, ok_t>
+    {
+        if (!_data.holds_ok()) {
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            if constexpr (detail::recovers_from_bad_access<access_t>::value)
+                return detail::default_instance<ok_t>();
+        }
+        return Ok();
+    }
+
+    RESULT_CONSTEXPR14 auto value(RESULT_TELEMETRY_SITE_PARAM) && noexcept(noexcept(handle_error()) &&
+                                            std::is_nothrow_move_constructible<ok_t>::value) -> ok_t
+        requires detail::accessible_under<access_t, ok_t>
+    {
+        if (!_data.holds_ok()) {
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            if constexpr (detail::recovers_from_bad_access<access_t>::value)
+                return ok_t{};
+        }
+        return std::move(_data).ok();
+    }
+
+    // Fallback passed as lvalue is returned by reference, temporary one by value, so result never dangles
+    RESULT_CONSTEXPR14 auto value_or(const ok_t& ret) const& noexcept(true) -> const ok_t&
+        requires std::is_copy_constructible<ok_t>::value
+    {
+        if (!_data.holds_ok())
+            return ret;
+        return Ok();
+    }
+
+    RESULT_CONSTEXPR14 auto value_or(ok_t&& ret) const& noexcept(std::is_nothrow_copy_constructible<ok_t>::value &&
+                                              std::is_nothrow_move_constructible<ok_t>::value) -> ok_t
+        requires(std::is_copy_constructible<ok_t>::value && !std::is_reference<ok_t>::value)
+    {
+        if (!_data.holds_ok())
+            return std::move(ret);
+        return Ok();
+    }
+
+    template <typename U>
+    RESULT_CONSTEXPR14 auto value_or(U&& ret) && noexcept(std::is_nothrow_constructible<ok_t, U&&>::value &&
+                                       std::is_nothrow_move_constructible<ok_t>::value) -> ok_t
+        requires std::is_constructible<ok_t, U&&>::value
+    {
+        if (!_data.holds_ok())
+            return static_cast<ok_t>(std::forward<U>(ret));
+        return std::move(_data).ok();
+    }
+
+    RESULT_CONSTEXPR14 auto error(RESULT_TELEMETRY_SITE_PARAM) const& noexcept(noexcept(handle_error())) -> const err_t&
+        requires detail::accessible_under<access_t, err_t>
+    {
+        if (!_data.holds_err()) {
+            handle_error("Attempting to get Expected::error()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            if constexpr (detail::recovers_from_bad_access<access_t>::value)
+                return detail::default_instance<err_t>();
+        }
+        return Err();
+    }
+
+    RESULT_CONSTEXPR14 auto error(RESULT_TELEMETRY_SITE_PARAM) && noexcept(noexcept(handle_error()) &&
+                                            std::is_nothrow_move_constructible<err_t>::value) -> err_t
+        requires detail::accessible_under<access_t, err_t>
+    {
+        if (!_data.holds_err()) {
+            handle_error("Attempting to get Expected::error()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            if constexpr (detail::recovers_from_bad_access<access_t>::value)
+                return err_t{};
+        }
+        return std::move(_data).err();
+    }
+#else
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto value(RESULT_TELEMETRY_SITE_PARAM) const& noexcept(noexcept(handle_error())) -> const ok_t&
+    {
+        if (!_data.holds_ok()) {
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return detail::default_instance<ok_t>();
+        }
+        return Ok();
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto value(RESULT_TELEMETRY_SITE_PARAM) const& noexcept(noexcept(handle_error())) -> const ok_t&
+    {
+        if (!_data.holds_ok())
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return Ok();
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto value(RESULT_TELEMETRY_SITE_PARAM) && noexcept(noexcept(handle_error()) &&
+                                            std::is_nothrow_move_constructible<Ret>::value) -> ok_t
+    {
+        if (!_data.holds_ok()) {
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return ok_t{};
+        }
+        return std::move(_data).ok();
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto value(RESULT_TELEMETRY_SITE_PARAM) && noexcept(noexcept(handle_error()) &&
+                                            std::is_nothrow_move_constructible<Ret>::value) -> ok_t
+    {
+        if (!_data.holds_ok())
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return std::move(_data).ok();
+    }
+
+    // Fallback passed as lvalue is returned by reference, temporary one by value, so result never dangles
+    template <typename Ret = ok_t, typename std::enable_if<std::is_copy_constructible<Ret>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto value_or(const ok_t& ret) const& noexcept(true) -> const ok_t&
+    {
+        if (!_data.holds_ok())
+            return ret;
+        return Ok();
+    }
+
+    template <typename Ret = ok_t, typename std::enable_if<std::is_copy_constructible<Ret>::value &&
+                                                               !std::is_reference<Ret>::value,
+                                                           bool>::type = true>
+    RESULT_CONSTEXPR14 auto value_or(ok_t&& ret) const& noexcept(std::is_nothrow_copy_constructible<Ret>::value &&
+                                              std::is_nothrow_move_constructible<Ret>::value) -> ok_t
+    {
+        if (!_data.holds_ok())
+            return std::move(ret);
+        return Ok();
+    }
+
+    template <typename U, typename Ret = ok_t,
+              typename std::enable_if<std::is_constructible<Ret, U&&>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto value_or(U&& ret) && noexcept(std::is_nothrow_constructible<Ret, U&&>::value &&
+                                       std::is_nothrow_move_constructible<Ret>::value) -> ok_t
+    {
+        if (!_data.holds_ok())
+            return static_cast<ok_t>(std::forward<U>(ret));
+        return std::move(_data).ok();
+    }
+
+    template <typename Ret = err_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto error(RESULT_TELEMETRY_SITE_PARAM) const& noexcept(noexcept(handle_error())) -> const err_t&
+    {
+        if (!_data.holds_err()) {
+            handle_error("Attempting to get Expected::error()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return detail::default_instance<err_t>();
+        }
+        return Err();
+    }
+
+    template <typename Ret = err_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto error(RESULT_TELEMETRY_SITE_PARAM) const& noexcept(noexcept(handle_error())) -> const err_t&
+    {
+        if (!_data.holds_err())
+            handle_error("Attempting to get Expected::error()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return Err();
+    }
+
+    template <typename Ret = err_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto error(RESULT_TELEMETRY_SITE_PARAM) && noexcept(noexcept(handle_error()) &&
+                                            std::is_nothrow_move_constructible<Ret>::value) -> err_t
+    {
+        if (!_data.holds_err()) {
+            handle_error("Attempting to get Expected::error()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return err_t{};
+        }
+        return std::move(_data).err();
+    }
+
+    template <typename Ret = err_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    RESULT_CONSTEXPR14 auto error(RESULT_TELEMETRY_SITE_PARAM) && noexcept(noexcept(handle_error()) &&
+                                            std::is_nothrow_move_constructible<Ret>::value) -> err_t
+    {
+        if (!_data.holds_err())
+            handle_error("Attempting to get Expected::error()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return std::move(_data).err();
+    }
+#endif
+
+    RESULT_CONSTEXPR14 auto error_or(const err_t& ret) const noexcept(true) -> const err_t&
+    {
+        if (!_data.holds_err())
+            return ret;
+        return Err();
+    }
+
+    // Pointer to value/error, or nullptr when there is none. Never reports bad access.
+    RESULT_CONSTEXPR14 auto value_ptr() noexcept(true) -> typename std::add_pointer<ok_t>::type
+    {
+        return _data.holds_ok() ? &Ok() : nullptr;
+    }
+
+    RESULT_CONSTEXPR14 auto value_ptr() const noexcept(true) -> typename std::add_pointer<const ok_t&>::type
+    {
+        return _data.holds_ok() ? &Ok() : nullptr;
+    }
+
+    RESULT_CONSTEXPR14 auto error_ptr() noexcept(true) -> typename std::add_pointer<err_t>::type
+    {
+        return _data.holds_err() ? &Err() : nullptr;
+    }
+
+    RESULT_CONSTEXPR14 auto error_ptr() const noexcept(true) -> typename std::add_pointer<const err_t&>::type
+    {
+        return _data.holds_err() ? &Err() : nullptr;
+    }
+
+    RESULT_CONSTEXPR14 auto move_ok() noexcept(noexcept(this->MoveOk())) -> ok_t&& { return MoveOk(); }
+
+    RESULT_CONSTEXPR14 auto move_error() noexcept(noexcept(this->MoveErr())) -> err_t&& { return MoveErr(); }
+
+    RESULT_CONSTEXPR20 void set_value(const ok_t& value) noexcept(
+        std::is_nothrow_copy_constructible<detail::stored_t<ok_t>>::value)
+    {
+        _data.reset_ok(value);
+    }
+
+    RESULT_CONSTEXPR20 void set_error(const err_t& error) noexcept(
+        std::is_nothrow_copy_constructible<detail::stored_t<err_t>>::value)
+    {
+        _data.reset_err(error);
+    }
+
+    // References are rebound by lvalue overloads above
+    template <typename T = ok_t, typename std::enable_if<!std::is_reference<T>::value, bool>::type = true>
+    RESULT_CONSTEXPR20 void set_value(ok_t&& value) noexcept(std::is_nothrow_move_constructible<T>::value)
+    {
+        _data.reset_ok(std::move(value));
+    }
+
+    template <typename T = err_t, typename std::enable_if<!std::is_reference<T>::value, bool>::type = true>
+    RESULT_CONSTEXPR20 void set_error(err_t&& error) noexcept(std::is_nothrow_move_constructible<T>::value)
+    {
+        _data.reset_err(std::move(error));
+    }
+
+    // Destroys current payload and builds new one in its place, without a temporary. Constructors that may throw
+    // give the basic guarantee: old payload is gone, Expected holds default constructed error (or value) in moved
+    // state, see ExpectedData::emplace_ok().
+    template <typename... Args, typename std::enable_if<std::is_constructible<detail::stored_t<ok_t>, Args&&...>::value,
+                                                        bool>::type = true>
+    RESULT_CONSTEXPR20 auto emplace(Args&&... args) noexcept(
+        std::is_nothrow_constructible<detail::stored_t<ok_t>, Args&&...>::value) -> ok_t&
+    {
+        _data.emplace_ok(std::forward<Args>(args)...);
+        return Ok();
+    }
+
+    template <typename U, typename... Args,
+              typename std::enable_if<std::is_constructible<ok_t, std::initializer_list<U>&, Args&&...>::value,
+                                      bool>::type = true>
+    RESULT_CONSTEXPR20 auto emplace(std::initializer_list<U> list, Args&&... args) noexcept(
+        std::is_nothrow_constructible<ok_t, std::initializer_list<U>&, Args&&...>::value) -> ok_t&
+    {
+        _data.emplace_ok(list, std::forward<Args>(args)...);
+        return Ok();
+    }
+
+    template <typename... Args, typename std::enable_if<
+                                    std::is_constructible<detail::stored_t<err_t>, Args&&...>::value, bool>::type = true>
+    RESULT_CONSTEXPR20 auto emplace_error(Args&&... args) noexcept(
+        std::is_nothrow_constructible<detail::stored_t<err_t>, Args&&...>::value) -> err_t&
+    {
+        _data.emplace_err(std::forward<Args>(args)...);
+        return Err();
+    }
+
+    template <typename U, typename... Args,
+              typename std::enable_if<std::is_constructible<err_t, std::initializer_list<U>&, Args&&...>::value,
+                                      bool>::type = true>
+    RESULT_CONSTEXPR20 auto emplace_error(std::initializer_list<U> list, Args&&... args) noexcept(
+        std::is_nothrow_constructible<err_t, std::initializer_list<U>&, Args&&...>::value) -> err_t&
+    {
+        _data.emplace_err(list, std::forward<Args>(args)...);
+        return Err();
+    }
+
+    template <typename T = ok_t, typename std::enable_if<std::is_same<T, EmptyValue>::value, T>::type* = nullptr>
+    RESULT_CONSTEXPR20 void set_success() noexcept(noexcept(set_value({})))
+    {
+        set_value({});
+    }
+
+    template <typename T = err_t, typename std::enable_if<std::is_same<T, SimpleError>::value, T>::type* = nullptr>
+    RESULT_CONSTEXPR20 void set_failure() noexcept(noexcept(set_error({})))
+    {
+        set_error({});
+    }
+
+    constexpr bool is_ok() const noexcept(true) { return _data.is_ok(); }
+
+    constexpr explicit operator bool() const noexcept(noexcept(is_ok())) { return is_ok(); }
+
+    // Monadic operations. Only is_ok() is checked, rvalue overloads move payload straight out of storage into the
+    // next stage, so long pipelines do not create intermediate copies
+    //     read_char(ptr).transform(to_digit).and_then(validate).value_or(0)
+
+    // Call f(value) returning Expected with the same error type, or propagate error
+    template <typename F, typename Ret = detail::invoke_result_t<F, ok_t&>>
+    RESULT_CONSTEXPR14 auto and_then(F&& f) & -> Ret
+    {
+        static_assert(detail::is_expected<Ret>::value, "and_then() function has to return Expected");
+        static_assert(std::is_same<typename Ret::err_t, err_t>::value,
+                      "and_then() function has to return Expected with the same error type");
+        if (_data.is_ok())
+            return std::forward<F>(f)(_data.ok());
+        return Ret(detail::err_tag_t{}, _data.err());
+    }
+
+    template <typename F, typename Ret = detail::invoke_result_t<F, const ok_t&>>
+    RESULT_CONSTEXPR14 auto and_then(F&& f) const& -> Ret
+    {
+        static_assert(detail::is_expected<Ret>::value, "and_then() function has to return Expected");
+        static_assert(std::is_same<typename Ret::err_t, err_t>::value,
+                      "and_then() function has to return Expected with the same error type");
+        if (_data.is_ok())
+            return std::forward<F>(f)(_data.ok());
+        return Ret(detail::err_tag_t{}, _data.err());
+    }
+
+    template <typename F, typename Ret = detail::invoke_result_t<F, ok_t&&>>
+    RESULT_CONSTEXPR14 auto and_then(F&& f) && -> Ret
+    {
+        static_assert(detail::is_expected<Ret>::value, "and_then() function has to return Expected");
+        static_assert(std::is_same<typename Ret::err_t, err_t>::value,
+                      "and_then() function has to return Expected with the same error type");
+        if (_data.is_ok())
+            return std::forward<F>(f)(std::move(_data).ok());
+        return Ret(detail::err_tag_t{}, std::move(_data).err());
+    }
+
+    // Replace value with f(value), void function results in EmptyValue
+    template <typename F, typename R = decltype(std::declval<F>()(std::declval<ok_t&>())),
+              typename Ret = Expected<detail::transform_value_t<typename std::decay<R>::type>, err_t, access_t>>
+    RESULT_CONSTEXPR14 auto transform(F&& f) & -> Ret
+    {
+        if (_data.is_ok())
+            return detail::TransformCall<R>::template call<Ret>(std::forward<F>(f), _data.ok());
+        return Ret(detail::err_tag_t{}, _data.err());
+    }
+
+    template <typename F, typename R = decltype(std::declval<F>()(std::declval<const ok_t&>())),
+              typename Ret = Expected<detail::transform_value_t<typename std::decay<R>::type>, err_t, access_t>>
+    RESULT_CONSTEXPR14 auto transform(F&& f) const& -> Ret
+    {
+        if (_data.is_ok())
+            return detail::TransformCall<R>::template call<Ret>(std::forward<F>(f), _data.ok());
+        return Ret(detail::err_tag_t{}, _data.err());
+    }
+
+    template <typename F, typename R = decltype(std::declval<F>()(std::declval<ok_t&&>())),
+              typename Ret = Expected<detail::transform_value_t<typename std::decay<R>::type>, err_t, access_t>>
+    RESULT_CONSTEXPR14 auto transform(F&& f) && -> Ret
+    {
+        if (_data.is_ok())
+            return detail::TransformCall<R>::template call<Ret>(std::forward<F>(f), std::move(_data).ok());
+        return Ret(detail::err_tag_t{}, std::move(_data).err());
+    }
+
+    // Call f(error) returning Expected with the same value type, or propagate value
+    template <typename F, typename Ret = detail::invoke_result_t<F, err_t&>>
+    RESULT_CONSTEXPR14 auto or_else(F&& f) & -> Ret
+    {
+        static_assert(detail::is_expected<Ret>::value, "or_else() function has to return Expected");
+        static_assert(std::is_same<typename Ret::ok_t, ok_t>::value,
+                      "or_else() function has to return Expected with the same value type");
+        if (_data.is_ok())
+            return Ret(detail::ok_tag_t{}, _data.ok());
+        return std::forward<F>(f)(_data.err());
+    }
+
+    template <typename F, typename Ret = detail::invoke_result_t<F, const err_t&>>
+    RESULT_CONSTEXPR14 auto or_else(F&& f) const& -> Ret
+    {
+        static_assert(detail::is_expected<Ret>::value, "or_else() function has to return Expected");
+        static_assert(std::is_same<typename Ret::ok_t, ok_t>::value,
+                      "or_else() function has to return Expected with the same value type");
+        if (_data.is_ok())
+            return Ret(detail::ok_tag_t{}, _data.ok());
+        return std::forward<F>(f)(_data.err());
+    }
+
+    template <typename F, typename Ret = detail::invoke_result_t<F, err_t&&>>
+    RESULT_CONSTEXPR14 auto or_else(F&& f) && -> Ret
+    {
+        static_assert(detail::is_expected<Ret>::value, "or_else() function has to return Expected");
+        static_assert(std::is_same<typename Ret::ok_t, ok_t>::value,
+                      "or_else() function has to return Expected with the same value type");
+        if (_data.is_ok())
+            return Ret(detail::ok_tag_t{}, std::move(_data).ok());
+        return std::forward<F>(f)(std::move(_data).err());
+    }
+
+    // Replace error with f(error)
+    template <typename F, typename Ret = Expected<ok_t, detail::invoke_result_t<F, err_t&>, access_t>>
+    RESULT_CONSTEXPR14 auto transform_error(F&& f) & -> Ret
+    {
+        if (_data.is_ok())
+            return Ret(detail::ok_tag_t{}, _data.ok());
+        return Ret(detail::err_tag_t{}, std::forward<F>(f)(_data.err()));
+    }
+
+    template <typename F, typename Ret = Expected<ok_t, detail::invoke_result_t<F, const err_t&>, access_t>>
+    RESULT_CONSTEXPR14 auto transform_error(F&& f) const& -> Ret
+    {
+        if (_data.is_ok())
+            return Ret(detail::ok_tag_t{}, _data.ok());
+        return Ret(detail::err_tag_t{}, std::forward<F>(f)(_data.err()));
+    }
+
+    template <typename F, typename Ret = Expected<ok_t, detail::invoke_result_t<F, err_t&&>, access_t>>
+    RESULT_CONSTEXPR14 auto transform_error(F&& f) && -> Ret
+    {
+        if (_data.is_ok())
+            return Ret(detail::ok_tag_t{}, std::move(_data).ok());
+        return Ret(detail::err_tag_t{}, std::forward<F>(f)(std::move(_data).err()));
+    }
+
+    // Error translated by RESULT_MAP_ERRORS table
+    template <typename To, typename Ret = Expected<ok_t, To, access_t>>
+    RESULT_CONSTEXPR14 auto map_error() const& -> Ret
+    {
+        if (_data.is_ok())
+            return Ret(detail::ok_tag_t{}, _data.ok());
+        return Ret(detail::err_tag_t{}, Result::map_error<To>(_data.err()));
+    }
+
+    template <typename To, typename Ret = Expected<ok_t, To, access_t>>
+    RESULT_CONSTEXPR14 auto map_error() && -> Ret
+    {
+        if (_data.is_ok())
+            return Ret(detail::ok_tag_t{}, std::move(_data).ok());
+        return Ret(detail::err_tag_t{}, Result::map_error<To>(_data.err()));
+    }
+
+    // Value, or f(error) when there is none
+    template <typename F>
+    RESULT_CONSTEXPR14 auto value_or_else(F&& f) const& -> ok_t
+    {
+        if (_data.is_ok())
+            return _data.ok();
+        return std::forward<F>(f)(_data.err());
+    }
+
+    template <typename F>
+    RESULT_CONSTEXPR14 auto value_or_else(F&& f) && -> ok_t
+    {
+        if (_data.is_ok())
+            return std::move(_data).ok();
+        return std::forward<F>(f)(std::move(_data).err());
+    }
+
+private:
+    template <typename, typename, typename>
+    friend struct Expected;
+    template <typename>
+    friend struct detail::TransformCall;
+    friend struct detail::TryAccess;
+    template <typename>
+    friend struct detail::ExpectedReturn;
+
+    // Result of a coroutine converted before its body ran, the coroutine constructs it in place later
+    Expected(detail::unset_tag_t tag, Expected*& self) noexcept(true) : _data(tag) { self = this; }
+
+    template <typename... Args>
+    constexpr Expected(detail::ok_tag_t tag, Args&&... args) : _data(tag, std::forward<Args>(args)...)
+    {
+    }
+
+    template <typename... Args>
+    constexpr Expected(detail::err_tag_t tag, Args&&... args) : _data(tag, std::forward<Args>(args)...)
+    {
+    }
+
+    RESULT_CONSTEXPR14 ok_t& Ok() noexcept(true) { return _data.ok(); }
+    constexpr const ok_t& Ok() const noexcept(true) { return _data.ok(); }
+    RESULT_CONSTEXPR14 ok_t&& MoveOk(RESULT_TELEMETRY_SITE_PARAM) noexcept(noexcept(handle_error()))
+    {
+        if (!_data.holds_ok())
+            handle_error("Attempting to move in MoveOk", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        _data.set_moved();
+        return std::move(_data.ok());
+    }
+    RESULT_CONSTEXPR14 err_t& Err() noexcept(true) { return _data.err(); }
+    constexpr const err_t& Err() const noexcept(true) { return _data.err(); }
+    RESULT_CONSTEXPR14 err_t&& MoveErr(RESULT_TELEMETRY_SITE_PARAM) noexcept(noexcept(handle_error()))
+    {
+        if (!_data.holds_err())
+            handle_error("Attempting to move in MoveErr", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        _data.set_moved();
+        return std::move(_data.err());
+    }
+
+    detail::ExpectedStorage<ok_t, err_t> _data;
+};
+
+// Forwarding factories: temporaries are moved into Success/Failure, lvalues are copied once.
+// Like std::make_pair, std::ref(x)/std::cref(x) results in Success<T&>/Failure<T&>
+template <typename Value = EmptyValue>
+[[nodiscard]] constexpr auto Ok(Value&& val = {}) -> Success<detail::unwrap_ref_decay_t<Value>>
+{
+    return Success<detail::unwrap_ref_decay_t<Value>>(std::forward<Value>(val));
+}
+
+template <typename ErrorType = SimpleError>
+[[nodiscard]] constexpr auto Error(ErrorType&& err = {} RESULT_TELEMETRY_AND_SITE_PARAM)
+    -> Failure<detail::unwrap_ref_decay_t<ErrorType>>
+{
+    return Failure<detail::unwrap_ref_decay_t<ErrorType>>(std::forward<ErrorType>(err) RESULT_TELEMETRY_AND_SITE);
+}
+}  // namespace Result
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RESULT_UNLIKELY(cond) __builtin_expect(!!(cond), 0)
+#define RESULT_HAS_STATEMENT_EXPRESSIONS 1
+#else
+#define RESULT_UNLIKELY(cond) (cond)
+#define RESULT_HAS_STATEMENT_EXPRESSIONS 0
+#endif
+
+// Declares error_map<From, To>, mapping is a braced list of {From value, To value} pairs. Has to be used in
+// the global namespace.
+#define RESULT_MAP_ERRORS(From, To, ...)                                                                     \
+    template <>                                                                                              \
+    struct Result::error_map<From, To> {                                                                     \
+        static constexpr bool available = true;                                                              \
+        static constexpr ::Result::detail::ErrorMapping<From, To> pairs[] = __VA_ARGS__;                     \
+        static_assert(::Result::detail::maps_every_error(pairs),                                             \
+                      "RESULT_MAP_ERRORS has to map every value of " #From " exactly once");                 \
+    }
+
+#define RESULT_TRY_CONCAT_IMPL(a, b) a##b
+#define RESULT_TRY_CONCAT(a, b) RESULT_TRY_CONCAT_IMPL(a, b)
+
+// Early return of the error of expr from the current function, which has to return Expected with error type
+// constructible from it. Error is moved (from temporaries) straight into the returned Expected.
+// Where GNU statement expressions are available RESULT_TRY(expr) is also an expression with value of expr:
+//     int digit = RESULT_TRY(read_char(ptr)) - '0';
+// elsewhere it is a statement only and RESULT_TRY_ASSIGN has to be used to get the value.
+#define RESULT_TRY(...) RESULT_TRY_IMPL(RESULT_TRY_CONCAT(result_try_, __COUNTER__), __VA_ARGS__)
+#if RESULT_HAS_STATEMENT_EXPRESSIONS
+#define RESULT_TRY_IMPL(tmp, ...)                                                 \
+    __extension__({                                                               \
+        auto&& tmp = (__VA_ARGS__);                                               \
+        if (RESULT_UNLIKELY(!tmp.is_ok()))                                        \
+            return ::Result::detail::propagate(std::forward<decltype(tmp)>(tmp)); \
+        ::Result::detail::TryAccess::value(std::forward<decltype(tmp)>(tmp));     \
+    })
+#else
+#define RESULT_TRY_IMPL(tmp, ...)                                                 \
+    do {                                                                          \
+        auto&& tmp = (__VA_ARGS__);                                               \
+        if (RESULT_UNLIKELY(!tmp.is_ok()))                                        \
+            return ::Result::detail::propagate(std::forward<decltype(tmp)>(tmp)); \
+    } while (false)
+#endif
+
+// Declares or assigns var with value of expr, or returns its error like RESULT_TRY:
+//     RESULT_TRY_ASSIGN(auto line, read_line(ptr));
+#define RESULT_TRY_ASSIGN(var, ...) \
+    RESULT_TRY_ASSIGN_IMPL(RESULT_TRY_CONCAT(result_try_, __COUNTER__), var, __VA_ARGS__)
+#define RESULT_TRY_ASSIGN_IMPL(tmp, var, ...)                                 \
+    auto&& tmp = (__VA_ARGS__);                                               \
+    if (RESULT_UNLIKELY(!tmp.is_ok()))                                        \
+        return ::Result::detail::propagate(std::forward<decltype(tmp)>(tmp)); \
+    var = ::Result::detail::TryAccess::value(std::forward<decltype(tmp)>(tmp))
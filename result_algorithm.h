@@ -0,0 +1,110 @@
+#pragma once
+#include "result.h"
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Result
+{
+namespace detail
+{
+template <typename Range>
+using range_iterator_t = decltype(std::begin(std::declval<Range&>()));
+
+template <typename Range>
+using range_value_t = typename std::iterator_traits<range_iterator_t<Range>>::value_type;
+
+// Element of a range with value category of the range itself, so rvalue ranges are moved from
+template <typename Range, typename Elem>
+auto forward_element(Elem& elem) noexcept(true) ->
+    typename std::conditional<std::is_lvalue_reference<Range>::value, Elem&, Elem&&>::type
+{
+    return static_cast<typename std::conditional<std::is_lvalue_reference<Range>::value, Elem&, Elem&&>::type>(elem);
+}
+
+template <typename Range>
+using range_element_t = typename std::remove_reference<decltype(*std::begin(std::declval<Range&>()))>::type;
+
+template <typename Range>
+using forwarded_element_t = decltype(forward_element<Range>(std::declval<range_element_t<Range>&>()));
+
+template <typename Vector, typename Range>
+void reserve_by_category(Vector& out, Range& range, std::random_access_iterator_tag)
+{
+    out.reserve(static_cast<size_t>(std::distance(std::begin(range), std::end(range))));
+}
+
+template <typename Vector, typename Range>
+void reserve_by_category(Vector&, Range&, std::input_iterator_tag)
+{
+}
+
+// Ranges with size() or random access iterators are measured up front, other ones grow as usual
+template <typename Vector, typename Range>
+auto reserve_for(Vector& out, Range& range, int) -> decltype(static_cast<size_t>(range.size()), void())
+{
+    out.reserve(static_cast<size_t>(range.size()));
+}
+
+template <typename Vector, typename Range>
+void reserve_for(Vector& out, Range& range, long)
+{
+    reserve_by_category(out, range,
+                        typename std::iterator_traits<range_iterator_t<Range>>::iterator_category{});
+}
+}  // namespace detail
+
+// All values of a range of Expected, or the first error. Elements after the first error are not touched.
+template <typename Range, typename Exp = detail::range_value_t<Range>,
+          typename Ret = Expected<std::vector<typename Exp::ok_t>, typename Exp::err_t, typename Exp::access_t>>
+auto collect(Range&& range) -> Ret
+{
+    static_assert(detail::is_expected<Exp>::value, "collect() requires range of Expected");
+    std::vector<typename Exp::ok_t> values;
+    detail::reserve_for(values, range, 0);
+    for (auto&& elem : range) {
+        auto* ok = elem.value_ptr();
+        if (ok == nullptr)
+            return Ret(unexpect, detail::forward_element<Range>(elem).error());
+        values.push_back(detail::forward_element<Range>(*ok));
+    }
+    return Ret(in_place, std::move(values));
+}
+
+// Values and errors of a range of Expected split in one pass, order of elements is kept
+template <typename Range, typename Exp = detail::range_value_t<Range>>
+auto partition(Range&& range) -> std::pair<std::vector<typename Exp::ok_t>, std::vector<typename Exp::err_t>>
+{
+    static_assert(detail::is_expected<Exp>::value, "partition() requires range of Expected");
+    std::pair<std::vector<typename Exp::ok_t>, std::vector<typename Exp::err_t>> parts;
+    detail::reserve_for(parts.first, range, 0);
+    for (auto&& elem : range) {
+        if (auto* ok = elem.value_ptr())
+            parts.first.push_back(detail::forward_element<Range>(*ok));
+        else
+            parts.second.push_back(detail::forward_element<Range>(elem).error());
+    }
+    return parts;
+}
+
+// f applied to every element until it fails, f has to return Expected
+template <typename Range, typename F, typename Res = detail::invoke_result_t<F, detail::forwarded_element_t<Range>>,
+          typename Ret = Expected<std::vector<typename Res::ok_t>, typename Res::err_t, typename Res::access_t>>
+auto try_transform(Range&& range, F&& f) -> Ret
+{
+    static_assert(detail::is_expected<Res>::value, "try_transform() function has to return Expected");
+    std::vector<typename Res::ok_t> values;
+    detail::reserve_for(values, range, 0);
+    for (auto&& elem : range) {
+        Res res = f(detail::forward_element<Range>(elem));
+        auto* ok = res.value_ptr();
+        if (ok == nullptr)
+            return Ret(unexpect, std::move(res).error());
+        values.push_back(std::move(*ok));
+    }
+    return Ret(in_place, std::move(values));
+}
+}  // namespace Result
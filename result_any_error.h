@@ -0,0 +1,178 @@
+#pragma once
+#include "result.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Error of any layer behind one type, for module boundaries. Error is copied into inline storage together with
+// a tag of its type, so nothing is allocated and headers of other layers are needed only to inspect it:
+//     Result::Expected<Row, Result::AnyError> fetch(int id) { return Result::Error(DbError::Timeout); }
+//     if (const DbError* err = res.error().get_if<DbError>())
+//         retry(*err);
+// Enums are taken as they are, other error types opt in:
+//     template <> struct Result::error_domain_traits<ErrnoError> : Result::error_domain<ErrnoError> {};
+// Stored error has to be trivially copyable (it is relocated with memcpy) and fit in Capacity bytes.
+// Type tag is a hash of the type name, so it is the same in every shared library built by the same compiler. Types
+// from an anonymous namespace share the name with their namesakes in other files, they get their own id:
+//     template <> struct Result::error_domain_traits<ParseError> : Result::error_domain<ParseError, 0x5041525345> {};
+
+namespace Result
+{
+namespace detail
+{
+constexpr uint64_t fnv1a(const char* str, uint64_t hash) noexcept(true)
+{
+    return *str == '\0' ? hash : fnv1a(str + 1, (hash ^ static_cast<unsigned char>(*str)) * 0x100000001b3ULL);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RESULT_TYPE_SIGNATURE __PRETTY_FUNCTION__
+#elif defined(_MSC_VER)
+#define RESULT_TYPE_SIGNATURE __FUNCSIG__
+#endif
+
+#if defined(RESULT_TYPE_SIGNATURE)
+// Signature names the type, unlike typeid it is available at compile time and without RTTI
+template <typename T>
+constexpr const char* type_signature() noexcept(true)
+{
+    return RESULT_TYPE_SIGNATURE;
+}
+
+template <typename T>
+constexpr uint64_t type_name_hash() noexcept(true)
+{
+    return fnv1a(type_signature<T>(), 0xcbf29ce484222325ULL);
+}
+#else
+// Every type needs its own id in error_domain_traits then
+template <typename T>
+constexpr uint64_t type_name_hash() noexcept(true)
+{
+    return 0;
+}
+#endif
+#undef RESULT_TYPE_SIGNATURE
+}  // namespace detail
+
+// Marks ErrorType as storable in AnyError under given id, 0 is for empty AnyError
+template <typename ErrorType, uint64_t Id = detail::type_name_hash<ErrorType>()>
+struct error_domain {
+    static_assert(Id != 0, "error domain needs an id on this compiler");
+    static constexpr bool erasable = true;
+    static constexpr uint64_t id = Id;
+};
+
+namespace detail
+{
+struct not_erasable {
+    static constexpr bool erasable = false;
+    static constexpr uint64_t id = 0;
+};
+}  // namespace detail
+
+template <typename ErrorType>
+struct error_domain_traits
+    : std::conditional<std::is_enum<ErrorType>::value, error_domain<ErrorType>, detail::not_erasable>::type {
+};
+
+template <>
+struct error_domain_traits<SimpleError> : error_domain<SimpleError> {
+};
+
+template <size_t Capacity>
+struct BasicAnyError;
+
+namespace detail
+{
+// Results and AnyError itself are never stored as an error
+template <typename T>
+struct never_erased : is_expected<T> {
+};
+
+template <typename T>
+struct never_erased<Success<T>> : std::true_type {
+};
+
+template <typename T>
+struct never_erased<Failure<T>> : std::true_type {
+};
+
+template <size_t Capacity>
+struct never_erased<BasicAnyError<Capacity>> : std::true_type {
+};
+
+template <size_t Capacity>
+struct is_widening_error<BasicAnyError<Capacity>> : std::true_type {
+};
+}  // namespace detail
+
+template <size_t Capacity = 16>
+struct BasicAnyError {
+    static constexpr size_t capacity = Capacity;
+    static constexpr size_t alignment = alignof(uint64_t);
+
+    template <typename E>
+    struct fits : std::integral_constant<bool, !detail::never_erased<E>::value && error_domain_traits<E>::erasable &&
+                                                   std::is_trivially_copyable<E>::value && sizeof(E) <= Capacity &&
+                                                   alignof(E) <= alignment> {
+    };
+
+    // No error stored
+    BasicAnyError() noexcept(true) : _domain(0), _storage{} {}
+
+    // Implicit for enums and error types with error_domain_traits only
+    template <typename E, typename std::enable_if<fits<E>::value, bool>::type = true>
+    BasicAnyError(const E& error) noexcept(true) : _domain(error_domain_traits<E>::id), _storage{}
+    {
+        std::memcpy(_storage, &error, sizeof(E));
+    }
+
+    template <typename E, typename std::enable_if<fits<E>::value, bool>::type = true>
+    bool is() const noexcept(true)
+    {
+        return _domain == error_domain_traits<E>::id;
+    }
+
+    template <typename E, typename std::enable_if<fits<E>::value, bool>::type = true>
+    const E* get_if() const noexcept(true)
+    {
+        return is<E>() ? reinterpret_cast<const E*>(_storage) : nullptr;
+    }
+
+    bool empty() const noexcept(true) { return _domain == 0; }
+
+    // Id of stored error type, 0 when empty
+    uint64_t domain() const noexcept(true) { return _domain; }
+
+    // Compared bytewise, unused bytes are zeroed, so errors with padding bytes may compare unequal
+    bool operator==(const BasicAnyError& other) const noexcept(true)
+    {
+        return _domain == other._domain && std::memcmp(_storage, other._storage, Capacity) == 0;
+    }
+
+    bool operator!=(const BasicAnyError& other) const noexcept(true) { return !(*this == other); }
+
+    // Stored error equals err of type E
+    template <typename E, typename std::enable_if<fits<E>::value, bool>::type = true>
+    bool operator==(const E& err) const noexcept(true)
+    {
+        return *this == BasicAnyError(err);
+    }
+
+    template <typename E, typename std::enable_if<fits<E>::value, bool>::type = true>
+    bool operator!=(const E& err) const noexcept(true)
+    {
+        return !(*this == err);
+    }
+
+private:
+    uint64_t _domain;
+    alignas(alignment) unsigned char _storage[Capacity];
+};
+
+// Big enough for enums, error codes with a pointer to their category and similar small structs
+using AnyError = BasicAnyError<16>;
+}  // namespace Result
@@ -0,0 +1,308 @@
+#pragma once
+#include "result.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Memoizes a function returning Expected, failures included, so repeated misses stop reaching the backend:
+//     Result::ExpectedCache<std::string, int, ErrorType>::Options options;
+//     options.error_ttl = std::chrono::seconds(5);
+//     options.cache_error = [](ErrorType err) { return err != ErrorType::Database; };
+//     Result::ExpectedCache<std::string, int, ErrorType> ids(user_id, options);
+//     auto id = ids.get("user");
+// Keys are spread over shards guarded by reader-writer locks, hits take only the shared lock of one shard.
+// Concurrent misses of one key wait for a single call of the function. Shard which is full drops its entry
+// stored least recently (first in, first out, storing a fresh result moves the key to the back), in constant time.
+
+namespace Result
+{
+template <typename K, typename T, typename E = SimpleError, typename BadAccess = DefaultBadAccess,
+          typename Hash = std::hash<K>, typename Clock = std::chrono::steady_clock>
+struct ExpectedCache {
+public:
+    using key_t = K;
+    using expected_t = Expected<T, E, BadAccess>;
+    using duration_t = typename Clock::duration;
+    using loader_t = std::function<expected_t(const K&)>;
+
+    struct Options {
+        size_t shards = 16;                                   // rounded up to power of two
+        size_t capacity = 65536;                              // entries of all shards together
+        duration_t value_ttl = std::chrono::seconds(60);
+        duration_t error_ttl = std::chrono::seconds(5);       // zero disables negative caching
+        std::function<bool(const E&)> cache_error = nullptr;  // errors to keep, all when empty
+    };
+
+    // Totals since construction
+    struct Stats {
+        uint64_t hits;
+        uint64_t negative_hits;  // cached errors returned
+        uint64_t loads;          // calls of the function
+        uint64_t coalesced;      // misses which waited for a call made by another thread
+    };
+
+    explicit ExpectedCache(loader_t loader) : ExpectedCache(std::move(loader), Options()) {}
+
+    ExpectedCache(loader_t loader, Options options)
+        : _loader(std::move(loader)), _options(std::move(options)), _shards(shard_count(_options.shards))
+    {
+        _shard_capacity = (_options.capacity + _shards.size() - 1) / _shards.size();
+    }
+
+    ExpectedCache(const ExpectedCache&) = delete;
+    ExpectedCache& operator=(const ExpectedCache&) = delete;
+
+    // Cached result while it is fresh, otherwise result of the function
+    expected_t get(const K& key)
+    {
+        Shard& shard = shard_of(key);
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.entries.find(key);
+            if (it != shard.entries.end() && Clock::now() < it->second.expires) {
+                (it->second.result.is_ok() ? shard.hits : shard.negative_hits).fetch_add(1, std::memory_order_relaxed);
+                return it->second.result;
+            }
+        }
+        return load(shard, key);
+    }
+
+    // Drops cached result, call in flight is not affected
+    void erase(const K& key)
+    {
+        Shard& shard = shard_of(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end())
+            drop(shard, it);
+    }
+
+    void clear()
+    {
+        for (Shard& shard : _shards) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.entries.clear();
+            shard.order.clear();
+        }
+    }
+
+    // Cached results, expired ones included until they are replaced or evicted
+    size_t size() const
+    {
+        size_t count = 0;
+        for (const Shard& shard : _shards) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            count += shard.entries.size();
+        }
+        return count;
+    }
+
+    Stats stats() const noexcept(true)
+    {
+        Stats total{0, 0, 0, 0};
+        for (const Shard& shard : _shards) {
+            total.hits += shard.hits.load(std::memory_order_relaxed);
+            total.negative_hits += shard.negative_hits.load(std::memory_order_relaxed);
+            total.loads += shard.loads.load(std::memory_order_relaxed);
+            total.coalesced += shard.coalesced.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    using order_t = std::list<K>;
+
+    struct Entry {
+        expected_t result;
+        typename Clock::time_point expires;
+        typename order_t::iterator position;  // node of the key in Shard::order
+    };
+
+    // Call of the function shared by all threads missing the same key
+    struct Flight {
+        std::mutex mutex;
+        std::condition_variable done;
+        bool ready = false;
+        std::unique_ptr<expected_t> result;  // null when the call threw
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<K, Entry, Hash> entries;
+        order_t order;  // keys of entries, least recently stored first
+        std::unordered_map<K, std::shared_ptr<Flight>, Hash> flights;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> negative_hits{0};
+        std::atomic<uint64_t> loads{0};
+        std::atomic<uint64_t> coalesced{0};
+    };
+
+    // Ends the flight of the leader when the function (or anything after it) throws, waiters see no result then
+    // and retry with a call of their own
+    struct FlightGuard {
+        FlightGuard(Shard& shard, const K& key, Flight& flight) noexcept(true)
+            : _shard(shard), _key(key), _flight(flight)
+        {
+        }
+
+        FlightGuard(const FlightGuard&) = delete;
+        FlightGuard& operator=(const FlightGuard&) = delete;
+
+        ~FlightGuard()
+        {
+            if (_landed)
+                return;
+            {
+                std::unique_lock<std::shared_mutex> lock(_shard.mutex);
+                // Another flight of the key may have started once this one was erased
+                auto it = _shard.flights.find(_key);
+                if (it != _shard.flights.end() && it->second.get() == &_flight)
+                    _shard.flights.erase(it);
+            }
+            {
+                std::lock_guard<std::mutex> lock(_flight.mutex);
+                _flight.ready = true;
+            }
+            _flight.done.notify_all();
+        }
+
+        void land() noexcept(true) { _landed = true; }
+
+    private:
+        Shard& _shard;
+        const K& _key;
+        Flight& _flight;
+        bool _landed = false;
+    };
+
+    static size_t shard_count(size_t requested) noexcept(true)
+    {
+        size_t count = 1;
+        while (count < requested)
+            count <<= 1U;
+        return count;
+    }
+
+    // Top bits of mixed hash pick the shard, the map of the shard uses the low ones
+    Shard& shard_of(const K& key) noexcept(true)
+    {
+        const uint64_t mixed = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ULL;
+        return _shards[static_cast<uint32_t>(mixed >> 32U) & (_shards.size() - 1)];
+    }
+
+    duration_t ttl_of(const expected_t& res) const
+    {
+        if (res.is_ok())
+            return _options.value_ttl;
+        if (_options.cache_error && !_options.cache_error(res.error()))
+            return duration_t::zero();
+        return _options.error_ttl;
+    }
+
+    // Waiter retries when the call of the leader threw
+    expected_t load(Shard& shard, const K& key)
+    {
+        std::shared_ptr<Flight> flight;
+        bool leader = false;
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.entries.find(key);
+            if (it != shard.entries.end() && Clock::now() < it->second.expires) {
+                (it->second.result.is_ok() ? shard.hits : shard.negative_hits).fetch_add(1, std::memory_order_relaxed);
+                return it->second.result;
+            }
+            auto& slot = shard.flights[key];
+            if (!slot) {
+                slot = std::make_shared<Flight>();
+                leader = true;
+            }
+            flight = slot;
+        }
+        if (!leader) {
+            shard.coalesced.fetch_add(1, std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(flight->mutex);
+            flight->done.wait(lock, [&flight] { return flight->ready; });
+            if (flight->result)
+                return *flight->result;
+            lock.unlock();
+            return load(shard, key);
+        }
+
+        FlightGuard guard(shard, key, *flight);
+        shard.loads.fetch_add(1, std::memory_order_relaxed);
+        expected_t res = _loader(key);
+        const duration_t ttl = ttl_of(res);
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            store(shard, key, res, ttl);
+            shard.flights.erase(key);
+        }
+        {
+            std::lock_guard<std::mutex> lock(flight->mutex);
+            flight->result.reset(new expected_t(res));
+            flight->ready = true;
+        }
+        guard.land();
+        flight->done.notify_all();
+        return res;
+    }
+
+    // Under the exclusive lock of the shard, zero ttl drops the cached result
+    void store(Shard& shard, const K& key, const expected_t& res, duration_t ttl)
+    {
+        auto it = shard.entries.find(key);
+        if (ttl <= duration_t::zero()) {
+            if (it != shard.entries.end())
+                drop(shard, it);
+            return;
+        }
+        if (it != shard.entries.end()) {
+            it->second.result = res;
+            it->second.expires = Clock::now() + ttl;
+            shard.order.splice(shard.order.end(), shard.order, it->second.position);
+            return;
+        }
+        if (shard.entries.size() >= _shard_capacity)
+            evict(shard);
+        // Node goes first, if the entry can not be added it stays behind without an owner and evict() skips it
+        const auto position = shard.order.insert(shard.order.end(), key);
+        shard.entries.emplace(key, Entry{res, Clock::now() + ttl, position});
+    }
+
+    static void drop(Shard& shard, typename std::unordered_map<K, Entry, Hash>::iterator it)
+    {
+        shard.order.erase(it->second.position);
+        shard.entries.erase(it);
+    }
+
+    // Least recently stored entry goes
+    static void evict(Shard& shard)
+    {
+        while (!shard.order.empty()) {
+            const auto oldest = shard.order.begin();
+            auto it = shard.entries.find(*oldest);
+            if (it != shard.entries.end() && it->second.position == oldest) {
+                drop(shard, it);
+                return;
+            }
+            shard.order.erase(oldest);
+        }
+    }
+
+    loader_t _loader;
+    Options _options;
+    std::vector<Shard> _shards;
+    size_t _shard_capacity;
+};
+}  // namespace Result
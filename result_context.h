@@ -0,0 +1,270 @@
+#pragma once
+#include "result.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Error context chains ("what failed, where") kept in a per thread bump arena, so adding context never touches
+// the heap in steady state. Errors carry only a pointer to the newest frame:
+//     Result::ContextScope request;  // frames created below are reclaimed at the end of the scope
+//     Result::Expected<User, Result::Contextual<DbError>> user =
+//         load_user(id).transform_error(RESULT_CONTEXT("loading user"));
+//     log(user.error().context.to_string());  // "loading user (service.cc:42) <- ..."
+// Chain is valid until the ContextScope active when its newest frame was added ends.
+// Frames are reclaimed only by a ContextScope, so code adding context needs one around each unit of work (request,
+// job, loop iteration). Without it the arena of a long running thread grows up to ContextArena::max_size, after
+// that new frames are dropped and chains stop growing.
+
+namespace Result
+{
+struct ContextFrame {
+    const char* what;
+    const char* file;
+    int line;
+    const ContextFrame* next;
+};
+
+// Bump allocator of the current thread. First block is part of the arena itself, further blocks are allocated
+// once and kept for reuse when the arena is rewound, up to max_size bytes in total.
+struct ContextArena {
+public:
+    static constexpr size_t inline_size = 4096;
+    static constexpr size_t block_size = 64 * 1024;
+    static constexpr size_t max_size = 16 * 1024 * 1024;
+
+    // Position which the arena can be rewound to
+    struct Mark {
+        void* block;
+        size_t offset;
+    };
+
+    ContextArena() noexcept(true)
+        : _first{nullptr, _inline, inline_size}, _current(&_first), _offset(0), _capacity(inline_size)
+    {
+    }
+
+    ContextArena(const ContextArena&) = delete;
+    ContextArena& operator=(const ContextArena&) = delete;
+
+    ~ContextArena()
+    {
+        Block* block = _first.next;
+        while (block != nullptr) {
+            Block* next = block->next;
+            std::free(block);
+            block = next;
+        }
+    }
+
+    static ContextArena& local() noexcept(true)
+    {
+        thread_local ContextArena arena;
+        return arena;
+    }
+
+    // Memory for size bytes aligned to align (at most alignof(max_align_t)), or nullptr if heap is exhausted or
+    // arena would grow past max_size
+    void* allocate(size_t size, size_t align) noexcept(true)
+    {
+        for (;;) {
+            const size_t start = (_offset + align - 1) & ~(align - 1);
+            if (start + size <= _current->size) {
+                _offset = start + size;
+                return _current->data + start;
+            }
+            if (_current->next == nullptr && !grow(size))
+                return nullptr;
+            _current = _current->next;
+            _offset = 0;
+        }
+    }
+
+    Mark mark() const noexcept(true) { return Mark{_current, _offset}; }
+
+    // Everything allocated after m is released at once, blocks stay for reuse
+    void rewind(Mark m) noexcept(true)
+    {
+        _current = static_cast<Block*>(m.block);
+        _offset = m.offset;
+    }
+
+    // Bytes available without allocating another block
+    size_t capacity() const noexcept(true) { return _capacity; }
+
+private:
+    struct alignas(std::max_align_t) Block {
+        Block* next;
+        char* data;
+        size_t size;
+    };
+
+    bool grow(size_t size) noexcept(true)
+    {
+        const size_t bytes = size > block_size ? size : block_size;
+        if (bytes > max_size - _capacity)
+            return false;
+        void* mem = std::malloc(sizeof(Block) + bytes);
+        if (mem == nullptr)
+            return false;
+        _current->next = ::new (mem) Block{nullptr, static_cast<char*>(mem) + sizeof(Block), bytes};
+        _capacity += bytes;
+        return true;
+    }
+
+    alignas(std::max_align_t) char _inline[inline_size];
+    Block _first;
+    Block* _current;
+    size_t _offset;
+    size_t _capacity;
+};
+
+// Frames added to the thread arena while the scope is alive are reclaimed when it ends, e.g. one per request
+struct ContextScope {
+public:
+    ContextScope() noexcept(true) : _arena(ContextArena::local()), _mark(_arena.mark()) {}
+    ContextScope(const ContextScope&) = delete;
+    ContextScope& operator=(const ContextScope&) = delete;
+    ~ContextScope() { _arena.rewind(_mark); }
+
+private:
+    ContextArena& _arena;
+    ContextArena::Mark _mark;
+};
+
+// Handle to a chain of frames, newest first
+struct Context {
+public:
+    struct Iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ContextFrame;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ContextFrame*;
+        using reference = const ContextFrame&;
+
+        reference operator*() const noexcept(true) { return *_frame; }
+        pointer operator->() const noexcept(true) { return _frame; }
+        Iterator& operator++() noexcept(true)
+        {
+            _frame = _frame->next;
+            return *this;
+        }
+        Iterator operator++(int) noexcept(true)
+        {
+            Iterator prev = *this;
+            _frame = _frame->next;
+            return prev;
+        }
+        bool operator==(const Iterator& other) const noexcept(true) { return _frame == other._frame; }
+        bool operator!=(const Iterator& other) const noexcept(true) { return _frame != other._frame; }
+
+        const ContextFrame* _frame;
+    };
+
+    constexpr Context() noexcept(true) : _frames(nullptr) {}
+
+    // Chain with one more frame in front, frame is dropped if arena can not get memory (see ContextArena::max_size)
+    Context push(const char* what, const char* file, int line) const noexcept(true)
+    {
+        void* mem = ContextArena::local().allocate(sizeof(ContextFrame), alignof(ContextFrame));
+        if (mem == nullptr)
+            return *this;
+        return Context(::new (mem) ContextFrame{what, file, line, _frames});
+    }
+
+    bool empty() const noexcept(true) { return _frames == nullptr; }
+
+    size_t depth() const noexcept(true)
+    {
+        size_t count = 0;
+        for (const ContextFrame* frame = _frames; frame != nullptr; frame = frame->next)
+            ++count;
+        return count;
+    }
+
+    Iterator begin() const noexcept(true) { return Iterator{_frames}; }
+    Iterator end() const noexcept(true) { return Iterator{nullptr}; }
+
+    // "outer (file:line) <- inner (file:line)", allocates, meant for reporting only
+    std::string to_string() const
+    {
+        std::string out;
+        for (const ContextFrame& frame : *this) {
+            if (!out.empty())
+                out += " <- ";
+            out += frame.what;
+            out += " (";
+            out += frame.file;
+            out += ':';
+            out += std::to_string(frame.line);
+            out += ')';
+        }
+        return out;
+    }
+
+private:
+    explicit Context(const ContextFrame* frames) noexcept(true) : _frames(frames) {}
+
+    const ContextFrame* _frames;
+};
+
+// Error with context chain, one pointer bigger than the error itself
+template <typename ErrorType>
+struct Contextual {
+    using err_t = ErrorType;
+
+    bool operator==(const Contextual& other) const { return error == other.error; }
+
+    ErrorType error;
+    Context context;
+};
+
+namespace detail
+{
+template <typename T>
+struct is_contextual : std::false_type {
+};
+
+template <typename E>
+struct is_contextual<Contextual<E>> : std::true_type {
+};
+}  // namespace detail
+
+// Adds a frame to error passed through transform_error(), plain errors become Contextual
+struct ContextAppender {
+    template <typename E, typename Err = typename std::decay<E>::type,
+              typename std::enable_if<!detail::is_contextual<Err>::value, bool>::type = true>
+    auto operator()(E&& error) const -> Contextual<Err>
+    {
+        return Contextual<Err>{std::forward<E>(error), Context().push(what, file, line)};
+    }
+
+    template <typename E>
+    auto operator()(Contextual<E>&& error) const -> Contextual<E>
+    {
+        return Contextual<E>{std::move(error.error), error.context.push(what, file, line)};
+    }
+
+    template <typename E>
+    auto operator()(const Contextual<E>& error) const -> Contextual<E>
+    {
+        return Contextual<E>{error.error, error.context.push(what, file, line)};
+    }
+
+    const char* what;
+    const char* file;
+    int line;
+};
+
+// what and file have to outlive the chain, string literals are expected
+inline auto with_context(const char* what, const char* file, int line) noexcept(true) -> ContextAppender
+{
+    return ContextAppender{what, file, line};
+}
+}  // namespace Result
+
+#define RESULT_CONTEXT(what) ::Result::with_context(what, __FILE__, __LINE__)
@@ -0,0 +1,315 @@
+#pragma once
+#include "result.h"
+
+// Expected as a coroutine return type (C++20):
+//     Result::Expected<Row, DbError> load(int id)
+//     {
+//         auto blob = co_await read_blob(id);  // value, or the error is returned from load()
+//         co_return Result::Ok(Row(blob));
+//     }
+// Coroutine runs to completion before the call returns, so it never outlives its caller. Result is correct whether
+// the compiler converts the return object before the body runs or after it finishes.
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define RESULT_HAS_COROUTINES 1
+#endif
+#endif
+
+#if defined(RESULT_HAS_COROUTINES)
+#include <coroutine>
+#include <cstddef>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Result
+{
+// Source of memory for coroutine frames which compiler did not elide. Every thread has its own current allocator
+// (FramePool by default), each frame remembers the one it came from.
+struct FrameAllocator {
+    virtual ~FrameAllocator() = default;
+    virtual void* allocate(size_t size) = 0;
+    virtual void deallocate(void* ptr, size_t size) noexcept = 0;
+
+    static FrameAllocator*& current() noexcept;
+};
+
+// Per thread free lists of 64 byte size classes up to 1 KiB, bigger frames go to the global heap.
+// Freed blocks are kept for reuse until the thread exits.
+struct FramePool final : FrameAllocator {
+public:
+    static constexpr size_t granularity = 64;
+    static constexpr size_t classes = 16;
+
+    FramePool() = default;
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    ~FramePool() override
+    {
+        for (size_t cls = 0; cls < classes; ++cls) {
+            while (Node* node = _free[cls]) {
+                _free[cls] = node->next;
+                ::operator delete(node, (cls + 1) * granularity);
+            }
+        }
+    }
+
+    void* allocate(size_t size) override
+    {
+        const size_t cls = (size + granularity - 1) / granularity;
+        if (cls > classes)
+            return ::operator new(size);
+        if (Node* node = _free[cls - 1]) {
+            _free[cls - 1] = node->next;
+            return node;
+        }
+        return ::operator new(cls * granularity);
+    }
+
+    void deallocate(void* ptr, size_t size) noexcept override
+    {
+        const size_t cls = (size + granularity - 1) / granularity;
+        if (cls > classes)
+            return ::operator delete(ptr, size);
+        _free[cls - 1] = ::new (ptr) Node{_free[cls - 1]};
+    }
+
+    static FramePool& local() noexcept
+    {
+        thread_local FramePool pool;
+        return pool;
+    }
+
+private:
+    struct Node {
+        Node* next;
+    };
+    Node* _free[classes] = {};
+};
+
+inline FrameAllocator*& FrameAllocator::current() noexcept
+{
+    thread_local FrameAllocator* allocator = &FramePool::local();
+    return allocator;
+}
+
+// Installs allocator for coroutine frames of this thread until end of scope
+struct ScopedFrameAllocator {
+public:
+    explicit ScopedFrameAllocator(FrameAllocator& allocator) noexcept : _previous(FrameAllocator::current())
+    {
+        FrameAllocator::current() = &allocator;
+    }
+
+    ScopedFrameAllocator(const ScopedFrameAllocator&) = delete;
+    ScopedFrameAllocator& operator=(const ScopedFrameAllocator&) = delete;
+
+    ~ScopedFrameAllocator() { FrameAllocator::current() = _previous; }
+
+private:
+    FrameAllocator* _previous;
+};
+
+namespace detail
+{
+template <typename Exp>
+struct ExpectedPromise;
+
+// Object returned from the coroutine call. When it is converted to Expected is up to the compiler (CWG2563):
+// after the coroutine has finished (GCC), the result is kept here, out of the frame which is already gone by then;
+// right after get_return_object() (eager conversion), the returned Expected is left unset and the coroutine
+// constructs it in place.
+template <typename Exp>
+struct ExpectedReturn {
+    explicit ExpectedReturn(ExpectedPromise<Exp>& promise) noexcept : _promise(&promise) { promise._return = this; }
+
+    ExpectedReturn(ExpectedReturn&& other) noexcept(std::is_nothrow_move_constructible<Exp>::value)
+        : _promise(other._promise), _done(other._done)
+    {
+        if (_done)
+            ::new (static_cast<void*>(std::addressof(_result))) Exp(std::move(other._result));
+        if (_promise != nullptr)
+            _promise->_return = this;
+        other._promise = nullptr;
+    }
+
+    ExpectedReturn& operator=(const ExpectedReturn&) = delete;
+
+    ~ExpectedReturn()
+    {
+        if (_done)
+            _result.~Exp();
+        if (_promise != nullptr)
+            _promise->_return = nullptr;
+    }
+
+    operator Exp() &&
+    {
+        if (_done)
+            return std::move(_result);
+        if (_promise == nullptr) {
+            fprintf(stderr, "%s\n", "Expected coroutine result was taken twice");
+            std::terminate();
+        }
+        // Body has not run yet, returned object is constructed in the caller and filled by the coroutine
+        ExpectedPromise<Exp>* promise = _promise;
+        promise->_return = nullptr;
+        _promise = nullptr;
+        return Exp(unset_tag_t{}, promise->_slot);
+    }
+
+    template <typename... Args>
+    void set(Args&&... args)
+    {
+        ::new (static_cast<void*>(std::addressof(_result))) Exp(std::forward<Args>(args)...);
+        _done = true;
+    }
+
+private:
+    template <typename>
+    friend struct ExpectedPromise;
+
+    ExpectedPromise<Exp>* _promise;
+    union {
+        Exp _result;
+    };
+    bool _done = false;
+};
+
+// co_await on Expected: value is resumed with, error finishes the coroutine without resuming it
+template <typename Src>
+struct ExpectedAwaiter {
+    using source_t = typename std::decay<Src>::type;
+
+    bool await_ready() const noexcept(true) { return _source.is_ok(); }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle)
+    {
+        handle.promise().fail(TryAccess::error(std::forward<Src>(_source)));
+        handle.destroy();
+    }
+
+    auto await_resume() -> typename source_t::ok_t { return TryAccess::value(std::forward<Src>(_source)); }
+
+    Src&& _source;
+};
+
+// Nothing refers to the frame once the coroutine is done and the handle never leaves it, which lets the
+// compiler elide the frame allocation (HALO). When it does not, frame comes from FrameAllocator::current().
+template <typename Exp>
+struct ExpectedPromise {
+    using ok_t = typename Exp::ok_t;
+    using err_t = typename Exp::err_t;
+
+    ExpectedPromise() = default;
+    ExpectedPromise(const ExpectedPromise&) = delete;
+    ExpectedPromise& operator=(const ExpectedPromise&) = delete;
+
+    ~ExpectedPromise()
+    {
+        if (_return != nullptr)
+            _return->_promise = nullptr;
+    }
+
+    static void* operator new(size_t size)
+    {
+        FrameAllocator* allocator = FrameAllocator::current();
+        void* mem = allocator->allocate(size + header);
+        *static_cast<FrameAllocator**>(mem) = allocator;
+        return static_cast<char*>(mem) + header;
+    }
+
+    static void operator delete(void* ptr, size_t size) noexcept
+    {
+        void* mem = static_cast<char*>(ptr) - header;
+        (*static_cast<FrameAllocator**>(mem))->deallocate(mem, size + header);
+    }
+
+    auto get_return_object() noexcept(true) -> ExpectedReturn<Exp> { return ExpectedReturn<Exp>(*this); }
+    std::suspend_never initial_suspend() const noexcept(true) { return {}; }
+    std::suspend_never final_suspend() const noexcept(true) { return {}; }
+
+    // co_return Result::Ok(v), co_return Result::Error(e), co_return other_expected or co_return v
+    template <typename U, typename std::enable_if<std::is_constructible<Exp, U&&>::value, bool>::type = true>
+    void return_value(U&& value)
+    {
+        set(std::forward<U>(value));
+    }
+
+    template <typename U, typename std::enable_if<!std::is_constructible<Exp, U&&>::value &&
+                                                      std::is_constructible<stored_t<ok_t>, U&&>::value,
+                                                  bool>::type = true>
+    void return_value(U&& value)
+    {
+        set(in_place, std::forward<U>(value));
+    }
+
+    template <typename Src, typename std::enable_if<is_expected<typename std::decay<Src>::type>::value,
+                                                    bool>::type = true>
+    auto await_transform(Src&& source) noexcept(true) -> ExpectedAwaiter<Src>
+    {
+        return ExpectedAwaiter<Src>{std::forward<Src>(source)};
+    }
+
+    template <typename Err>
+    void fail(Err&& error)
+    {
+        static_assert(std::is_constructible<stored_t<err_t>, Err&&>::value,
+                      "co_await error can not be converted to error of returned Expected");
+        set(unexpect, std::forward<Err>(error));
+    }
+
+    void unhandled_exception()
+    {
+#if defined(__cpp_exceptions)
+        // Result converted eagerly is destroyed by the caller while the exception propagates, so it needs a payload
+        if (_slot != nullptr) {
+            if constexpr (std::is_default_constructible<stored_t<err_t>>::value)
+                set(unexpect);
+            else if constexpr (std::is_default_constructible<stored_t<ok_t>>::value)
+                set(in_place);
+            else
+                std::terminate();
+        }
+        throw;
+#else
+        std::terminate();
+#endif
+    }
+
+private:
+    template <typename>
+    friend struct ExpectedReturn;
+
+    // Keeps frame aligned as global operator new would
+    static constexpr size_t header = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+    static_assert(header >= sizeof(FrameAllocator*), "frame header can not hold allocator");
+
+    template <typename... Args>
+    void set(Args&&... args)
+    {
+        if (_slot != nullptr) {
+            ::new (static_cast<void*>(_slot)) Exp(std::forward<Args>(args)...);
+            _slot = nullptr;
+        } else {
+            _return->set(std::forward<Args>(args)...);
+        }
+    }
+
+    ExpectedReturn<Exp>* _return = nullptr;
+    Exp* _slot = nullptr;  // unset result converted before the body ran
+};
+}  // namespace detail
+}  // namespace Result
+
+template <typename T, typename E, typename A, typename... Args>
+struct std::coroutine_traits<Result::Expected<T, E, A>, Args...> {
+    using promise_type = Result::detail::ExpectedPromise<Result::Expected<T, E, A>>;
+};
+#endif
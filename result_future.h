@@ -0,0 +1,377 @@
+#pragma once
+#include "result.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if !defined(__cpp_lib_atomic_wait) && defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define RESULT_FUTURE_FUTEX 1
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
+// One shot channel carrying Expected between threads, without exception_ptr, mutex or condition variable:
+//     Result::Promise<Row, DbError> promise;
+//     Result::Future<Row, DbError> future = promise.get_future();
+//     pool.submit([p = std::move(promise)]() mutable { p.set(load_row(id)); });
+//     future.then([](Result::Expected<Row, DbError>&& row) { return std::move(row).transform(render); });
+// Promise and future share one heap block. Waiting thread spins for a while and then sleeps on the state word
+// (atomic::wait with C++20, futex on Linux, yield elsewhere). Continuation runs on the thread which sets the
+// result, or right away in then() when result is already there.
+
+namespace Result
+{
+template <typename T, typename E = SimpleError, typename BadAccess = DefaultBadAccess>
+struct Future;
+
+template <typename T, typename E = SimpleError, typename BadAccess = DefaultBadAccess>
+struct Promise;
+
+namespace detail
+{
+inline void cpu_relax() noexcept(true)
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    _mm_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+    __builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Spinning only helps when the other thread runs on another core at the same time
+inline unsigned future_spin_count() noexcept(true)
+{
+    static const unsigned count = std::thread::hardware_concurrency() > 1 ? 4096 : 0;
+    return count;
+}
+
+template <typename T, typename E, typename A>
+struct Continuation {
+    virtual void run(Expected<T, E, A>&& res) noexcept(true) = 0;
+
+protected:
+    ~Continuation() = default;
+};
+
+// Owned by promise and future (or by upstream state for a continuation), freed by the last one released
+template <typename T, typename E, typename A>
+struct FutureState {
+public:
+    using expected_t = Expected<T, E, A>;
+
+    enum : uint32_t { Empty, Waiting, Continued, Ready };
+
+    FutureState() noexcept(true) {}
+    FutureState(const FutureState&) = delete;
+    FutureState& operator=(const FutureState&) = delete;
+
+    // Promise always leaves a result, even when broken, so it is there to destroy
+    virtual ~FutureState() { _result.~expected_t(); }
+
+    template <typename... Args>
+    void set(Args&&... args) noexcept(true)
+    {
+        ::new (static_cast<void*>(&_result)) expected_t(std::forward<Args>(args)...);
+        const uint32_t prev = _state.exchange(Ready, std::memory_order_acq_rel);
+        if (prev == Waiting)
+            wake();
+        else if (prev == Continued)
+            _next->run(std::move(_result));
+    }
+
+    bool ready() const noexcept(true) { return _state.load(std::memory_order_acquire) == Ready; }
+
+    void wait() noexcept(true)
+    {
+        for (unsigned spin = future_spin_count(); spin > 0; --spin) {
+            if (ready())
+                return;
+            cpu_relax();
+        }
+        uint32_t state = Empty;
+        if (!_state.compare_exchange_strong(state, Waiting, std::memory_order_acquire) && state == Ready)
+            return;
+        while (_state.load(std::memory_order_acquire) == Waiting)
+            sleep();
+    }
+
+    // Runs next now when result is already there, otherwise leaves it for set()
+    void attach(Continuation<T, E, A>& next) noexcept(true)
+    {
+        _next = &next;
+        uint32_t state = Empty;
+        if (!_state.compare_exchange_strong(state, Continued, std::memory_order_acq_rel))
+            next.run(std::move(_result));
+    }
+
+    expected_t& result() noexcept(true) { return _result; }
+
+    void release() noexcept(true)
+    {
+        if (_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    // Future is given out once
+    bool retrieve() noexcept(true) { return !_retrieved.exchange(true, std::memory_order_relaxed); }
+
+private:
+    void sleep() noexcept(true)
+    {
+#if defined(__cpp_lib_atomic_wait)
+        _state.wait(Waiting, std::memory_order_acquire);
+#elif defined(RESULT_FUTURE_FUTEX)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_state), FUTEX_WAIT_PRIVATE, Waiting, nullptr, nullptr, 0);
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    void wake() noexcept(true)
+    {
+#if defined(__cpp_lib_atomic_wait)
+        _state.notify_all();
+#elif defined(RESULT_FUTURE_FUTEX)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_state), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    std::atomic<uint32_t> _state{Empty};
+    std::atomic<uint32_t> _refs{2};
+    std::atomic<bool> _retrieved{false};
+    Continuation<T, E, A>* _next = nullptr;
+    union {
+        expected_t _result;
+    };
+};
+
+// Result state of then(), it is the continuation of upstream state at the same time, so a continuation
+// costs one allocation
+template <typename F, typename From, typename To>
+struct ContinuationState;
+
+template <typename F, typename T, typename E, typename A, typename U, typename E2, typename A2>
+struct ContinuationState<F, Expected<T, E, A>, Expected<U, E2, A2>> final : FutureState<U, E2, A2>,
+                                                                             Continuation<T, E, A> {
+public:
+    template <typename Func>
+    explicit ContinuationState(Func&& func) : _func(std::forward<Func>(func))
+    {
+    }
+
+    void run(Expected<T, E, A>&& res) noexcept(true) override
+    {
+        this->set(_func(std::move(res)));
+        this->release();
+    }
+
+private:
+    F _func;
+};
+}  // namespace detail
+
+template <typename T, typename E, typename BadAccess>
+struct Future {
+public:
+    using ok_t = T;
+    using err_t = E;
+    using access_t = BadAccess;
+    using expected_t = Expected<T, E, BadAccess>;
+
+    Future() noexcept(true) : _state(nullptr) {}
+
+    Future(Future&& other) noexcept(true) : _state(other._state) { other._state = nullptr; }
+
+    Future& operator=(Future&& other) noexcept(true)
+    {
+        if (this != &other) {
+            if (_state)
+                _state->release();
+            _state = other._state;
+            other._state = nullptr;
+        }
+        return *this;
+    }
+
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    ~Future()
+    {
+        if (_state)
+            _state->release();
+    }
+
+    // False for default constructed future and after get() or then()
+    bool valid() const noexcept(true) { return _state != nullptr; }
+
+    // Invalid future is never ready and there is nothing to wait for
+    bool ready() const noexcept(true) { return _state != nullptr && _state->ready(); }
+
+    void wait() const noexcept(true)
+    {
+        if (_state)
+            _state->wait();
+    }
+
+    // Waits and moves result out, future is not valid afterwards. Invalid future is a bad access, when BadAccess
+    // policy goes on the result is default constructed error.
+    expected_t get() noexcept(noexcept(expected_t::handle_error()) &&
+                              std::is_nothrow_move_constructible<expected_t>::value)
+    {
+        if (!_state) {
+            expected_t::handle_error("Attempting to get invalid Future", RESULT_RETURN_ADDRESS());
+            return invalid_result();
+        }
+        _state->wait();
+        detail::FutureState<T, E, BadAccess>* state = _state;
+        _state = nullptr;
+        expected_t res(std::move(state->result()));
+        state->release();
+        return res;
+    }
+
+    // f takes expected_t&& and returns another Expected, future is not valid afterwards. Invalid future is
+    // a bad access, when BadAccess policy goes on f is dropped and returned future is invalid too.
+    template <typename F, typename Ret = detail::invoke_result_t<F, expected_t&&>>
+    auto then(F&& f) -> Future<typename Ret::ok_t, typename Ret::err_t, typename Ret::access_t>
+    {
+        static_assert(detail::is_expected<Ret>::value, "then() function has to return Expected");
+        using next_t = detail::ContinuationState<typename std::decay<F>::type, expected_t, Ret>;
+        if (!_state) {
+            expected_t::handle_error("Attempting to continue invalid Future", RESULT_RETURN_ADDRESS());
+            return Future<typename Ret::ok_t, typename Ret::err_t, typename Ret::access_t>();
+        }
+        next_t* next = new next_t(std::forward<F>(f));
+        detail::FutureState<T, E, BadAccess>* state = _state;
+        _state = nullptr;
+        state->attach(*next);
+        state->release();
+        return Future<typename Ret::ok_t, typename Ret::err_t, typename Ret::access_t>(next);
+    }
+
+private:
+    template <typename, typename, typename>
+    friend struct Future;
+    template <typename, typename, typename>
+    friend struct Promise;
+
+    explicit Future(detail::FutureState<T, E, BadAccess>* state) noexcept(true) : _state(state) {}
+
+    template <typename Err = E, typename std::enable_if<std::is_default_constructible<Err>::value, bool>::type = true>
+    static expected_t invalid_result() noexcept(std::is_nothrow_default_constructible<Err>::value)
+    {
+        return expected_t(unexpect);
+    }
+
+    template <typename Err = E, typename std::enable_if<!std::is_default_constructible<Err>::value, bool>::type = true>
+    static expected_t invalid_result() noexcept(true)
+    {
+        std::abort();
+    }
+
+    detail::FutureState<T, E, BadAccess>* _state;
+};
+
+// Promise destroyed without a result makes the future ready with default constructed error, without default
+// constructible error it aborts
+template <typename T, typename E, typename BadAccess>
+struct Promise {
+public:
+    using expected_t = Expected<T, E, BadAccess>;
+
+    Promise() : _state(new detail::FutureState<T, E, BadAccess>()) {}
+
+    Promise(Promise&& other) noexcept(true) : _state(other._state) { other._state = nullptr; }
+
+    Promise& operator=(Promise&& other) noexcept(true)
+    {
+        if (this != &other) {
+            abandon();
+            _state = other._state;
+            other._state = nullptr;
+        }
+        return *this;
+    }
+
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+
+    ~Promise() { abandon(); }
+
+    // Second call returns invalid future
+    Future<T, E, BadAccess> get_future() noexcept(true)
+    {
+        if (!_state || !_state->retrieve())
+            return Future<T, E, BadAccess>();
+        return Future<T, E, BadAccess>(_state);
+    }
+
+    // False once a result was set or the promise was moved from
+    bool valid() const noexcept(true) { return _state != nullptr; }
+
+    // Promise is used up by any of the setters, setter of used up promise drops the result and returns false
+    bool set(expected_t res) noexcept(true) { return finish(std::move(res)); }
+
+    template <typename... Args>
+    bool set_value(Args&&... args) noexcept(true)
+    {
+        return finish(in_place, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    bool set_error(Args&&... args) noexcept(true)
+    {
+        return finish(unexpect, std::forward<Args>(args)...);
+    }
+
+private:
+    template <typename... Args>
+    bool finish(Args&&... args) noexcept(true)
+    {
+        detail::FutureState<T, E, BadAccess>* state = _state;
+        if (state == nullptr)
+            return false;
+        _state = nullptr;
+        if (state->retrieve())
+            state->release();  // nobody took the future
+        state->set(std::forward<Args>(args)...);
+        state->release();
+        return true;
+    }
+
+    template <typename Err = E, typename std::enable_if<std::is_default_constructible<Err>::value, bool>::type = true>
+    void abandon() noexcept(true)
+    {
+        if (_state)
+            finish(unexpect, Err());
+    }
+
+    template <typename Err = E, typename std::enable_if<!std::is_default_constructible<Err>::value, bool>::type = true>
+    void abandon() noexcept(true)
+    {
+        if (_state)
+            std::abort();
+    }
+
+    detail::FutureState<T, E, BadAccess>* _state;
+};
+}  // namespace Result
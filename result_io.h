@@ -0,0 +1,290 @@
+#pragma once
+#include "result.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#if defined(__has_include)
+#if __has_include(<string_view>) && __cplusplus >= 201703L
+#include <string_view>
+#endif
+#endif
+
+#if defined(__cpp_lib_string_view) && (defined(__unix__) || defined(__APPLE__))
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RESULT_HAS_IO 1
+#endif
+
+// Lines of a file as views, without a string per line:
+//     auto reader = Result::io::LineReader::open("access.log");
+//     if (!reader)
+//         return fail(errno);
+//     Result::io::LineReader lines = reader.move_ok();
+//     auto line = lines.next();
+//     for (; line; line = lines.next())
+//         ingest(line.value());  // std::string_view without '\n'
+//     if (line.error() != Result::io::IoError::Eof)
+//         report(line.error(), lines.last_errno());
+// Regular files are mapped and read with sequential hint, line points into the mapping. Pipes, terminals and files
+// which can not be mapped are read in big blocks into a buffer, line is valid until the next call of next() then.
+// Line longer than max_line is skipped and reported as IoError::LineTooLong, reading goes on with the next one.
+
+#if defined(RESULT_HAS_IO)
+namespace Result
+{
+namespace io
+{
+enum class IoError {
+    Eof,          // no more lines
+    Failure,      // open, read or map failed, see errno / LineReader::last_errno()
+    LineTooLong,  // line longer than Options::max_line was skipped
+};
+
+struct LineReader {
+public:
+    struct Options {
+        size_t max_line = size_t(1) << 20;    // longest accepted line without '\n'
+        size_t block_size = size_t(1) << 20;  // read() size for pipes, buffer is at least max_line + 1
+        bool map_files = true;                // false reads regular files into the buffer too
+    };
+
+    // Opens and reads path, errno tells why it failed
+    static Expected<LineReader, IoError> open(const char* path) { return open(path, Options()); }
+
+    static Expected<LineReader, IoError> open(const char* path, Options opts)
+    {
+        int fd;
+        do {
+            fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        } while (fd < 0 && errno == EINTR);
+        if (fd < 0)
+            return Error(IoError::Failure);
+        LineReader reader(fd, true, opts);
+        if (!reader.start()) {
+            ::close(fd);
+            reader._fd = -1;
+            errno = reader._errno;
+            return Error(IoError::Failure);
+        }
+        return Ok(std::move(reader));
+    }
+
+    // Reads fd (stdin, a pipe or a socket), which stays open
+    static Expected<LineReader, IoError> from_fd(int fd) { return from_fd(fd, Options()); }
+
+    static Expected<LineReader, IoError> from_fd(int fd, Options opts)
+    {
+        LineReader reader(fd, false, opts);
+        if (!reader.start())
+            return Error(IoError::Failure);
+        return Ok(std::move(reader));
+    }
+
+    LineReader(LineReader&& other) noexcept(true)
+        : _fd(other._fd), _owns_fd(other._owns_fd), _opts(other._opts), _mapped(other._mapped), _map(other._map),
+          _map_size(other._map_size), _buf(std::move(other._buf)), _cap(other._cap), _begin(other._begin),
+          _end(other._end), _scanned(other._scanned), _skipping(other._skipping), _eof(other._eof),
+          _errno(other._errno)
+    {
+        other._fd = -1;
+        other._mapped = false;
+        other._map = nullptr;
+        other._map_size = 0;
+        other._cap = other._begin = other._end = other._scanned = 0;
+    }
+
+    LineReader& operator=(LineReader&& other) noexcept(true)
+    {
+        LineReader tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    ~LineReader()
+    {
+        if (_map != nullptr)
+            ::munmap(_map, _map_size);
+        if (_owns_fd && _fd >= 0)
+            ::close(_fd);
+    }
+
+    // Next line without '\n'. Line of a mapped file lives as long as the reader, line read into the buffer until
+    // the next call.
+    Expected<std::string_view, IoError> next()
+    {
+        return _mapped ? next_mapped() : next_buffered();
+    }
+
+    // Regular file read through the mapping
+    bool mapped() const noexcept(true) { return _mapped; }
+
+    // errno of the last IoError::Failure
+    int last_errno() const noexcept(true) { return _errno; }
+
+private:
+    LineReader(int fd, bool owns_fd, Options opts) noexcept(true)
+        : _fd(fd), _owns_fd(owns_fd), _opts(opts), _mapped(false), _map(nullptr), _map_size(0), _cap(0), _begin(0),
+          _end(0), _scanned(0), _skipping(false), _eof(false), _errno(0)
+    {
+    }
+
+    void swap(LineReader& other) noexcept(true)
+    {
+        std::swap(_fd, other._fd);
+        std::swap(_owns_fd, other._owns_fd);
+        std::swap(_opts, other._opts);
+        std::swap(_mapped, other._mapped);
+        std::swap(_map, other._map);
+        std::swap(_map_size, other._map_size);
+        std::swap(_buf, other._buf);
+        std::swap(_cap, other._cap);
+        std::swap(_begin, other._begin);
+        std::swap(_end, other._end);
+        std::swap(_scanned, other._scanned);
+        std::swap(_skipping, other._skipping);
+        std::swap(_eof, other._eof);
+        std::swap(_errno, other._errno);
+    }
+
+    bool start()
+    {
+        struct stat info;
+        if (::fstat(_fd, &info) != 0) {
+            _errno = errno;
+            return false;
+        }
+        // Files in /proc and friends report size 0, they are read like pipes
+        if (_opts.map_files && S_ISREG(info.st_mode) && info.st_size > 0) {
+            const size_t size = static_cast<size_t>(info.st_size);
+            void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, _fd, 0);
+            if (map != MAP_FAILED) {
+#if defined(MADV_SEQUENTIAL)
+                ::madvise(map, size, MADV_SEQUENTIAL);
+#endif
+                _mapped = true;
+                _map = static_cast<char*>(map);
+                _map_size = size;
+                _end = size;
+                return true;
+            }
+        }
+        _cap = std::max(_opts.block_size, _opts.max_line + 1);
+        _buf.reset(new char[_cap]);
+        return true;
+    }
+
+    Expected<std::string_view, IoError> next_mapped() noexcept(true)
+    {
+        if (_begin == _end)
+            return Error(IoError::Eof);
+        const char* line = _map + _begin;
+        const size_t left = _end - _begin;
+        // Newline is looked for only within the limit, long line is skipped with a second search
+        const auto* eol = static_cast<const char*>(std::memchr(line, '\n', std::min(left, _opts.max_line + 1)));
+        if (eol == nullptr && left > _opts.max_line) {
+            eol = static_cast<const char*>(std::memchr(line, '\n', left));
+            _begin = eol != nullptr ? static_cast<size_t>(eol - _map) + 1 : _end;
+            return Error(IoError::LineTooLong);
+        }
+        const size_t len = eol != nullptr ? static_cast<size_t>(eol - line) : left;
+        _begin += eol != nullptr ? len + 1 : len;
+        return Ok(std::string_view(line, len));
+    }
+
+    Expected<std::string_view, IoError> next_buffered()
+    {
+        // Moved from reader has neither mapping nor buffer
+        if (!_buf) {
+            _errno = EBADF;
+            return Error(IoError::Failure);
+        }
+        while (true) {
+            const char* data = _buf.get();
+            const auto* eol = static_cast<const char*>(std::memchr(data + _scanned, '\n', _end - _scanned));
+            if (eol != nullptr) {
+                const size_t pos = static_cast<size_t>(eol - data);
+                const size_t begin = _begin;
+                _begin = _scanned = pos + 1;
+                if (_skipping || pos - begin > _opts.max_line) {
+                    _skipping = false;
+                    return Error(IoError::LineTooLong);
+                }
+                return Ok(std::string_view(data + begin, pos - begin));
+            }
+            if (_skipping || _end - _begin > _opts.max_line) {
+                _skipping = true;
+                _begin = _scanned = _end;
+            } else {
+                _scanned = _end;
+            }
+            if (_eof) {
+                if (_skipping) {
+                    _skipping = false;
+                    return Error(IoError::LineTooLong);
+                }
+                if (_begin == _end)
+                    return Error(IoError::Eof);
+                // Last line without '\n'
+                const size_t begin = _begin;
+                _begin = _end;
+                return Ok(std::string_view(data + begin, _end - begin));
+            }
+            if (!fill())
+                return Error(IoError::Failure);
+        }
+    }
+
+    // Appends one block, unread part of a line is moved to the front when less than a block is free
+    bool fill()
+    {
+        if (_begin == _end) {
+            _begin = _end = _scanned = 0;
+        } else if (_begin > 0 && _cap - _end < _opts.block_size) {
+            std::memmove(_buf.get(), _buf.get() + _begin, _end - _begin);
+            _end -= _begin;
+            _scanned -= _begin;
+            _begin = 0;
+        }
+        const size_t want = std::min(_opts.block_size, _cap - _end);
+        ssize_t got;
+        do {
+            got = ::read(_fd, _buf.get() + _end, want);
+        } while (got < 0 && errno == EINTR);
+        if (got < 0) {
+            _errno = errno;
+            return false;
+        }
+        if (got == 0)
+            _eof = true;
+        _end += static_cast<size_t>(got);
+        return true;
+    }
+
+    int _fd;
+    bool _owns_fd;
+    Options _opts;
+    bool _mapped;  // lines come from _map, which is otherwise only kept for munmap
+    char* _map;
+    size_t _map_size;
+    std::unique_ptr<char[]> _buf;
+    size_t _cap;
+    size_t _begin;    // first byte of next line
+    size_t _end;      // end of mapped or buffered bytes
+    size_t _scanned;  // bytes before it have no '\n' (buffered)
+    bool _skipping;  // rest of a long line is dropped (buffered)
+    bool _eof;
+    int _errno;
+};
+}  // namespace io
+}  // namespace Result
+#endif
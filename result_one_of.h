@@ -0,0 +1,529 @@
+#pragma once
+#include "result.h"
+
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Expected with several error types (C++17), for operations spanning more than one layer:
+//     Result::Expected<Row, Result::OneOf<DbError, NetError>> fetch(int id)
+//     {
+//         RESULT_TRY_ASSIGN(auto conn, connect());  // Expected<Connection, NetError>
+//         if (id < 0)
+//             return Result::Error(DbError::Constraint);
+//         return query(conn, id);
+//     }
+//     fetch(id).visit([](const Row& row) { use(row); }, [](DbError err) { log(err); }, [](NetError) { retry(); });
+// Value and all errors share one union next to a single byte telling which of them is alive, so there is no
+// second discriminant of a nested error variant. visit() calls the handler of alive member through a table
+// indexed by that byte.
+
+namespace Result
+{
+template <typename... Errors>
+struct OneOf;
+
+namespace detail
+{
+template <typename... Errors>
+struct is_widening_error<OneOf<Errors...>> : std::true_type {
+};
+
+constexpr size_t no_index = static_cast<size_t>(-1);
+
+// Position of E in Ts, no_index if it is not there
+template <typename E, typename... Ts>
+struct index_of : std::integral_constant<size_t, no_index> {
+};
+
+template <typename E, typename Head, typename... Tail>
+struct index_of<E, Head, Tail...>
+    : std::integral_constant<size_t, std::is_same<E, Head>::value               ? 0
+                                     : index_of<E, Tail...>::value == no_index ? no_index
+                                                                               : 1 + index_of<E, Tail...>::value> {
+};
+
+template <size_t I, typename... Ts>
+using nth_t = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+constexpr size_t max_of(std::initializer_list<size_t> sizes) noexcept(true)
+{
+    size_t max = 0;
+    for (size_t size : sizes)
+        max = size > max ? size : max;
+    return max;
+}
+
+// Bytes of the alive member of Ts and its index. Members are constructed through construct<I>(), destroyed
+// only by IndexedUnion. Index past Ts means no member is alive, after a move constructor threw in assignment.
+template <typename... Ts>
+struct IndexedBase {
+    static_assert(sizeof...(Ts) < 255, "index of alive member has to fit in one byte");
+
+    static constexpr unsigned char valueless = 255;
+
+    template <size_t I, typename... Args>
+    explicit IndexedBase(std::in_place_index_t<I>, Args&&... args) noexcept(
+        std::is_nothrow_constructible<nth_t<I, Ts...>, Args...>::value)
+    {
+        construct<I>(std::forward<Args>(args)...);
+    }
+
+    size_t index() const noexcept(true) { return _index; }
+
+    template <size_t I>
+    nth_t<I, Ts...>& get() & noexcept(true)
+    {
+        return *std::launder(reinterpret_cast<nth_t<I, Ts...>*>(_bytes));
+    }
+
+    template <size_t I>
+    const nth_t<I, Ts...>& get() const& noexcept(true)
+    {
+        return *std::launder(reinterpret_cast<const nth_t<I, Ts...>*>(_bytes));
+    }
+
+    template <size_t I>
+    nth_t<I, Ts...>&& get() && noexcept(true)
+    {
+        return std::move(get<I>());
+    }
+
+    template <size_t I, typename... Args>
+    void construct(Args&&... args) noexcept(std::is_nothrow_constructible<nth_t<I, Ts...>, Args...>::value)
+    {
+        ::new (static_cast<void*>(_bytes)) nth_t<I, Ts...>(std::forward<Args>(args)...);
+        _index = static_cast<unsigned char>(I);
+    }
+
+protected:
+    IndexedBase() noexcept(true) : _index(valueless) {}
+
+    // Leaves no member alive until the next construct()
+    void destroy() noexcept(true)
+    {
+        destroy(std::index_sequence_for<Ts...>{});
+        _index = valueless;
+    }
+
+    // Builds the member alive in other, other is moved from when it is an rvalue
+    template <typename Other>
+    void construct_from(Other&& other)
+    {
+        construct_from(std::forward<Other>(other), std::index_sequence_for<Ts...>{});
+    }
+
+private:
+    template <size_t... Is>
+    void destroy(std::index_sequence<Is...>) noexcept(true)
+    {
+        static_cast<void>(((_index == Is ? (detail::destroy_at(get<Is>()), true) : false) || ...));
+    }
+
+    template <typename Other, size_t... Is>
+    void construct_from(Other&& other, std::index_sequence<Is...>)
+    {
+        static_cast<void>(
+            ((other._index == Is ? (construct<Is>(std::forward<Other>(other).template get<Is>()), true) : false) ||
+             ...));
+    }
+
+    alignas(Ts...) unsigned char _bytes[max_of({sizeof(Ts)...})];
+    unsigned char _index;
+};
+
+// Trivially copyable members make the whole union trivially copyable, so it is passed in registers
+template <bool Trivial, typename... Ts>
+struct IndexedUnion : IndexedBase<Ts...> {
+    using IndexedBase<Ts...>::IndexedBase;
+
+    static constexpr bool never_valueless = true;
+};
+
+template <typename... Ts>
+struct IndexedUnion<false, Ts...> : IndexedBase<Ts...> {
+    using IndexedBase<Ts...>::IndexedBase;
+
+    // Assignment loses the old member only when a move constructor throws
+    static constexpr bool never_valueless = std::conjunction<std::is_nothrow_move_constructible<Ts>...>::value;
+
+    IndexedUnion(const IndexedUnion& other) : IndexedBase<Ts...>() { this->construct_from(other); }
+
+    IndexedUnion(IndexedUnion&& other) noexcept(
+        std::conjunction<std::is_nothrow_move_constructible<Ts>...>::value)
+        : IndexedBase<Ts...>()
+    {
+        this->construct_from(std::move(other));
+    }
+
+    // Copy is made aside first, so this is unchanged if the copy throws
+    IndexedUnion& operator=(const IndexedUnion& other)
+    {
+        if (this != &other) {
+            IndexedUnion copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    // Throwing move constructor leaves this valueless
+    IndexedUnion& operator=(IndexedUnion&& other) noexcept(never_valueless)
+    {
+        if (this != &other) {
+            this->destroy();
+            this->construct_from(std::move(other));
+        }
+        return *this;
+    }
+
+    ~IndexedUnion() { this->destroy(); }
+};
+
+template <typename... Ts>
+using indexed_union_t = IndexedUnion<std::conjunction<std::is_trivially_copyable<Ts>...>::value, Ts...>;
+
+// Handler in fns of member I: one handler past Reserved ones takes all remaining members
+template <size_t I, size_t Handlers, size_t Reserved>
+constexpr size_t handler_of() noexcept(true)
+{
+    return Handlers == Reserved + 1 && I >= Reserved ? Reserved : I;
+}
+
+template <size_t I, size_t Reserved, typename Union, typename Fns>
+using handler_result_t =
+    decltype(std::get<handler_of<I, std::tuple_size<Fns>::value, Reserved>()>(std::declval<Fns&>())(
+        std::declval<Union>().template get<I>()));
+
+template <size_t I, size_t Reserved, typename R, typename Union, typename Fns>
+R call_handler(Union&& data, Fns& fns)
+{
+    return std::get<handler_of<I, std::tuple_size<Fns>::value, Reserved>()>(fns)(
+        std::forward<Union>(data).template get<I>());
+}
+
+// Calls handler of alive member through a table of one function per member
+template <size_t Reserved, typename Union, typename Fns, size_t... Is>
+auto visit_indexed(Union&& data, Fns& fns, std::index_sequence<Is...>)
+    -> std::common_type_t<handler_result_t<Is, Reserved, Union, Fns>...>
+{
+    using R = std::common_type_t<handler_result_t<Is, Reserved, Union, Fns>...>;
+    static_assert(std::tuple_size<Fns>::value == Reserved + 1 || std::tuple_size<Fns>::value == sizeof...(Is),
+                  "visit() takes one handler for all errors or one handler per error type");
+    static constexpr R (*table[])(Union&&, Fns&) = {&call_handler<Is, Reserved, R, Union, Fns>...};
+    if constexpr (!std::decay_t<Union>::never_valueless) {
+        if (data.index() >= sizeof...(Is))
+            std::terminate();
+    }
+    return table[data.index()](std::forward<Union>(data), fns);
+}
+}  // namespace detail
+
+// One of Errors with one byte index, error type of Expected<T, OneOf<Errors...>>. Error of any listed type
+// converts to it implicitly.
+template <typename... Errors>
+struct OneOf {
+public:
+    static_assert(sizeof...(Errors) > 0, "OneOf needs at least one error type");
+
+    template <typename E>
+    struct holds : std::integral_constant<bool, detail::index_of<E, Errors...>::value != detail::no_index> {
+    };
+
+    // First error type, default constructed
+    template <typename First = detail::nth_t<0, Errors...>,
+              typename std::enable_if<std::is_default_constructible<First>::value, bool>::type = true>
+    OneOf() noexcept(std::is_nothrow_default_constructible<First>::value) : _data(std::in_place_index<0>)
+    {
+    }
+
+    template <typename E, typename Err = typename std::decay<E>::type,
+              typename std::enable_if<holds<Err>::value, bool>::type = true>
+    OneOf(E&& err) noexcept(std::is_nothrow_constructible<Err, E&&>::value)
+        : _data(std::in_place_index<detail::index_of<Err, Errors...>::value>, std::forward<E>(err))
+    {
+    }
+
+    // Position of alive error type in Errors
+    size_t index() const noexcept(true) { return _data.index(); }
+
+    template <typename E, typename std::enable_if<holds<E>::value, bool>::type = true>
+    bool is() const noexcept(true)
+    {
+        return _data.index() == detail::index_of<E, Errors...>::value;
+    }
+
+    template <typename E, typename std::enable_if<holds<E>::value, bool>::type = true>
+    const E* get_if() const noexcept(true)
+    {
+        return is<E>() ? &_data.template get<detail::index_of<E, Errors...>::value>() : nullptr;
+    }
+
+    // fns are one handler per error type, in order of Errors, or one handler taking all of them
+    template <typename... Fns>
+    decltype(auto) visit(Fns&&... fns) const&
+    {
+        std::tuple<Fns&...> handlers(fns...);
+        return detail::visit_indexed<0>(_data, handlers, std::index_sequence_for<Errors...>{});
+    }
+
+    template <typename... Fns>
+    decltype(auto) visit(Fns&&... fns) &&
+    {
+        std::tuple<Fns&...> handlers(fns...);
+        return detail::visit_indexed<0>(std::move(_data), handlers, std::index_sequence_for<Errors...>{});
+    }
+
+    bool operator==(const OneOf& other) const
+    {
+        return index() == other.index() && other.visit([this](const auto& err) {
+            using E = typename std::decay<decltype(err)>::type;
+            return *get_if<E>() == err;
+        });
+    }
+
+    bool operator!=(const OneOf& other) const { return !(*this == other); }
+
+    template <typename E, typename std::enable_if<holds<E>::value, bool>::type = true>
+    bool operator==(const E& err) const
+    {
+        const E* own = get_if<E>();
+        return own && *own == err;
+    }
+
+    template <typename E, typename std::enable_if<holds<E>::value, bool>::type = true>
+    bool operator!=(const E& err) const
+    {
+        return !(*this == err);
+    }
+
+private:
+    template <typename, typename, typename>
+    friend struct Expected;
+
+    detail::indexed_union_t<Errors...> _data;
+};
+
+// Value at index 0 and errors after it share one IndexedUnion
+template <typename Value, typename... Errors, typename BadAccess>
+struct Expected<Value, OneOf<Errors...>, BadAccess> {
+public:
+    using ok_t = Value;
+    using err_t = OneOf<Errors...>;
+    using access_t = BadAccess;
+    static_assert(std::is_object<ok_t>::value, "Expected with OneOf errors holds values only");
+
+    template <typename E>
+    using holds = typename err_t::template holds<E>;
+
+    Expected(const Success<ok_t>& success) : _data(std::in_place_index<0>, success.value()) {}
+
+    Expected(Success<ok_t>&& success) : _data(std::in_place_index<0>, success.move()) {}
+
+    Expected(const Failure<err_t>& failure) : _data(copy_error(failure.error())) {}
+
+    Expected(Failure<err_t>&& failure) : _data(copy_error(failure.move())) {}
+
+    // Failure of any of Errors converts through Failure::operator Expected(), which builds the error in place here
+    template <typename... Args, typename std::enable_if<std::is_constructible<ok_t, Args...>::value, bool>::type = true>
+    explicit Expected(in_place_t, Args&&... args) noexcept(std::is_nothrow_constructible<ok_t, Args&&...>::value)
+        : _data(std::in_place_index<0>, std::forward<Args>(args)...)
+    {
+    }
+
+    template <typename E, typename Err = typename std::decay<E>::type,
+              typename std::enable_if<holds<Err>::value, bool>::type = true>
+    explicit Expected(unexpect_t, E&& err) noexcept(std::is_nothrow_constructible<Err, E&&>::value)
+        : _data(std::in_place_index<1 + detail::index_of<Err, Errors...>::value>, std::forward<E>(err))
+    {
+    }
+
+    explicit Expected(unexpect_t, const err_t& err) : _data(copy_error(err)) {}
+
+    explicit Expected(unexpect_t, err_t&& err) : _data(copy_error(std::move(err))) {}
+
+    // address is taken in the accessor, here it would point into the accessor itself
+    static void handle_error(const char* str = "",
+                             const void* address = nullptr RESULT_TELEMETRY_AND_SITE_PARAM) noexcept(
+        detail::recovers_from_bad_access<BadAccess>::value)
+    {
+#if defined(RESULT_TELEMETRY)
+        telemetry::record(telemetry::Event::BadAccess, site, telemetry::type_name<err_t>());
+#endif
+#if defined(USE_EXCEPTIONS)
+        if (std::is_same<BadAccess, BadAccessThrow>::value)
+            throw bad_access(str);
+#endif
+        detail::bad_access_reporter<BadAccess>::template report<err_t>(str, address);
+        if (detail::recovers_from_bad_access<BadAccess>::value)
+            return;
+        std::terminate();
+    }
+
+    bool is_ok() const noexcept(true) { return _data.index() == 0; }
+
+    explicit operator bool() const noexcept(true) { return is_ok(); }
+
+    template <typename E, typename std::enable_if<holds<E>::value, bool>::type = true>
+    bool holds_error() const noexcept(true)
+    {
+        return _data.index() == 1 + detail::index_of<E, Errors...>::value;
+    }
+
+    const ok_t* value_ptr() const noexcept(true) { return is_ok() ? &_data.template get<0>() : nullptr; }
+
+    template <typename E, typename std::enable_if<holds<E>::value, bool>::type = true>
+    const E* error_ptr() const noexcept(true)
+    {
+        return holds_error<E>() ? &_data.template get<1 + detail::index_of<E, Errors...>::value>() : nullptr;
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    auto value(RESULT_TELEMETRY_SITE_PARAM) const& noexcept(noexcept(handle_error())) -> const ok_t&
+    {
+        if (!is_ok()) {
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return detail::default_instance<ok_t>();
+        }
+        return _data.template get<0>();
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    auto value(RESULT_TELEMETRY_SITE_PARAM) const& noexcept(noexcept(handle_error())) -> const ok_t&
+    {
+        if (!is_ok())
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return _data.template get<0>();
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    auto value(RESULT_TELEMETRY_SITE_PARAM) && noexcept(noexcept(handle_error()) &&
+                                                         std::is_nothrow_move_constructible<Ret>::value) -> ok_t
+    {
+        if (!is_ok()) {
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return ok_t{};
+        }
+        return std::move(_data).template get<0>();
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    auto value(RESULT_TELEMETRY_SITE_PARAM) && noexcept(noexcept(handle_error()) &&
+                                                         std::is_nothrow_move_constructible<Ret>::value) -> ok_t
+    {
+        if (!is_ok())
+            handle_error("Attempting to get Expected::value()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return std::move(_data).template get<0>();
+    }
+
+    template <typename U, typename std::enable_if<std::is_constructible<ok_t, U&&>::value, bool>::type = true>
+    auto value_or(U&& ret) const& -> ok_t
+    {
+        return is_ok() ? _data.template get<0>() : static_cast<ok_t>(std::forward<U>(ret));
+    }
+
+    template <typename U, typename std::enable_if<std::is_constructible<ok_t, U&&>::value, bool>::type = true>
+    auto value_or(U&& ret) && -> ok_t
+    {
+        return is_ok() ? std::move(_data).template get<0>() : static_cast<ok_t>(std::forward<U>(ret));
+    }
+
+    // Error is returned by value, as OneOf built from alive error
+    template <typename Ret = err_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    auto error(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(handle_error())) -> err_t
+    {
+        if (is_ok()) {
+            handle_error("Attempting to get Expected::error()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return err_t();
+        }
+        return visit_error(_data, [](const auto& err) { return err_t(err); });
+    }
+
+    template <typename Ret = err_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    auto error(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(handle_error())) -> err_t
+    {
+        if (is_ok())
+            handle_error("Attempting to get Expected::error()", RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return visit_error(_data, [](const auto& err) { return err_t(err); });
+    }
+
+    // ok_fn takes value, err_fns are one handler per error type, in order of Errors, or one handler for all of them.
+    // Value is checked first, as the common case, errors go through the table.
+    template <typename OkFn, typename... ErrFns>
+    decltype(auto) visit(OkFn&& ok_fn, ErrFns&&... err_fns) const&
+    {
+        std::tuple<OkFn&, ErrFns&...> handlers(ok_fn, err_fns...);
+        using R = decltype(detail::visit_indexed<1>(_data, handlers, std::index_sequence_for<Value, Errors...>{}));
+        if (is_ok())
+            return static_cast<R>(ok_fn(_data.template get<0>()));
+        return detail::visit_indexed<1>(_data, handlers, std::index_sequence_for<Value, Errors...>{});
+    }
+
+    template <typename OkFn, typename... ErrFns>
+    decltype(auto) visit(OkFn&& ok_fn, ErrFns&&... err_fns) &&
+    {
+        std::tuple<OkFn&, ErrFns&...> handlers(ok_fn, err_fns...);
+        using R = decltype(detail::visit_indexed<1>(std::move(_data), handlers,
+                                                    std::index_sequence_for<Value, Errors...>{}));
+        if (is_ok())
+            return static_cast<R>(ok_fn(std::move(_data).template get<0>()));
+        return detail::visit_indexed<1>(std::move(_data), handlers, std::index_sequence_for<Value, Errors...>{});
+    }
+
+private:
+    friend struct detail::TryAccess;
+
+    using data_t = detail::indexed_union_t<Value, Errors...>;
+
+    // RESULT_TRY reaches payload through _data.ok() and _data.err()
+    struct Data : data_t {
+        using data_t::data_t;
+
+        Data(data_t&& data) : data_t(std::move(data)) {}
+
+        ok_t& ok() & noexcept(true) { return this->template get<0>(); }
+        const ok_t& ok() const& noexcept(true) { return this->template get<0>(); }
+        ok_t&& ok() && noexcept(true) { return std::move(*this).template get<0>(); }
+
+        err_t err() const& { return Expected::visit_error(*this, [](const auto& err) { return err_t(err); }); }
+        err_t err() &&
+        {
+            return Expected::visit_error(std::move(*this), [](auto&& err) { return err_t(std::move(err)); });
+        }
+    };
+
+    // Calls fn with alive error, data has to hold one
+    template <typename Union, typename F>
+    static err_t visit_error(Union&& data, F&& fn)
+    {
+        auto unreachable = [](const ok_t&) -> err_t { std::terminate(); };
+        std::tuple<decltype(unreachable)&, F&> handlers(unreachable, fn);
+        return detail::visit_indexed<1>(std::forward<Union>(data), handlers,
+                                        std::index_sequence_for<Value, Errors...>{});
+    }
+
+    // Error of OneOf moved to its position after the value
+    template <typename Err>
+    static data_t copy_error(Err&& err)
+    {
+        return std::forward<Err>(err).visit([](auto&& alive) {
+            using E = typename std::decay<decltype(alive)>::type;
+            return data_t(std::in_place_index<1 + detail::index_of<E, Errors...>::value>,
+                          std::forward<decltype(alive)>(alive));
+        });
+    }
+
+    Data _data;
+};
+}  // namespace Result
@@ -0,0 +1,229 @@
+#pragma once
+#include "result.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Result
+{
+// Fixed set of worker threads executing submitted tasks in order. Tasks should not throw.
+struct ThreadPool {
+public:
+    explicit ThreadPool(size_t threads)
+    {
+        _workers.reserve(threads);
+        for (size_t idx = 0; idx < threads; ++idx)
+            _workers.emplace_back([this] { work(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& worker : _workers)
+            worker.join();
+    }
+
+    size_t size() const noexcept(true) { return _workers.size(); }
+
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push_back(std::move(task));
+        }
+        _wake.notify_one();
+    }
+
+    // Pool shared by parallel algorithms, calling thread takes part in the work, so one core is left for it
+    static ThreadPool& shared()
+    {
+        static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 2U) - 1);
+        return pool;
+    }
+
+private:
+    void work()
+    {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this] { return _stop || !_tasks.empty(); });
+                if (_tasks.empty())
+                    return;
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _tasks;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stop = false;
+};
+
+namespace detail
+{
+// State of one par_try_transform() call shared with pool tasks. Chunks are claimed in increasing order and
+// no index above the lowest known failure is evaluated, so every index below the final lowest failure is
+// evaluated and the reported error does not depend on scheduling.
+template <typename InIt, typename OutIt, typename F, typename Res>
+struct ParallelTransform {
+    using err_t = typename Res::err_t;
+    using result_t = Expected<EmptyValue, err_t, typename Res::access_t>;
+
+    ParallelTransform(InIt first, OutIt out, F& f, size_t count, size_t chunk)
+        : _first(first), _out(out), _f(&f), _count(count), _chunk(chunk), _failed_at(count), _result(in_place)
+    {
+    }
+
+    // Exception of f stops all workers and is kept for finish(), without USE_EXCEPTIONS it terminates
+    void run() noexcept(true)
+    {
+#if defined(USE_EXCEPTIONS)
+        try {
+            claim();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+#else
+        claim();
+#endif
+    }
+
+    // Task running on a pool thread, it does nothing once the caller stopped waiting for helpers
+    void help() noexcept(true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_closed)
+                return;
+            ++_active;
+        }
+        run();
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_active == 0)
+            _idle.notify_all();
+    }
+
+    result_t finish()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _closed = true;
+        _idle.wait(lock, [this] { return _active == 0; });
+#if defined(USE_EXCEPTIONS)
+        if (_exception)
+            std::rethrow_exception(_exception);
+#endif
+        return std::move(_result);
+    }
+
+private:
+    void claim()
+    {
+        for (;;) {
+            const size_t begin = _next.fetch_add(_chunk, std::memory_order_relaxed);
+            if (begin >= _count || begin >= _failed_at.load(std::memory_order_acquire))
+                return;
+            const size_t end = std::min(begin + _chunk, _count);
+            for (size_t idx = begin; idx < end && idx < _failed_at.load(std::memory_order_relaxed); ++idx) {
+                Res res = (*_f)(_first[static_cast<typename std::iterator_traits<InIt>::difference_type>(idx)]);
+                if (auto* ok = res.value_ptr())
+                    _out[static_cast<typename std::iterator_traits<OutIt>::difference_type>(idx)] = std::move(*ok);
+                else
+                    fail(idx, std::move(res).error());
+            }
+        }
+    }
+
+    void fail(size_t idx, err_t&& error)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (idx >= _failed_at.load(std::memory_order_relaxed))
+            return;
+        _result.emplace_error(std::move(error));
+        _failed_at.store(idx, std::memory_order_release);
+    }
+
+#if defined(USE_EXCEPTIONS)
+    // First exception wins, no further index is evaluated
+    void fail(std::exception_ptr exception)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_exception)
+            _exception = std::move(exception);
+        _failed_at.store(0, std::memory_order_release);
+    }
+#endif
+
+    InIt _first;
+    OutIt _out;
+    F* _f;
+    const size_t _count;
+    const size_t _chunk;
+    std::atomic<size_t> _next{0};
+    std::atomic<size_t> _failed_at;
+    result_t _result;
+    std::mutex _mutex;
+    std::condition_variable _idle;
+    size_t _active = 0;
+    bool _closed = false;
+#if defined(USE_EXCEPTIONS)
+    std::exception_ptr _exception;
+#endif
+};
+}  // namespace detail
+
+// Parallel version of try_transform(): out[i] = f(first[i]).value() for every element, or the error of the
+// lowest failing index. Once an element fails, workers stop taking chunks past it; outputs at and after the
+// failing index are unspecified. Calling thread works too, threads counts it (0 uses the whole pool).
+// With USE_EXCEPTIONS an exception thrown by f stops the workers and the first one is rethrown here after all of
+// them are done, otherwise f must not throw.
+template <typename InIt, typename OutIt, typename F,
+          typename Res = detail::invoke_result_t<F&, typename std::iterator_traits<InIt>::reference>,
+          typename Ret = Expected<EmptyValue, typename Res::err_t, typename Res::access_t>>
+auto par_try_transform(InIt first, InIt last, OutIt out, F&& f, size_t threads = 0,
+                       ThreadPool& pool = ThreadPool::shared()) -> Ret
+{
+    static_assert(detail::is_expected<Res>::value, "par_try_transform() function has to return Expected");
+    static_assert(std::is_base_of<std::random_access_iterator_tag,
+                                  typename std::iterator_traits<InIt>::iterator_category>::value &&
+                      std::is_base_of<std::random_access_iterator_tag,
+                                      typename std::iterator_traits<OutIt>::iterator_category>::value,
+                  "par_try_transform() requires random access iterators");
+    using State = detail::ParallelTransform<InIt, OutIt, typename std::remove_reference<F>::type, Res>;
+    const size_t count = static_cast<size_t>(std::distance(first, last));
+    if (threads == 0 || threads > pool.size() + 1)
+        threads = pool.size() + 1;
+    // Several chunks per thread keep the load balanced, cancellation is checked per element anyway
+    const size_t chunk = std::max<size_t>(1, count / (threads * 8));
+    auto state = std::make_shared<State>(first, out, f, count, chunk);
+    const size_t helpers = std::min(threads - 1, (count + chunk - 1) / chunk);
+    for (size_t idx = 0; idx < helpers; ++idx)
+        pool.submit([state] { state->help(); });
+    state->run();
+    return state->finish();
+}
+}  // namespace Result
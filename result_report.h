@@ -0,0 +1,252 @@
+#pragma once
+#include "result.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+#include <typeinfo>
+#endif
+
+// Bad accesses of Expected<T, E, Result::BadAccessDeferred> are pushed as fixed size records into a lock-free
+// ring and written out later, so a flood of them never serializes workers on the stderr lock:
+//     Result::BadAccessDrainer drainer(std::chrono::milliseconds(100));  // or call flush_bad_access() yourself
+//     Result::set_bad_access_handler([](const Result::BadAccessRecord& rec) { log(rec.message, rec.type); });
+// Each message from one callsite (keyed by message and return address, see BadAccessRecord::address) is queued at
+// most rate limit times between two flushes, further reports are only counted. Reports which do not fit in the ring
+// are counted as dropped.
+
+namespace Result
+{
+struct BadAccessRecord {
+    static constexpr size_t message_size = 104;
+
+    char message[message_size];  // truncated copy
+    const char* type;            // error type of the Expected, empty without RTTI
+    // Return address taken in the accessor, so it points into its caller. When the accessor is inlined, it points
+    // into the caller of the function it was inlined into. nullptr if unknown.
+    const void* address;
+};
+
+// Totals since start of the program
+struct BadAccessStats {
+    uint64_t queued;
+    uint64_t suppressed;
+    uint64_t dropped;
+};
+
+// Called by flush for every queued record, under the flush lock (so it must not flush itself)
+using BadAccessHandler = std::function<void(const BadAccessRecord&)>;
+
+namespace detail
+{
+template <typename T>
+const char* error_type_name() noexcept(true)
+{
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+    return typeid(T).name();
+#else
+    return "";
+#endif
+}
+
+// Bounded multi producer ring, every cell carries a sequence number telling whether it is free for the producer
+// at given position or filled for the consumer. Consumers are serialized by the flush lock.
+struct BadAccessQueue {
+public:
+    static constexpr size_t capacity = 1024;
+    static constexpr size_t limit_buckets = 64;
+    static constexpr uint32_t default_rate_limit = 16;
+
+    static BadAccessQueue& instance() noexcept(true)
+    {
+        static BadAccessQueue queue;
+        return queue;
+    }
+
+    void push(const char* str, const char* type, const void* address) noexcept(true)
+    {
+        // Message alone would share one limit among all callsites, return address alone among all accessors
+        // inlined into one function
+        const uintptr_t key = (reinterpret_cast<uintptr_t>(str) >> 3U) ^ reinterpret_cast<uintptr_t>(address);
+        Bucket& bucket = _buckets[key % limit_buckets];
+        const uint32_t limit = _rate_limit.load(std::memory_order_relaxed);
+        if (bucket.used.load(std::memory_order_relaxed) >= limit ||
+            bucket.used.fetch_add(1, std::memory_order_relaxed) >= limit) {
+            _suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = _cells[pos % capacity];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (seq < pos) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+        Cell& cell = _cells[pos % capacity];
+        size_t len = 0;
+        for (; len + 1 < BadAccessRecord::message_size && str[len] != '\0'; ++len)
+            cell.record.message[len] = str[len];
+        cell.record.message[len] = '\0';
+        cell.record.type = type;
+        cell.record.address = address;
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        _queued.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Hands queued records to the handler (stderr by default) and starts new rate limit window
+    size_t flush()
+    {
+        std::lock_guard<std::mutex> lock(_flush_mutex);
+        size_t count = 0;
+        for (;; ++_head, ++count) {
+            Cell& cell = _cells[_head % capacity];
+            if (cell.sequence.load(std::memory_order_acquire) != _head + 1)
+                break;
+            if (_handler)
+                _handler(cell.record);
+            else
+                fprintf(stderr, "%s [%s] at %p\n", cell.record.message, cell.record.type, cell.record.address);
+            cell.sequence.store(_head + capacity, std::memory_order_release);
+        }
+        for (Bucket& bucket : _buckets)
+            bucket.used.store(0, std::memory_order_relaxed);
+        const BadAccessStats now = stats();
+        if (!_handler && (now.suppressed != _reported.suppressed || now.dropped != _reported.dropped)) {
+            fprintf(stderr, "%llu bad access reports suppressed, %llu dropped\n",
+                    static_cast<unsigned long long>(now.suppressed - _reported.suppressed),
+                    static_cast<unsigned long long>(now.dropped - _reported.dropped));
+        }
+        _reported = now;
+        return count;
+    }
+
+    void set_handler(BadAccessHandler handler)
+    {
+        std::lock_guard<std::mutex> lock(_flush_mutex);
+        _handler = std::move(handler);
+    }
+
+    void set_rate_limit(uint32_t per_callsite) noexcept(true)
+    {
+        _rate_limit.store(per_callsite, std::memory_order_relaxed);
+    }
+
+    BadAccessStats stats() const noexcept(true)
+    {
+        return BadAccessStats{_queued.load(std::memory_order_relaxed), _suppressed.load(std::memory_order_relaxed),
+                              _dropped.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        BadAccessRecord record;
+    };
+
+    struct alignas(64) Bucket {
+        std::atomic<uint32_t> used{0};
+    };
+
+    BadAccessQueue() noexcept(true)
+    {
+        for (size_t idx = 0; idx < capacity; ++idx)
+            _cells[idx].sequence.store(idx, std::memory_order_relaxed);
+    }
+
+    Cell _cells[capacity];
+    Bucket _buckets[limit_buckets];
+    alignas(64) std::atomic<size_t> _tail{0};
+    alignas(64) std::atomic<uint32_t> _rate_limit{default_rate_limit};
+    std::atomic<uint64_t> _queued{0};
+    std::atomic<uint64_t> _suppressed{0};
+    std::atomic<uint64_t> _dropped{0};
+    std::mutex _flush_mutex;
+    size_t _head = 0;
+    BadAccessHandler _handler;
+    BadAccessStats _reported{0, 0, 0};
+};
+
+template <>
+struct bad_access_reporter<BadAccessDeferred> {
+    template <typename ErrorType>
+    static void report(const char* str, const void* address) noexcept(true)
+    {
+        BadAccessQueue::instance().push(str, error_type_name<ErrorType>(), address);
+    }
+};
+}  // namespace detail
+
+// Writes out queued bad access reports, returns how many were written
+inline size_t flush_bad_access() { return detail::BadAccessQueue::instance().flush(); }
+
+// Replaces writing to stderr, empty handler restores it
+inline void set_bad_access_handler(BadAccessHandler handler)
+{
+    detail::BadAccessQueue::instance().set_handler(std::move(handler));
+}
+
+// Reports of one message from one callsite queued between two flushes
+inline void set_bad_access_rate_limit(uint32_t per_callsite) noexcept(true)
+{
+    detail::BadAccessQueue::instance().set_rate_limit(per_callsite);
+}
+
+inline BadAccessStats bad_access_stats() noexcept(true) { return detail::BadAccessQueue::instance().stats(); }
+
+// Background thread flushing reports every interval, remaining ones are flushed when it is destroyed
+struct BadAccessDrainer {
+public:
+    explicit BadAccessDrainer(std::chrono::milliseconds interval = std::chrono::milliseconds(100))
+        : _interval(interval), _thread([this] { run(); })
+    {
+    }
+
+    BadAccessDrainer(const BadAccessDrainer&) = delete;
+    BadAccessDrainer& operator=(const BadAccessDrainer&) = delete;
+
+    ~BadAccessDrainer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_one();
+        _thread.join();
+        flush_bad_access();
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_wake.wait_for(lock, _interval, [this] { return _stop; })) {
+            lock.unlock();
+            flush_bad_access();
+            lock.lock();
+        }
+    }
+
+    std::chrono::milliseconds _interval;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stop = false;
+    std::thread _thread;
+};
+}  // namespace Result
@@ -0,0 +1,237 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+#include <typeinfo>
+#endif
+
+// Failure telemetry, compiled in only when RESULT_TELEMETRY is defined (for every translation unit which includes
+// result.h). Each Failure construction and each bad access is counted against its callsite and error type in
+// counters of the current thread, which are written without atomic read-modify-write and never shared:
+//     for (const Result::telemetry::Record& rec : Result::telemetry::snapshot())
+//         log(rec.file, rec.line, rec.type, rec.count);
+
+// Constant evaluation is not counted, without a way to detect it Failure can not be used in constant expressions
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define RESULT_TELEMETRY_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(RESULT_TELEMETRY_CONSTANT_EVALUATED) && defined(_MSC_VER) && _MSC_VER >= 1925
+#define RESULT_TELEMETRY_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#if !defined(RESULT_TELEMETRY_CONSTANT_EVALUATED)
+#define RESULT_TELEMETRY_CONSTANT_EVALUATED() false
+#endif
+
+namespace Result
+{
+namespace telemetry
+{
+enum class Event : uint8_t { Failure, BadAccess };
+
+constexpr size_t event_kinds = 2;
+
+struct Callsite {
+    const char* file;
+    unsigned line;
+
+    // Location of the call which uses it as default argument
+    static constexpr Callsite current(const char* file = __builtin_FILE(), unsigned line = __builtin_LINE()) noexcept(
+        true)
+    {
+        return Callsite{file, line};
+    }
+};
+
+// Count of one event at one callsite for one error type, summed over all threads. Events which did not fit in
+// the table of their thread are reported with nullptr file, one record per event.
+struct Record {
+    Event event;
+    const char* file;
+    unsigned line;
+    const char* type;
+    uint64_t count;
+};
+
+template <typename T>
+const char* type_name() noexcept(true)
+{
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+    return typeid(T).name();
+#else
+    return "unknown";
+#endif
+}
+
+namespace detail
+{
+inline bool same_key(const Record& lhs, Event event, const char* file, unsigned line, const char* type) noexcept(true)
+{
+    if (lhs.event != event || lhs.line != line)
+        return false;
+    if (lhs.file != file && (lhs.file == nullptr || file == nullptr || std::strcmp(lhs.file, file) != 0))
+        return false;
+    return lhs.type == type || std::strcmp(lhs.type, type) == 0;
+}
+
+inline void merge(std::vector<Record>& out, Event event, const char* file, unsigned line, const char* type,
+                  uint64_t count)
+{
+    for (Record& rec : out) {
+        if (same_key(rec, event, file, line, type)) {
+            rec.count += count;
+            return;
+        }
+    }
+    out.push_back(Record{event, file, line, type, count});
+}
+
+// Open addressing table owned by one thread. Owner fills a slot before publishing it and then only bumps its
+// count, snapshot() reads published slots from other threads.
+struct ThreadCounters {
+    static constexpr size_t capacity = 256;
+
+    struct Slot {
+        std::atomic<bool> used{false};
+        Event event = Event::Failure;
+        const char* file = nullptr;
+        unsigned line = 0;
+        const char* type = nullptr;
+        std::atomic<uint64_t> count{0};
+    };
+
+    void add(Event event, Callsite site, const char* type) noexcept(true)
+    {
+        size_t idx = (reinterpret_cast<uintptr_t>(site.file) >> 3U) ^ (site.line * 0x9E3779B1U) ^
+                     (reinterpret_cast<uintptr_t>(type) >> 4U) ^ static_cast<size_t>(event);
+        for (size_t probe = 0; probe < capacity; ++probe, ++idx) {
+            Slot& slot = slots[idx % capacity];
+            if (!slot.used.load(std::memory_order_relaxed)) {
+                slot.event = event;
+                slot.file = site.file;
+                slot.line = site.line;
+                slot.type = type;
+                slot.count.store(1, std::memory_order_relaxed);
+                slot.used.store(true, std::memory_order_release);
+                return;
+            }
+            if (slot.file == site.file && slot.line == site.line && slot.type == type && slot.event == event) {
+                slot.count.store(slot.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        std::atomic<uint64_t>& dropped = overflow[static_cast<size_t>(event)];
+        dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void collect(std::vector<Record>& out) const
+    {
+        for (const Slot& slot : slots) {
+            if (slot.used.load(std::memory_order_acquire))
+                merge(out, slot.event, slot.file, slot.line, slot.type, slot.count.load(std::memory_order_relaxed));
+        }
+        for (size_t kind = 0; kind < event_kinds; ++kind) {
+            const uint64_t dropped = overflow[kind].load(std::memory_order_relaxed);
+            if (dropped != 0)
+                merge(out, static_cast<Event>(kind), nullptr, 0, "", dropped);
+        }
+    }
+
+    Slot slots[capacity];
+    std::atomic<uint64_t> overflow[event_kinds] = {};
+    ThreadCounters* next = nullptr;
+};
+
+// Tables of live threads, counts of exited ones are folded into retired. Lock is taken only when a thread
+// records its first event, when it exits and by snapshot().
+struct Registry {
+    static Registry& instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // Tables come straight from malloc, so telemetry does not show up in accounting of operator new
+    ThreadCounters* attach() noexcept(true)
+    {
+        void* mem = std::malloc(sizeof(ThreadCounters));
+        if (mem == nullptr)
+            return nullptr;
+        ThreadCounters* counters = ::new (mem) ThreadCounters();
+        std::lock_guard<std::mutex> lock(mutex);
+        counters->next = live;
+        live = counters;
+        return counters;
+    }
+
+    void detach(ThreadCounters* counters)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ThreadCounters** link = &live;
+            while (*link != counters)
+                link = &(*link)->next;
+            *link = counters->next;
+            counters->collect(retired);
+        }
+        counters->~ThreadCounters();
+        std::free(counters);
+    }
+
+    std::vector<Record> snapshot()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Record> out = retired;
+        for (const ThreadCounters* counters = live; counters != nullptr; counters = counters->next)
+            counters->collect(out);
+        return out;
+    }
+
+    std::mutex mutex;
+    ThreadCounters* live = nullptr;
+    std::vector<Record> retired;
+};
+
+struct ThreadHandle {
+    ThreadHandle() noexcept(true) : registry(Registry::instance()), counters(registry.attach()) {}
+    ThreadHandle(const ThreadHandle&) = delete;
+    ThreadHandle& operator=(const ThreadHandle&) = delete;
+    ~ThreadHandle()
+    {
+        if (counters != nullptr)
+            registry.detach(counters);
+    }
+
+    Registry& registry;
+    ThreadCounters* counters;
+};
+}  // namespace detail
+
+// Counts event against site in the table of the current thread, calls from inside the library pass empty site
+inline void record(Event event, Callsite site, const char* type) noexcept(true)
+{
+    if (site.file == nullptr)
+        return;
+    thread_local detail::ThreadHandle handle;
+    if (handle.counters != nullptr)
+        handle.counters->add(event, site, type);
+}
+
+template <typename ErrorType>
+constexpr bool note_failure(Callsite site) noexcept(true)
+{
+    return RESULT_TELEMETRY_CONSTANT_EVALUATED() || (record(Event::Failure, site, type_name<ErrorType>()), true);
+}
+
+// Counts of all threads, including exited ones, merged by event, callsite and type
+inline std::vector<Record> snapshot() { return detail::Registry::instance().snapshot(); }
+}  // namespace telemetry
+}  // namespace Result
@@ -0,0 +1,411 @@
+#pragma once
+#include "result.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace Result
+{
+namespace detail
+{
+constexpr size_t word_bits = 64;
+
+inline size_t words_for(size_t count) noexcept(true) { return (count + word_bits - 1) / word_bits; }
+
+inline unsigned popcount64(uint64_t word) noexcept(true)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<unsigned>(__popcnt64(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<unsigned>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Index of the lowest set bit, word can not be zero
+inline unsigned countr_zero64(uint64_t word) noexcept(true)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx = 0;
+    _BitScanForward64(&idx, word);
+    return static_cast<unsigned>(idx);
+#else
+    unsigned idx = 0;
+    for (; (word & 1U) == 0; word >>= 1)
+        ++idx;
+    return idx;
+#endif
+}
+}  // namespace detail
+
+// Indices of set bits (or cleared ones when Set is false) in a packed bitmask of given size.
+// Whole words are skipped at once, so sparse masks are walked in size / 64 steps.
+template <bool Set>
+struct BitIndexRange {
+    struct iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const size_t*;
+        using reference = size_t;
+
+        iterator() noexcept(true) = default;
+        iterator(const uint64_t* words, size_t size, size_t word_idx) noexcept(true)
+            : _words(words), _size(size), _word_idx(word_idx)
+        {
+            if (_word_idx < detail::words_for(_size)) {
+                _current = load(_word_idx);
+                skip_empty();
+            }
+        }
+
+        size_t operator*() const noexcept(true)
+        {
+            return _word_idx * detail::word_bits + detail::countr_zero64(_current);
+        }
+
+        iterator& operator++() noexcept(true)
+        {
+            _current &= _current - 1;
+            skip_empty();
+            return *this;
+        }
+
+        iterator operator++(int) noexcept(true)
+        {
+            iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const iterator& other) const noexcept(true)
+        {
+            return _word_idx == other._word_idx && _current == other._current;
+        }
+        bool operator!=(const iterator& other) const noexcept(true) { return !(*this == other); }
+
+    private:
+        uint64_t load(size_t idx) const noexcept(true)
+        {
+            uint64_t word = Set ? _words[idx] : ~_words[idx];
+            const size_t tail = _size % detail::word_bits;
+            if (tail != 0 && idx + 1 == detail::words_for(_size))
+                word &= (uint64_t{1} << tail) - 1;
+            return word;
+        }
+
+        void skip_empty() noexcept(true)
+        {
+            const size_t count = detail::words_for(_size);
+            while (_current == 0 && ++_word_idx < count)
+                _current = load(_word_idx);
+        }
+
+        const uint64_t* _words = nullptr;
+        size_t _size = 0;
+        size_t _word_idx = 0;
+        uint64_t _current = 0;
+    };
+
+    BitIndexRange(const uint64_t* words, size_t size) noexcept(true) : _words(words), _size(size) {}
+
+    iterator begin() const noexcept(true) { return iterator(_words, _size, 0); }
+    iterator end() const noexcept(true) { return iterator(_words, _size, detail::words_for(_size)); }
+
+private:
+    const uint64_t* _words;
+    size_t _size;
+};
+
+// Batch of results kept as structure of arrays: values of ok elements and errors of failed ones are stored
+// in two dense vectors in insertion order, state of each element is one bit of a packed mask. Element i maps
+// to values()[rank] where rank is number of ok elements before it, computed from per word prefix counts.
+// Container is append only, so counts, all_ok() and first_error() are maintained during insertion.
+template <typename Value, typename ErrorType = SimpleError, typename BadAccess = DefaultBadAccess>
+struct ResultVector {
+public:
+    using ok_t = Value;
+    using err_t = ErrorType;
+    using access_t = BadAccess;
+    using expected_t = Expected<Value, ErrorType, BadAccess>;
+    static_assert(!std::is_reference<ok_t>::value && !std::is_reference<err_t>::value,
+                  "ResultVector stores payloads by value");
+
+    // View of one element with read access like Expected, value_ptr()/error_ptr() give mutable access
+    template <bool Const>
+    struct Proxy {
+        using owner_t = typename std::conditional<Const, const ResultVector, ResultVector>::type;
+        using ok_ptr_t = typename std::conditional<Const, const ok_t*, ok_t*>::type;
+        using err_ptr_t = typename std::conditional<Const, const err_t*, err_t*>::type;
+
+        Proxy(owner_t& owner, size_t idx) noexcept(true) : _owner(&owner), _idx(idx) {}
+
+        size_t index() const noexcept(true) { return _idx; }
+        bool is_ok() const noexcept(true) { return _owner->is_ok(_idx); }
+        explicit operator bool() const noexcept(true) { return is_ok(); }
+
+        ok_ptr_t value_ptr() const noexcept(true)
+        {
+            return is_ok() ? &_owner->_values[_owner->ok_rank(_idx)] : nullptr;
+        }
+
+        err_ptr_t error_ptr() const noexcept(true)
+        {
+            return is_ok() ? nullptr : &_owner->_errors[_owner->err_rank(_idx)];
+        }
+
+        template <typename Ret = ok_t, typename Access = access_t,
+                  typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+                  typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+        auto value(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(expected_t::handle_error())) -> const ok_t&
+        {
+            if (!is_ok()) {
+                expected_t::handle_error("Attempting to get ResultVector value()",
+                                         RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+                return detail::default_instance<ok_t>();
+            }
+            return *value_ptr();
+        }
+
+        template <typename Ret = ok_t, typename Access = access_t,
+                  typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+        auto value(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(expected_t::handle_error())) -> const ok_t&
+        {
+            if (!is_ok())
+                expected_t::handle_error("Attempting to get ResultVector value()",
+                                         RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return *value_ptr();
+        }
+
+        template <typename Ret = err_t, typename Access = access_t,
+                  typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+                  typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+        auto error(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(expected_t::handle_error())) -> const err_t&
+        {
+            if (is_ok()) {
+                expected_t::handle_error("Attempting to get ResultVector error()",
+                                         RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+                return detail::default_instance<err_t>();
+            }
+            return *error_ptr();
+        }
+
+        template <typename Ret = err_t, typename Access = access_t,
+                  typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+        auto error(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(expected_t::handle_error())) -> const err_t&
+        {
+            if (is_ok())
+                expected_t::handle_error("Attempting to get ResultVector error()",
+                                         RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return *error_ptr();
+        }
+
+        auto value_or(const ok_t& ret) const noexcept(true) -> const ok_t&
+        {
+            if (!is_ok())
+                return ret;
+            return *value_ptr();
+        }
+
+        // Copy of the element, so combinators of Expected can be used on it
+        operator expected_t() const
+        {
+            if (is_ok())
+                return expected_t(in_place, *value_ptr());
+            return expected_t(unexpect, *error_ptr());
+        }
+
+    private:
+        owner_t* _owner;
+        size_t _idx;
+    };
+
+    using reference = Proxy<false>;
+    using const_reference = Proxy<true>;
+
+    ResultVector() = default;
+
+    // Elements are copied or, through std::move_iterator, moved from a range of Expected
+    template <typename It>
+    ResultVector(It first, It last)
+    {
+        reserve_for(first, last, typename std::iterator_traits<It>::iterator_category{});
+        for (; first != last; ++first)
+            push_back(*first);
+    }
+
+    size_t size() const noexcept(true) { return _size; }
+    bool empty() const noexcept(true) { return _size == 0; }
+
+    void reserve(size_t count)
+    {
+        _bits.reserve(detail::words_for(count));
+        _ranks.reserve(detail::words_for(count));
+        _values.reserve(count);
+    }
+
+    void clear() noexcept(true)
+    {
+        _bits.clear();
+        _ranks.clear();
+        _values.clear();
+        _errors.clear();
+        _size = 0;
+        _first_error = 0;
+    }
+
+    // Moved out Expected is reported as bad access by its error()
+    void push_back(const expected_t& val)
+    {
+        if (const ok_t* ok = val.value_ptr())
+            emplace_ok(*ok);
+        else
+            emplace_error(val.error());
+    }
+
+    void push_back(expected_t&& val)
+    {
+        if (ok_t* ok = val.value_ptr())
+            emplace_ok(std::move(*ok));
+        else
+            emplace_error(std::move(val).error());
+    }
+
+    template <typename... Args>
+    auto emplace_ok(Args&&... args) -> ok_t&
+    {
+        reserve_bit();
+        _values.emplace_back(std::forward<Args>(args)...);
+        append_bit(true);
+        return _values.back();
+    }
+
+    template <typename... Args>
+    auto emplace_error(Args&&... args) -> err_t&
+    {
+        reserve_bit();
+        _errors.emplace_back(std::forward<Args>(args)...);
+        if (_errors.size() == 1)
+            _first_error = _size;
+        append_bit(false);
+        return _errors.back();
+    }
+
+    bool is_ok(size_t idx) const noexcept(true)
+    {
+        return ((_bits[idx / detail::word_bits] >> (idx % detail::word_bits)) & 1U) != 0;
+    }
+
+    reference operator[](size_t idx) noexcept(true) { return reference(*this, idx); }
+    const_reference operator[](size_t idx) const noexcept(true) { return const_reference(*this, idx); }
+
+    size_t count_ok() const noexcept(true) { return _values.size(); }
+    size_t count_error() const noexcept(true) { return _errors.size(); }
+    bool all_ok() const noexcept(true) { return _errors.empty(); }
+    // Index of first failed element, size() when there is none
+    size_t first_error() const noexcept(true) { return _errors.empty() ? _size : _first_error; }
+
+    BitIndexRange<true> ok_indices() const noexcept(true) { return BitIndexRange<true>(_bits.data(), _size); }
+    BitIndexRange<false> error_indices() const noexcept(true) { return BitIndexRange<false>(_bits.data(), _size); }
+
+    // Dense payloads in order of their elements
+    const std::vector<ok_t>& values() const noexcept(true) { return _values; }
+    const std::vector<err_t>& errors() const noexcept(true) { return _errors; }
+
+    // f(index, value) for every ok element, payloads are walked sequentially
+    template <typename F>
+    void for_each_ok(F&& f)
+    {
+        size_t pos = 0;
+        for (size_t idx : ok_indices())
+            f(idx, _values[pos++]);
+    }
+
+    template <typename F>
+    void for_each_ok(F&& f) const
+    {
+        size_t pos = 0;
+        for (size_t idx : ok_indices())
+            f(idx, _values[pos++]);
+    }
+
+    template <typename F>
+    void for_each_error(F&& f)
+    {
+        size_t pos = 0;
+        for (size_t idx : error_indices())
+            f(idx, _errors[pos++]);
+    }
+
+    template <typename F>
+    void for_each_error(F&& f) const
+    {
+        size_t pos = 0;
+        for (size_t idx : error_indices())
+            f(idx, _errors[pos++]);
+    }
+
+private:
+    template <typename It>
+    void reserve_for(It first, It last, std::forward_iterator_tag)
+    {
+        reserve(static_cast<size_t>(std::distance(first, last)));
+    }
+
+    template <typename It>
+    void reserve_for(It, It, std::input_iterator_tag)
+    {
+    }
+
+    // Room for the next bit is made before payload is constructed, so a throwing allocation leaves no trace
+    void reserve_bit()
+    {
+        if (_size % detail::word_bits == 0 &&
+            (_bits.size() == _bits.capacity() || _ranks.size() == _ranks.capacity())) {
+            _bits.reserve(_bits.size() * 2 + 1);
+            _ranks.reserve(_bits.size() * 2 + 1);
+        }
+    }
+
+    void append_bit(bool ok) noexcept(true)
+    {
+        if (_size % detail::word_bits == 0) {
+            _bits.push_back(0);
+            _ranks.push_back(_values.size() - (ok ? 1 : 0));
+        }
+        if (ok)
+            _bits.back() |= uint64_t{1} << (_size % detail::word_bits);
+        ++_size;
+    }
+
+    size_t ok_rank(size_t idx) const noexcept(true)
+    {
+        const size_t word = idx / detail::word_bits;
+        const uint64_t below = (uint64_t{1} << (idx % detail::word_bits)) - 1;
+        return _ranks[word] + detail::popcount64(_bits[word] & below);
+    }
+
+    size_t err_rank(size_t idx) const noexcept(true) { return idx - ok_rank(idx); }
+
+    std::vector<uint64_t> _bits;
+    std::vector<size_t> _ranks;
+    std::vector<ok_t> _values;
+    std::vector<err_t> _errors;
+    size_t _size = 0;
+    size_t _first_error = 0;
+};
+}  // namespace Result
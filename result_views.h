@@ -0,0 +1,342 @@
+#pragma once
+#include "result.h"
+
+// Lazy views over streams of Expected (C++20 ranges), nothing is collected into vectors:
+//     auto records = Result::views::generate_until_error([&] { return read_line(f_ptr); }) |
+//                    std::views::transform(parse) | Result::views::take_while_ok;
+//     for (Record& rec : records)
+//         store(std::move(rec));
+//     if (const ParseError* err = records.error_ptr())
+//         report(*err);
+// Views hand out references to the payload of the current element, payload is moved only by the consumer, so it
+// moves through a pipeline once. Views are single pass (input ranges) and can not be copied, error which ended the
+// iteration is kept by the view. Pipe std::ranges::ref_view(view) to ask a view in the middle of a pipeline.
+
+#if defined(__has_include)
+#if __has_include(<ranges>)
+#include <ranges>
+#endif
+#endif
+
+#if defined(__cpp_lib_ranges)
+#define RESULT_HAS_RANGES 1
+#endif
+
+#if defined(RESULT_HAS_RANGES)
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace Result
+{
+namespace detail
+{
+template <typename T>
+concept expected_type = is_expected<std::remove_cvref_t<T>>::value;
+
+template <typename R>
+concept expected_range = std::ranges::input_range<R> && expected_type<std::ranges::range_reference_t<R>>;
+
+// Member of Expected with value category and constness of the reference to Expected
+template <typename ExpRef, typename Member>
+using member_ref_t = typename std::conditional<
+    std::is_lvalue_reference<ExpRef>::value,
+    typename std::conditional<std::is_const<std::remove_reference_t<ExpRef>>::value, const Member&, Member&>::type,
+    Member&&>::type;
+
+// Result of a call built straight in its storage, so it is not moved in
+template <typename F>
+struct Deferred {
+    using result_t = std::invoke_result_t<F&>;
+
+    operator result_t() const { return std::invoke(_func); }
+
+    F& _func;
+};
+
+// Element of underlying range at current position. Elements returned by reference are used in place, prvalues are
+// kept here until the position changes.
+template <typename Ref>
+struct ElementSlot {
+    template <typename It>
+    void load(It& it)
+    {
+        auto&& elem = *it;
+        _ptr = std::addressof(elem);
+    }
+
+    Ref get() const noexcept(true) { return static_cast<Ref>(*_ptr); }
+
+    void reset() noexcept(true) {}
+
+    std::remove_reference_t<Ref>* _ptr = nullptr;
+};
+
+template <typename Ref>
+requires(!std::is_reference_v<Ref>) struct ElementSlot<Ref> {
+    template <typename It>
+    void load(It& it)
+    {
+        auto deref = [&it]() -> Ref { return *it; };
+        _value.emplace(Deferred<decltype(deref)>{deref});
+    }
+
+    Ref&& get() noexcept(true) { return std::move(*_value); }
+
+    void reset() noexcept(true) { _value.reset(); }
+
+    std::optional<Ref> _value;
+};
+
+// Function kept in a view, assignable even when lambda with captures is not
+template <typename F>
+struct MovableBox {
+public:
+    explicit MovableBox(F func) : _func(std::move(func)) {}
+    MovableBox(MovableBox&&) = default;
+    MovableBox(const MovableBox&) = default;
+
+    MovableBox& operator=(MovableBox&& other) noexcept(std::is_nothrow_move_constructible_v<F>)
+    {
+        if (this != &other)
+            _func.emplace(std::move(*other._func));
+        return *this;
+    }
+
+    MovableBox& operator=(const MovableBox& other)
+    {
+        if (this != &other)
+            _func.emplace(*other._func);
+        return *this;
+    }
+
+    F& get() noexcept(true) { return *_func; }
+
+private:
+    std::optional<F> _func;
+};
+
+enum class Select { Ok, Err, OkUntilErr };
+
+// Ok values, errors, or ok values up to the first error of a range of Expected
+template <std::ranges::view V, Select Which>
+requires expected_range<V>
+struct SelectView : std::ranges::view_interface<SelectView<V, Which>> {
+public:
+    using exp_ref_t = std::ranges::range_reference_t<V>;
+    using exp_t = std::remove_cvref_t<exp_ref_t>;
+    using ok_t = typename exp_t::ok_t;
+    using err_t = typename exp_t::err_t;
+    using slot_ref_t = decltype(std::declval<ElementSlot<exp_ref_t>&>().get());
+    using ref_t = member_ref_t<slot_ref_t, typename std::conditional<Which == Select::Err, err_t, ok_t>::type>;
+
+    struct iterator {
+        using iterator_concept = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::remove_cvref_t<ref_t>;
+
+        ref_t operator*() const { return _parent->current(); }
+
+        iterator& operator++()
+        {
+            _parent->advance();
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) { return it.at_end(); }
+
+        bool at_end() const { return _parent->done(); }
+
+        SelectView* _parent;
+    };
+
+    SelectView() requires std::default_initializable<V> = default;
+    explicit SelectView(V base) : _base(std::move(base)) {}
+    SelectView(SelectView&&) = default;
+    SelectView& operator=(SelectView&&) = default;
+
+    // Single pass, begin() is called once
+    iterator begin()
+    {
+        _it.emplace(std::ranges::begin(_base));
+        satisfy();
+        return iterator{this};
+    }
+
+    std::default_sentinel_t end() const noexcept(true) { return {}; }
+
+    // Error which stopped the iteration, nullptr when range ended without one
+    const err_t* error_ptr() const noexcept(true) requires(Which == Select::OkUntilErr)
+    {
+        return _error ? std::addressof(*_error) : nullptr;
+    }
+
+private:
+    bool done() { return _stopped || *_it == std::ranges::end(_base); }
+
+    ref_t current() { return static_cast<ref_t>(*_current); }
+
+    void advance()
+    {
+        _current = nullptr;
+        _slot.reset();
+        ++*_it;
+        satisfy();
+    }
+
+    void satisfy()
+    {
+        for (; *_it != std::ranges::end(_base); ++*_it) {
+            _slot.load(*_it);
+            if constexpr (Which == Select::Err)
+                _current = _slot.get().error_ptr();
+            else
+                _current = _slot.get().value_ptr();
+            if (_current)
+                return;
+            if constexpr (Which == Select::OkUntilErr) {
+                if (auto* err = _slot.get().error_ptr())
+                    _error.emplace(static_cast<member_ref_t<slot_ref_t, err_t>>(*err));
+                _stopped = true;
+                return;
+            }
+            _slot.reset();
+        }
+    }
+
+    V _base = V();
+    std::optional<std::ranges::iterator_t<V>> _it;
+    ElementSlot<exp_ref_t> _slot;
+    // Member selected by satisfy(), checked there so it is never null while iterator is dereferenceable
+    std::remove_reference_t<ref_t>* _current = nullptr;
+    std::optional<err_t> _error;
+    bool _stopped = false;
+};
+
+// Values returned by f() until it fails, error is kept by the view
+template <typename F>
+struct GenerateView : std::ranges::view_interface<GenerateView<F>> {
+public:
+    using exp_t = std::invoke_result_t<F&>;
+    static_assert(is_expected<exp_t>::value, "generate_until_error() function has to return Expected");
+    using ok_t = typename exp_t::ok_t;
+    using err_t = typename exp_t::err_t;
+
+    struct iterator {
+        using iterator_concept = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = ok_t;
+
+        ok_t&& operator*() const { return std::move(*_parent->_current->value_ptr()); }
+
+        iterator& operator++()
+        {
+            _parent->advance();
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) { return it.at_end(); }
+
+        bool at_end() const { return !_parent->_current->is_ok(); }
+
+        GenerateView* _parent;
+    };
+
+    explicit GenerateView(F func) : _func(std::move(func)) {}
+    GenerateView(GenerateView&&) = default;
+    GenerateView& operator=(GenerateView&&) = default;
+
+    // Single pass, begin() is called once
+    iterator begin()
+    {
+        advance();
+        return iterator{this};
+    }
+
+    std::default_sentinel_t end() const noexcept(true) { return {}; }
+
+    // Error which ended the sequence, nullptr before it is reached
+    const err_t* error_ptr() const noexcept(true) { return _current ? _current->error_ptr() : nullptr; }
+
+private:
+    void advance()
+    {
+        _current.reset();
+        _current.emplace(Deferred<F>{_func.get()});
+    }
+
+    MovableBox<F> _func;
+    std::optional<exp_t> _current;
+};
+
+template <typename F>
+struct TransformOk {
+    template <typename Exp>
+    requires expected_type<Exp>
+    auto operator()(Exp&& res) const
+    {
+        return std::forward<Exp>(res).transform(_func);
+    }
+
+    F _func;
+};
+
+template <Select Which>
+struct SelectFn
+#if defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 202202L
+    : std::ranges::range_adaptor_closure<SelectFn<Which>>
+#endif
+{
+    template <std::ranges::viewable_range R>
+    requires expected_range<std::views::all_t<R>>
+    auto operator()(R&& range) const
+    {
+        return SelectView<std::views::all_t<R>, Which>(std::views::all(std::forward<R>(range)));
+    }
+
+#if !(defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 202202L)
+    template <std::ranges::viewable_range R>
+    requires expected_range<std::views::all_t<R>>
+    friend auto operator|(R&& range, SelectFn fn)
+    {
+        return fn(std::forward<R>(range));
+    }
+#endif
+};
+}  // namespace detail
+
+namespace views
+{
+// Values of a range of Expected, errors are skipped
+inline constexpr detail::SelectFn<detail::Select::Ok> filter_ok{};
+
+// Errors of a range of Expected, values are skipped
+inline constexpr detail::SelectFn<detail::Select::Err> errors{};
+
+// Values of a range of Expected up to the first error, which is kept by the view (error_ptr())
+inline constexpr detail::SelectFn<detail::Select::OkUntilErr> take_while_ok{};
+
+// Expected with value replaced by f(value), errors are passed on
+template <typename F>
+auto transform_ok(F&& f)
+{
+    return std::views::transform(detail::TransformOk<std::decay_t<F>>{std::forward<F>(f)});
+}
+
+// Values returned by f() until it returns an error, which is kept by the view (error_ptr())
+template <typename F>
+auto generate_until_error(F&& f)
+{
+    return detail::GenerateView<std::decay_t<F>>(std::forward<F>(f));
+}
+}  // namespace views
+}  // namespace Result
+#endif
@@ -0,0 +1,255 @@
+#pragma once
+#include "result.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#endif
+#endif
+
+// Binary layout of Expected<T, E> with trivially copyable payloads, for shared memory queues and mapped files.
+// Version 1 is a 16 byte header followed by the payload of the active side:
+//     offset 0   uint32  magic 0x52455831 ("REX1") in byte order of the writer
+//     offset 4   uint8   version (1)
+//     offset 5   uint8   state, 1 value, 0 error
+//     offset 6   uint16  payload offset, 16 rounded up to alignment of T and E
+//     offset 8   uint32  sizeof(T)
+//     offset 12  uint32  sizeof(E)
+// Buffer has to be aligned to wire_alignment<T, E>(), so ExpectedView reads payload in place:
+//     Result::encode(res, slot, sizeof(slot));
+//     auto view = Result::ExpectedView<Quote, FeedError>::from(slot, sizeof(slot));
+//     if (view && view.value().is_ok())
+//         use(view.value().value());
+
+namespace Result
+{
+enum class WireError : uint8_t {
+    BufferTooSmall,
+    Misaligned,
+    BadMagic,
+    ForeignEndianness,
+    UnsupportedVersion,
+    TypeMismatch,
+    BadState,  // state byte is neither value nor error
+    MovedFrom  // encoded Expected was moved out
+};
+
+constexpr uint32_t wire_magic = 0x52455831U;
+constexpr uint8_t wire_version = 1;
+constexpr size_t wire_header_size = 16;
+
+template <typename T, typename E>
+constexpr size_t wire_alignment() noexcept(true)
+{
+    return alignof(T) > alignof(E) ? (alignof(T) > alignof(uint32_t) ? alignof(T) : alignof(uint32_t))
+                                   : (alignof(E) > alignof(uint32_t) ? alignof(E) : alignof(uint32_t));
+}
+
+template <typename T, typename E>
+constexpr size_t wire_payload_offset() noexcept(true)
+{
+    return (wire_header_size + wire_alignment<T, E>() - 1) / wire_alignment<T, E>() * wire_alignment<T, E>();
+}
+
+// Bytes needed by any encoded Expected<T, E>, e.g. size of a queue slot
+template <typename T, typename E>
+constexpr size_t wire_size() noexcept(true)
+{
+    return wire_payload_offset<T, E>() + size_of<T, E>();
+}
+
+namespace detail
+{
+template <typename T, typename E>
+struct WireTraits {
+    static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_copyable<E>::value,
+                  "binary layout is defined only for trivially copyable payloads");
+    static_assert(!std::is_reference<T>::value && !std::is_reference<E>::value,
+                  "binary layout can not carry references");
+    static_assert(wire_payload_offset<T, E>() <= UINT16_MAX, "payload alignment is too big for binary layout");
+};
+
+inline bool aligned_to(const void* ptr, size_t align) noexcept(true)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % align == 0;
+}
+
+inline uint32_t load_u32(const unsigned char* ptr) noexcept(true)
+{
+    uint32_t val;
+    std::memcpy(&val, ptr, sizeof(val));
+    return val;
+}
+
+inline uint32_t byte_swap(uint32_t val) noexcept(true)
+{
+    return (val >> 24U) | ((val >> 8U) & 0xFF00U) | ((val << 8U) & 0xFF0000U) | (val << 24U);
+}
+}  // namespace detail
+
+// Writes res into buffer, returns number of bytes written
+template <typename T, typename E, typename A>
+auto encode(const Expected<T, E, A>& res, unsigned char* buffer, size_t size) noexcept(true)
+    -> Expected<size_t, WireError>
+{
+    static_cast<void>(detail::WireTraits<T, E>{});
+    constexpr size_t offset = wire_payload_offset<T, E>();
+    // Pointers are null on the moved out side
+    const T* val = res.value_ptr();
+    const E* err = res.error_ptr();
+    if (val == nullptr && err == nullptr)
+        return Error(WireError::MovedFrom);
+    const size_t total = offset + (val != nullptr ? sizeof(T) : sizeof(E));
+    if (size < total)
+        return Error(WireError::BufferTooSmall);
+    if (!detail::aligned_to(buffer, wire_alignment<T, E>()))
+        return Error(WireError::Misaligned);
+
+    const uint32_t sizes[2] = {static_cast<uint32_t>(sizeof(T)), static_cast<uint32_t>(sizeof(E))};
+    const uint16_t payload_offset = static_cast<uint16_t>(offset);
+    std::memcpy(buffer, &wire_magic, sizeof(wire_magic));
+    buffer[4] = wire_version;
+    buffer[5] = val != nullptr ? 1 : 0;
+    std::memcpy(buffer + 6, &payload_offset, sizeof(payload_offset));
+    std::memcpy(buffer + 8, sizes, sizeof(sizes));
+    if (val != nullptr)
+        std::memcpy(buffer + offset, val, sizeof(T));
+    else
+        std::memcpy(buffer + offset, err, sizeof(E));
+    return Ok(total);
+}
+
+// Expected<T, E> read in place from encoded bytes, valid as long as the buffer is
+template <typename T, typename E, typename BadAccess = DefaultBadAccess>
+struct ExpectedView {
+public:
+    using ok_t = T;
+    using err_t = E;
+    using access_t = BadAccess;
+    using expected_t = Expected<T, E, BadAccess>;
+
+    // Checks header and alignment of data, nothing is copied. View has no default instance, so value() of
+    // failed check terminates.
+    static auto from(const unsigned char* data, size_t size) noexcept(true)
+        -> Expected<ExpectedView, WireError, BadAccessTerminate>
+    {
+        static_cast<void>(detail::WireTraits<T, E>{});
+        if (size < wire_header_size)
+            return Error(WireError::BufferTooSmall);
+        const uint32_t magic = detail::load_u32(data);
+        if (magic == detail::byte_swap(wire_magic))
+            return Error(WireError::ForeignEndianness);
+        if (magic != wire_magic)
+            return Error(WireError::BadMagic);
+        if (data[4] != wire_version)
+            return Error(WireError::UnsupportedVersion);
+        if (data[5] > 1)
+            return Error(WireError::BadState);
+        uint16_t offset;
+        std::memcpy(&offset, data + 6, sizeof(offset));
+        if (offset != wire_payload_offset<T, E>() || detail::load_u32(data + 8) != sizeof(T) ||
+            detail::load_u32(data + 12) != sizeof(E))
+            return Error(WireError::TypeMismatch);
+        if (!detail::aligned_to(data, wire_alignment<T, E>()))
+            return Error(WireError::Misaligned);
+        if (size < offset + (data[5] == 1 ? sizeof(T) : sizeof(E)))
+            return Error(WireError::BufferTooSmall);
+        return Ok(ExpectedView(data));
+    }
+
+#if defined(__cpp_lib_span)
+    static auto from(std::span<const std::byte> bytes) noexcept(true)
+        -> Expected<ExpectedView, WireError, BadAccessTerminate>
+    {
+        return from(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+    }
+#endif
+
+    bool is_ok() const noexcept(true) { return _data[5] == 1; }
+    explicit operator bool() const noexcept(true) { return is_ok(); }
+
+    // Payload lives in the buffer, it was written there as bytes of T or E by encode()
+    const ok_t* value_ptr() const noexcept(true)
+    {
+        return is_ok() ? reinterpret_cast<const ok_t*>(_data + wire_payload_offset<T, E>()) : nullptr;
+    }
+
+    const err_t* error_ptr() const noexcept(true)
+    {
+        return is_ok() ? nullptr : reinterpret_cast<const err_t*>(_data + wire_payload_offset<T, E>());
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    auto value(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(expected_t::handle_error())) -> const ok_t&
+    {
+        if (!is_ok()) {
+            expected_t::handle_error("Attempting to get ExpectedView value()",
+                                     RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return detail::default_instance<ok_t>();
+        }
+        return *value_ptr();
+    }
+
+    template <typename Ret = ok_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    auto value(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(expected_t::handle_error())) -> const ok_t&
+    {
+        if (!is_ok())
+            expected_t::handle_error("Attempting to get ExpectedView value()",
+                                     RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return *value_ptr();
+    }
+
+    template <typename Ret = err_t, typename Access = access_t,
+              typename std::enable_if<detail::recovers_from_bad_access<Access>::value, bool>::type = true,
+              typename std::enable_if<std::is_default_constructible<Ret>::value, bool>::type = true>
+    auto error(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(expected_t::handle_error())) -> const err_t&
+    {
+        if (is_ok()) {
+            expected_t::handle_error("Attempting to get ExpectedView error()",
+                                     RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+            return detail::default_instance<err_t>();
+        }
+        return *error_ptr();
+    }
+
+    template <typename Ret = err_t, typename Access = access_t,
+              typename std::enable_if<!detail::recovers_from_bad_access<Access>::value, bool>::type = true>
+    auto error(RESULT_TELEMETRY_SITE_PARAM) const noexcept(noexcept(expected_t::handle_error())) -> const err_t&
+    {
+        if (is_ok())
+            expected_t::handle_error("Attempting to get ExpectedView error()",
+                                     RESULT_RETURN_ADDRESS() RESULT_TELEMETRY_AND_SITE);
+        return *error_ptr();
+    }
+
+    // Copy out of the buffer, so combinators of Expected can be used on it
+    operator expected_t() const noexcept(true)
+    {
+        if (is_ok())
+            return expected_t(in_place, *value_ptr());
+        return expected_t(unexpect, *error_ptr());
+    }
+
+private:
+    explicit ExpectedView(const unsigned char* data) noexcept(true) : _data(data) {}
+
+    const unsigned char* _data;
+};
+
+#if defined(__cpp_lib_span)
+template <typename T, typename E, typename A>
+auto encode(const Expected<T, E, A>& res, std::span<std::byte> buffer) noexcept(true)
+    -> Expected<size_t, WireError>
+{
+    return encode(res, reinterpret_cast<unsigned char*>(buffer.data()), buffer.size());
+}
+#endif
+}  // namespace Result
@@ -6,6 +6,11 @@ enum class ResultCode { Any };
 
 enum ResultEnumCode { Any };
 
+#if defined(FAIL_ERROR_MAP_NOT_COVERED)
+enum class StoreError { Timeout, Constraint, Missing };
+RESULT_MAP_ERRORS(StoreError, ErrorCode, {{StoreError::Timeout, ErrorCode::Any}, {StoreError::Missing, ErrorCode::Any}});
+#endif
+
 struct NonDefaultConstructible {
     NonDefaultConstructible(int val) : _val(val) {}
     int get() const { return _val; }
@@ -98,4 +103,11 @@ int main()
 #if defined(FAIL_DISCARD_FAIL)
     Result::Error();
 #endif
+#if defined(FAIL_TRY_WRONG_ERROR_TYPE)
+    auto parse = []() -> Result::Expected<int, ErrorCode> {
+        RESULT_TRY(Result::Expected<int, ResultCode>(Result::Error(ResultCode::Any)));
+        return Result::Ok(1);
+    };
+    parse();
+#endif
 }